@@ -0,0 +1,338 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "autotile.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AUTOTILE_X86 1
+#include <immintrin.h>
+#endif
+
+#define AUTOTILE_SPAN 256             // Cells per kernel call; the masks live on the stack
+#define AUTOTILE_BENCH_PAINTS 100000
+#define AUTOTILE_CORNERS (AUTOTILE_NE | AUTOTILE_SE | AUTOTILE_SW | AUTOTILE_NW)
+
+// --- Rules ---
+int autotile_reduce_mask(int mask, AutotileMode mode) {
+    int edges = mask & ~AUTOTILE_CORNERS & 0xFF;
+    if (mode == AUTOTILE_4) return edges;
+    int corners = 0;
+    if ((mask & AUTOTILE_NE) && (mask & AUTOTILE_N) && (mask & AUTOTILE_E)) corners |= AUTOTILE_NE;
+    if ((mask & AUTOTILE_SE) && (mask & AUTOTILE_S) && (mask & AUTOTILE_E)) corners |= AUTOTILE_SE;
+    if ((mask & AUTOTILE_SW) && (mask & AUTOTILE_S) && (mask & AUTOTILE_W)) corners |= AUTOTILE_SW;
+    if ((mask & AUTOTILE_NW) && (mask & AUTOTILE_N) && (mask & AUTOTILE_W)) corners |= AUTOTILE_NW;
+    return edges | corners;
+}
+
+void autotile_default_rules(AutotileRules* rules, const Tileset* tileset, AutotileMode mode) {
+    // Tiles of one terrain are numbered by the rank of their reduced mask: 16 or 47 of them
+    int rank[256], per_terrain = 0;
+    for (int mask = 0; mask < 256; mask++) {
+        if (autotile_reduce_mask(mask, mode) == mask) rank[mask] = per_terrain++;
+    }
+
+    int cells = tileset->cols * tileset->rows;
+    rules->mode = mode;
+    rules->terrain_count = cells / per_terrain;
+    if (rules->terrain_count > AUTOTILE_MAX_TERRAINS) rules->terrain_count = AUTOTILE_MAX_TERRAINS;
+    if (rules->terrain_count < 1) rules->terrain_count = 1;
+    for (int t = 0; t < AUTOTILE_MAX_TERRAINS; t++) {
+        int terrain = t < rules->terrain_count ? t : rules->terrain_count - 1;
+        for (int mask = 0; mask < 256; mask++) {
+            int index = (terrain * per_terrain + rank[autotile_reduce_mask(mask, mode)]) % cells;
+            rules->tiles[t][mask].sx = (Uint8)(index % tileset->cols);
+            rules->tiles[t][mask].sy = (Uint8)(index / tileset->cols);
+        }
+    }
+}
+
+// --- Mask kernels; row[-1] and row[count] are valid ---
+static void masks_scalar(const Uint8* above, const Uint8* row, const Uint8* below, int count,
+                         int corners, Uint8* masks) {
+    for (int i = 0; i < count; i++) {
+        int c = row[i];
+        int n = above[i] == c, s = below[i] == c, e = row[i + 1] == c, w = row[i - 1] == c;
+        int mask = n | e << 2 | s << 4 | w << 6;
+        if (corners) {
+            mask |= (n & e & (above[i + 1] == c)) << 1 | (s & e & (below[i + 1] == c)) << 3 |
+                    (s & w & (below[i - 1] == c)) << 5 | (n & w & (above[i - 1] == c)) << 7;
+        }
+        masks[i] = (Uint8)mask;
+    }
+}
+
+#ifdef AUTOTILE_X86
+// Each comparison gives 0xFF per matching cell; AND with the bit's value and OR the eight together
+__attribute__((target("sse2")))
+static void masks_sse2(const Uint8* above, const Uint8* row, const Uint8* below, int count,
+                       int corners, Uint8* masks) {
+    const __m128i corner_bits = _mm_set1_epi8((char)(corners ? AUTOTILE_CORNERS : 0));
+    int i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i n = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(above + i)), c);
+        __m128i s = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(below + i)), c);
+        __m128i e = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(row + i + 1)), c);
+        __m128i w = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(row + i - 1)), c);
+        __m128i ne = _mm_and_si128(_mm_and_si128(n, e), _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(above + i + 1)), c));
+        __m128i se = _mm_and_si128(_mm_and_si128(s, e), _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(below + i + 1)), c));
+        __m128i sw = _mm_and_si128(_mm_and_si128(s, w), _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(below + i - 1)), c));
+        __m128i nw = _mm_and_si128(_mm_and_si128(n, w), _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(above + i - 1)), c));
+
+        __m128i edge = _mm_or_si128(_mm_or_si128(_mm_and_si128(n, _mm_set1_epi8(AUTOTILE_N)),
+                                                 _mm_and_si128(e, _mm_set1_epi8(AUTOTILE_E))),
+                                    _mm_or_si128(_mm_and_si128(s, _mm_set1_epi8(AUTOTILE_S)),
+                                                 _mm_and_si128(w, _mm_set1_epi8(AUTOTILE_W))));
+        __m128i corner = _mm_or_si128(_mm_or_si128(_mm_and_si128(ne, _mm_set1_epi8(AUTOTILE_NE)),
+                                                   _mm_and_si128(se, _mm_set1_epi8(AUTOTILE_SE))),
+                                      _mm_or_si128(_mm_and_si128(sw, _mm_set1_epi8(AUTOTILE_SW)),
+                                                   _mm_and_si128(nw, _mm_set1_epi8((char)AUTOTILE_NW))));
+        _mm_storeu_si128((__m128i*)(masks + i), _mm_or_si128(edge, _mm_and_si128(corner, corner_bits)));
+    }
+    masks_scalar(above + i, row + i, below + i, count - i, corners, masks + i);
+}
+
+static SDL_bool has_sse2(void) {
+    return SDL_HasSSE2();
+}
+
+__attribute__((target("avx2")))
+static void masks_avx2(const Uint8* above, const Uint8* row, const Uint8* below, int count,
+                       int corners, Uint8* masks) {
+    const __m256i corner_bits = _mm256_set1_epi8((char)(corners ? AUTOTILE_CORNERS : 0));
+    int i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(row + i));
+        __m256i n = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(above + i)), c);
+        __m256i s = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(below + i)), c);
+        __m256i e = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(row + i + 1)), c);
+        __m256i w = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(row + i - 1)), c);
+        __m256i ne = _mm256_and_si256(_mm256_and_si256(n, e), _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(above + i + 1)), c));
+        __m256i se = _mm256_and_si256(_mm256_and_si256(s, e), _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(below + i + 1)), c));
+        __m256i sw = _mm256_and_si256(_mm256_and_si256(s, w), _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(below + i - 1)), c));
+        __m256i nw = _mm256_and_si256(_mm256_and_si256(n, w), _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(above + i - 1)), c));
+
+        __m256i edge = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(n, _mm256_set1_epi8(AUTOTILE_N)),
+                                                       _mm256_and_si256(e, _mm256_set1_epi8(AUTOTILE_E))),
+                                       _mm256_or_si256(_mm256_and_si256(s, _mm256_set1_epi8(AUTOTILE_S)),
+                                                       _mm256_and_si256(w, _mm256_set1_epi8(AUTOTILE_W))));
+        __m256i corner = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(ne, _mm256_set1_epi8(AUTOTILE_NE)),
+                                                         _mm256_and_si256(se, _mm256_set1_epi8(AUTOTILE_SE))),
+                                         _mm256_or_si256(_mm256_and_si256(sw, _mm256_set1_epi8(AUTOTILE_SW)),
+                                                         _mm256_and_si256(nw, _mm256_set1_epi8((char)AUTOTILE_NW))));
+        _mm256_storeu_si256((__m256i*)(masks + i), _mm256_or_si256(edge, _mm256_and_si256(corner, corner_bits)));
+    }
+    masks_scalar(above + i, row + i, below + i, count - i, corners, masks + i);
+}
+
+static SDL_bool has_avx2(void) {
+    return SDL_HasAVX2();
+}
+#endif
+
+// Best first
+const AutotileKernel autotile_kernels[] = {
+#ifdef AUTOTILE_X86
+    { "avx2", masks_avx2, has_avx2 },
+    { "sse2", masks_sse2, has_sse2 },
+#endif
+    { "scalar", masks_scalar, NULL },
+};
+const int autotile_kernel_count = sizeof(autotile_kernels) / sizeof(autotile_kernels[0]);
+
+const AutotileKernel* autotile_select(void) {
+    for (int i = 0; i < autotile_kernel_count; i++) {
+        if (!autotile_kernels[i].supported || autotile_kernels[i].supported()) return &autotile_kernels[i];
+    }
+    return &autotile_kernels[autotile_kernel_count - 1];
+}
+
+// --- Terrain grid ---
+int autotile_create(Autotiler* autotiler, TileMap* map, int layer, const AutotileRules* rules) {
+    memset(autotiler, 0, sizeof(*autotiler));
+    if (layer < 0 || layer >= map->layers) {
+        printf("Tile map has no layer %d to autotile\n", layer);
+        return 0;
+    }
+    autotiler->map = map;
+    autotiler->layer = layer;
+    autotiler->rules = rules;
+    autotiler->pitch = map->width + 2;
+    autotiler->terrain = calloc((size_t)autotiler->pitch * (map->height + 2), 1);
+    if (!autotiler->terrain) {
+        printf("Failed to allocate %dx%d terrain cells\n", map->width, map->height);
+        return 0;
+    }
+    return 1;
+}
+
+void autotile_free(Autotiler* autotiler) {
+    free(autotiler->terrain);
+    autotiler->terrain = NULL;
+}
+
+// Edge cells are also written to the border beside them, so out-of-map neighbours always match
+void autotile_set_terrain(Autotiler* autotiler, int x, int y, int terrain) {
+    const TileMap* map = autotiler->map;
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) return;
+    if (terrain < 0) terrain = 0;
+    if (terrain >= autotiler->rules->terrain_count) terrain = autotiler->rules->terrain_count - 1;
+
+    // Padded cells whose clamped position is (x, y): the cell itself and the borders it touches
+    int rows[3] = { y + 1, y == 0 ? 0 : -1, y == map->height - 1 ? map->height + 1 : -1 };
+    int cols[3] = { x + 1, x == 0 ? 0 : -1, x == map->width - 1 ? map->width + 1 : -1 };
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            if (rows[r] < 0 || cols[c] < 0) continue;
+            autotiler->terrain[(size_t)rows[r] * autotiler->pitch + cols[c]] = (Uint8)terrain;
+        }
+    }
+}
+
+// Terrain of a jittered 8x8 grid: blocks with ragged edges
+void autotile_fill_random(Autotiler* autotiler, unsigned int seed) {
+    const TileMap* map = autotiler->map;
+    for (int y = 0; y < map->height; y++) {
+        for (int x = 0; x < map->width; x++) {
+            int jx = x + (int)(hash_cell(x >> 1, y >> 1, seed) % 5) - 2;
+            int jy = y + (int)(hash_cell(x >> 1, y >> 1, seed + 1) % 5) - 2;
+            int terrain = (int)(hash_cell(jx >> 3, jy >> 3, seed + 2) % (unsigned int)autotiler->rules->terrain_count);
+            autotile_set_terrain(autotiler, x, y, terrain);
+        }
+    }
+}
+
+// --- Retiling ---
+static void apply_rows(Autotiler* autotiler, const AutotileKernel* kernel) {
+    TileMap* map = autotiler->map;
+    const AutotileRules* rules = autotiler->rules;
+    TileEntry* tiles = tilemap_layer(map, autotiler->layer);
+    int corners = rules->mode == AUTOTILE_8;
+
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < map->height; y++) {
+        Uint8 masks[AUTOTILE_SPAN];
+        const Uint8* row = autotiler->terrain + (size_t)(y + 1) * autotiler->pitch + 1;
+        TileEntry* out = tiles + (size_t)y * map->width;
+        for (int x0 = 0; x0 < map->width; x0 += AUTOTILE_SPAN) {
+            int count = map->width - x0 < AUTOTILE_SPAN ? map->width - x0 : AUTOTILE_SPAN;
+            kernel->masks(row + x0 - autotiler->pitch, row + x0, row + x0 + autotiler->pitch, count, corners, masks);
+            for (int i = 0; i < count; i++) out[x0 + i] = rules->tiles[row[x0 + i]][masks[i]];
+        }
+    }
+
+    // Same ordering as tilemap_set_tile, for every chunk at once
+    Uint32 revision = map->revision + 1;
+    SDL_MemoryBarrierRelease();
+    for (int i = 0; i < map->chunks_x * map->chunks_y; i++) map->chunk_versions[i] = revision;
+    SDL_MemoryBarrierRelease();
+    map->revision = revision;
+}
+
+void autotile_apply_all(Autotiler* autotiler) {
+    apply_rows(autotiler, autotile_select());
+}
+
+static TileEntry tile_at(const Autotiler* autotiler, int x, int y) {
+    const Uint8* row = autotiler->terrain + (size_t)(y + 1) * autotiler->pitch + x + 1;
+    Uint8 mask;
+    masks_scalar(row - autotiler->pitch, row, row + autotiler->pitch, 1, autotiler->rules->mode == AUTOTILE_8, &mask);
+    return autotiler->rules->tiles[*row][mask];
+}
+
+// Clamped neighbours of any cell outside the 3x3 block never land on (x, y), so nothing else changes
+void autotile_paint(Autotiler* autotiler, int x, int y, int terrain) {
+    TileMap* map = autotiler->map;
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) return;
+    autotile_set_terrain(autotiler, x, y, terrain);
+    for (int ny = y - 1; ny <= y + 1; ny++) {
+        for (int nx = x - 1; nx <= x + 1; nx++) {
+            if (nx < 0 || ny < 0 || nx >= map->width || ny >= map->height) continue;
+            tilemap_set_tile(map, autotiler->layer, nx, ny, tile_at(autotiler, nx, ny));
+        }
+    }
+}
+
+// --- Benchmark: retile a map-sized layer with each kernel, then paint single cells ---
+void autotile_benchmark(const Tileset* tileset, const TileMap* map) {
+    static AutotileRules rules;
+    static const AutotileMode modes[] = { AUTOTILE_4, AUTOTILE_8 };
+    TileMap scratch;
+    if (!tilemap_create(&scratch, map->width, map->height, 1)) return;
+    size_t bytes = sizeof(TileEntry) * (size_t)map->width * map->height;
+    TileEntry* reference = malloc(bytes);
+    if (!reference) {
+        printf("Failed to allocate %dx%d reference tiles\n", map->width, map->height);
+        tilemap_destroy(&scratch);
+        return;
+    }
+
+    printf("Autotiling %dx%d tiles, full recompute per kernel, then %d single-cell paints\n",
+           map->width, map->height, AUTOTILE_BENCH_PAINTS);
+    printf("%6s %10s %10s %12s\n", "mode", "terrains", "kernel", "Mtiles/s");
+    for (int m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+        Autotiler autotiler;
+        autotile_default_rules(&rules, tileset, modes[m]);
+        if (!autotile_create(&autotiler, &scratch, 0, &rules)) break;
+        autotile_fill_random(&autotiler, 7);
+
+        // Kernels are listed best first; walking them backwards runs the scalar one first as the reference
+        for (int k = autotile_kernel_count - 1; k >= 0; k--) {
+            const AutotileKernel* kernel = &autotile_kernels[k];
+            if (kernel->supported && !kernel->supported()) continue;
+            apply_rows(&autotiler, kernel);
+            double best = 1e30;
+            for (int run = 0; run < 5; run++) {
+                Uint64 start = SDL_GetPerformanceCounter();
+                apply_rows(&autotiler, kernel);
+                double ms = seconds_since(start) * 1e3;
+                if (ms < best) best = ms;
+            }
+            int ok = 1;
+            if (k == autotile_kernel_count - 1) memcpy(reference, scratch.tiles, bytes);
+            else ok = memcmp(reference, scratch.tiles, bytes) == 0;
+            printf("%6d %10d %10s %12.1f%s\n", modes[m], rules.terrain_count, kernel->name,
+                   (double)map->width * map->height / (best * 1000.0), bench_mismatch(ok));
+        }
+
+        // Paints must leave the same layer a full recompute would
+        unsigned int seed = 3;
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < AUTOTILE_BENCH_PAINTS; i++) {
+            int x = (int)((next_random(&seed) >> 8) % (unsigned int)map->width);
+            int y = (int)((next_random(&seed) >> 8) % (unsigned int)map->height);
+            autotile_paint(&autotiler, x, y, (int)((seed >> 4) % (unsigned int)rules.terrain_count));
+        }
+        double paint_ms = seconds_since(start) * 1e3;
+        memcpy(reference, scratch.tiles, bytes);
+        autotile_apply_all(&autotiler);
+        printf("%6d %10d %10s %9.3f us per paint%s\n", modes[m], rules.terrain_count, "paint",
+               paint_ms * 1000.0 / AUTOTILE_BENCH_PAINTS,
+               bench_mismatch(memcmp(reference, scratch.tiles, bytes) == 0));
+        autotile_free(&autotiler);
+    }
+    free(reference);
+    tilemap_destroy(&scratch);
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Autotiling: a terrain type per cell, turned into tiles by neighbour rules.
+// Each cell's tile depends on which of its neighbours share its terrain,
+// packed into a bitmask (N, NE, E, SE, S, SW, W, NW from bit 0). With 4
+// neighbours only the edges count (16 tiles per terrain); with 8 a corner
+// only counts when both edges beside it match, which leaves the 47 tiles of
+// a "blob" set. Painting a cell recomputes its 3x3 neighbourhood through
+// tilemap_set_tile; autotile_apply_all rebuilds a whole layer at load time
+// with SSE2/AVX2 mask kernels, 16 or 32 cells per step.
+
+#ifndef AUTOTILE_H
+#define AUTOTILE_H
+
+#include "tilemap.h"
+
+#define AUTOTILE_MAX_TERRAINS 16
+#define AUTOTILE_EDGE_TILES 16           // Tiles per terrain with AUTOTILE_4
+#define AUTOTILE_BLOB_TILES 47           // Tiles per terrain with AUTOTILE_8
+
+enum {
+    AUTOTILE_N = 0x01, AUTOTILE_NE = 0x02, AUTOTILE_E = 0x04, AUTOTILE_SE = 0x08,
+    AUTOTILE_S = 0x10, AUTOTILE_SW = 0x20, AUTOTILE_W = 0x40, AUTOTILE_NW = 0x80
+};
+
+typedef enum {
+    AUTOTILE_4 = 4,      // Edges only
+    AUTOTILE_8 = 8       // Edges and the corners between two matching edges
+} AutotileMode;
+
+typedef struct {
+    AutotileMode mode;
+    int terrain_count;
+    TileEntry tiles[AUTOTILE_MAX_TERRAINS][256];   // Tile of each terrain for each neighbour mask
+} AutotileRules;
+
+// Row kernel: masks of `count` cells given the terrain rows above, at and below them.
+// The rows extend one cell to either side; `corners` is 0 for AUTOTILE_4
+typedef void (*AutotileMaskFunc)(const Uint8* above, const Uint8* row, const Uint8* below, int count,
+                                 int corners, Uint8* masks);
+
+typedef struct {
+    const char* name;
+    AutotileMaskFunc masks;
+    SDL_bool (*supported)(void);  // NULL when always available
+} AutotileKernel;
+
+extern const AutotileKernel autotile_kernels[];
+extern const int autotile_kernel_count;
+
+// Fastest kernel this CPU can run
+const AutotileKernel* autotile_select(void);
+
+typedef struct {
+    TileMap* map;
+    int layer;
+    const AutotileRules* rules;
+    int pitch;               // width + 2
+    Uint8* terrain;          // (width + 2) x (height + 2); the border repeats the edge cells
+} Autotiler;
+
+// Terrain t takes consecutive tileset cells from t * AUTOTILE_EDGE_TILES or t * AUTOTILE_BLOB_TILES,
+// ordered by mask value; a tileset too small for one terrain repeats its cells
+void autotile_default_rules(AutotileRules* rules, const Tileset* tileset, AutotileMode mode);
+// Reduces a full 8-neighbour mask to the one `mode` looks up
+int autotile_reduce_mask(int mask, AutotileMode mode);
+
+// Starts with terrain 0 everywhere; call autotile_apply_all once the terrain is filled in
+int autotile_create(Autotiler* autotiler, TileMap* map, int layer, const AutotileRules* rules);
+void autotile_free(Autotiler* autotiler);
+
+static inline int autotile_terrain(const Autotiler* autotiler, int x, int y) {
+    return autotiler->terrain[(size_t)(y + 1) * autotiler->pitch + x + 1];
+}
+
+// Sets a cell's terrain without touching the layer, for filling in before autotile_apply_all
+void autotile_set_terrain(Autotiler* autotiler, int x, int y, int terrain);
+// Blobs of all terrains a few tiles across
+void autotile_fill_random(Autotiler* autotiler, unsigned int seed);
+
+// Rewrites the whole layer like fill_random_tilemap: every chunk counts as edited but listeners
+// are not called, so run it before attaching any
+void autotile_apply_all(Autotiler* autotiler);
+// Sets the terrain and retiles the 3x3 cells around it through tilemap_set_tile
+void autotile_paint(Autotiler* autotiler, int x, int y, int terrain);
+
+// Prints full recompute throughput per kernel and the cost of single-cell paints
+void autotile_benchmark(const Tileset* tileset, const TileMap* map);
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "bench.h"
+#include "render.h"
+#include "blend.h"
+#include "tile_index.h"
+#include "regions.h"
+#include "pathfind.h"
+#include "raycast.h"
+#include "entities.h"
+#include "fog.h"
+#include "autotile.h"
+#include "tint.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct {
+    const char* name;
+    float start_zoom;
+    // Advance the camera and cursor for frame `frame` of `frames`
+    void (*step)(Camera* camera, int frame, int frames, int* mouse_x, int* mouse_y);
+} BenchScenario;
+
+typedef struct {
+    double frame_ms;       // draw + present
+    double draw_ms;        // CPU time spent inside the backend's draw
+    double worst_ms;
+    double draw_calls;
+    double tiles_drawn;
+    double tiles_built;
+    double bytes_streamed;
+    double vertex_bytes;
+    double vertex_memory;        // Peak over the scenario
+    int fence_waits;
+    double state_changes;
+    double state_skipped;
+} BenchTotals;
+
+// --- Scenarios ---
+static void step_pan(Camera* camera, int frame, int frames, int* mouse_x, int* mouse_y) {
+    (void)frame; (void)frames; (void)mouse_x; (void)mouse_y;
+    camera_pan(camera, -7, -5);
+}
+
+static void step_pan_slow(Camera* camera, int frame, int frames, int* mouse_x, int* mouse_y) {
+    (void)frame; (void)frames; (void)mouse_x; (void)mouse_y;
+    // A fraction of a tile per frame: most frames need no new geometry at all
+    camera_pan(camera, -1, (frame & 1) ? -1 : 0);
+}
+
+static void step_zoom(Camera* camera, int frame, int frames, int* mouse_x, int* mouse_y) {
+    (void)frame;
+    // Geometric sweep from the start zoom down to the far end of the LOD range
+    float factor = powf(0.004f / MAX_ZOOM, 1.0f / frames);
+    camera_zoom_at(camera, *mouse_x, *mouse_y, factor);
+}
+
+static void step_far(Camera* camera, int frame, int frames, int* mouse_x, int* mouse_y) {
+    (void)frame; (void)frames; (void)mouse_x; (void)mouse_y;
+    camera_pan(camera, -20, -13);
+}
+
+static void step_hover(Camera* camera, int frame, int frames, int* mouse_x, int* mouse_y) {
+    (void)frames;
+    // Camera stays put, the cursor sweeps across the window
+    *mouse_x = (frame * 3) % camera->screen_w;
+    *mouse_y = (camera->screen_h / 3 + frame) % camera->screen_h;
+}
+
+static const BenchScenario scenarios[] = {
+    { "pan",      1.0f,     step_pan },
+    { "pan-slow", 1.0f,     step_pan_slow },
+    { "zoom",     MAX_ZOOM, step_zoom },
+    { "far",      0.05f,    step_far },
+    { "hover",    1.0f,     step_hover },
+};
+static const int scenario_count = sizeof(scenarios) / sizeof(scenarios[0]);
+
+// --- Run one scenario; returns 0 if the window was closed ---
+static int bench_scenario(Renderer* renderer, const BenchScenario* scenario, const BenchOptions* options,
+                          const Tileset* tileset, const TileMap* map, FrameWriter* writer, BenchTotals* totals) {
+    Camera camera = { 0.0f, 0.0f, scenario->start_zoom, options->width, options->height };
+    camera_center(&camera, map, tileset);
+    int mouse_x = options->width / 2;
+    int mouse_y = options->height / 2;
+    DamageTracker tracker = {0};
+
+    memset(totals, 0, sizeof(*totals));
+    for (int frame = 0; frame < options->frames; frame++) {
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) return 0;
+        }
+
+        scenario->step(&camera, frame, options->frames, &mouse_x, &mouse_y);
+
+        View view;
+        FrameStats stats = {0};
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        view_compute(&view, &camera, map, tileset, mouse_x, mouse_y);
+        if (options->render_flags & RENDER_DAMAGE_TRACKING) damage_update(&tracker, &view, map);
+        renderer->backend->draw(renderer->impl, &view, &stats);
+        Uint64 t1 = SDL_GetPerformanceCounter();
+        renderer_capture(renderer, writer, 0);
+        renderer->backend->present(renderer->impl);
+        Uint64 t2 = SDL_GetPerformanceCounter();
+
+        double frame_ms = seconds_between(t0, t2) * 1e3;
+        totals->frame_ms += frame_ms;
+        totals->draw_ms += seconds_between(t0, t1) * 1e3;
+        if (frame_ms > totals->worst_ms) totals->worst_ms = frame_ms;
+        totals->draw_calls += stats.draw_calls;
+        totals->tiles_drawn += stats.tiles_drawn;
+        totals->tiles_built += stats.tiles_built;
+        totals->bytes_streamed += (double)stats.bytes_streamed;
+        totals->fence_waits += stats.fence_waits;
+        totals->vertex_bytes += (double)stats.vertex_bytes;
+        totals->state_changes += stats.state_changes;
+        totals->state_skipped += stats.state_skipped;
+        if (stats.vertex_memory > totals->vertex_memory) totals->vertex_memory = (double)stats.vertex_memory;
+    }
+    return 1;
+}
+
+int run_bench(const BenchOptions* options, const Tileset* tileset, const TileMap* map) {
+    printf("Map %dx%d, window %dx%d, %d frames per scenario%s\n",
+           map->width, map->height, options->width, options->height, options->frames,
+           (options->render_flags & RENDER_DAMAGE_TRACKING) ? ", damage tracking" : "");
+
+    // Capture time is part of frame_ms; the writer prints its own overhead summary at the end
+    FrameWriter capture, *writer = NULL;
+    if (options->capture) {
+        if (!capture_open(&capture, options->capture, options->width, options->height)) return 0;
+        writer = &capture;
+    }
+    printf("%-7s %-10s %-9s %10s %10s %10s %12s %12s %12s %10s %8s %10s %10s %9s %9s\n",
+           "backend", "path", "scenario", "frame_ms", "draw_ms", "worst_ms", "draws/frame", "tiles/frame",
+           "built/frame", "KB/frame", "waits", "vtxKB/fr", "vtxMemKB", "state/fr", "skip/fr");
+
+    int ran = 0;
+    for (int b = 0; b < renderer_backend_count; b++) {
+        const RendererBackend* backend = renderer_backends[b];
+        if (options->backend && strcmp(options->backend, backend->name) != 0) continue;
+
+        for (int p = 0; p < backend->path_count; p++) {
+            if (options->path && strcmp(options->path, backend->path_names[p]) != 0) continue;
+
+            Renderer renderer;
+            if (!renderer_open(&renderer, backend, p, options->render_flags, "Tilemap Benchmark", options->width, options->height,
+                               SDL_WINDOW_SHOWN, tileset, map)) {
+                continue;
+            }
+            if (backend->window_flags & SDL_WINDOW_OPENGL) SDL_GL_SetSwapInterval(0);
+
+            for (int s = 0; s < scenario_count; s++) {
+                const BenchScenario* scenario = &scenarios[s];
+                if (options->scenario && strcmp(options->scenario, scenario->name) != 0) continue;
+
+                BenchTotals totals;
+                if (!bench_scenario(&renderer, scenario, options, tileset, map, writer, &totals)) {
+                    renderer_capture(&renderer, writer, 1);
+                    renderer_close(&renderer);
+                    if (writer) capture_close(writer);
+                    return ran;
+                }
+                double n = options->frames;
+                printf("%-7s %-10s %-9s %10.3f %10.3f %10.3f %12.1f %12.1f %12.1f %10.1f %8d %10.1f %10.1f %9.1f %9.1f\n",
+                       backend->name, backend->path_names[p], scenario->name,
+                       totals.frame_ms / n, totals.draw_ms / n, totals.worst_ms,
+                       totals.draw_calls / n, totals.tiles_drawn / n, totals.tiles_built / n,
+                       totals.bytes_streamed / n / 1024.0, totals.fence_waits,
+                       totals.vertex_bytes / n / 1024.0, totals.vertex_memory / 1024.0,
+                       totals.state_changes / n, totals.state_skipped / n);
+                fflush(stdout);
+                ran++;
+            }
+            renderer_capture(&renderer, writer, 1);
+            renderer_close(&renderer);
+        }
+    }
+    if (writer) capture_close(writer);
+
+    if (!ran) printf("No backend/path/scenario matched\n");
+    return ran;
+}
+
+// --- Microbenchmarks ---
+typedef struct {
+    const char* name;
+    const char* description;
+    void (*run)(const Tileset* tileset, const TileMap* map);
+} Microbench;
+
+static void micro_blend(const Tileset* tileset, const TileMap* map) {
+    (void)tileset;
+    (void)map;
+    blend_benchmark();
+}
+
+static const Microbench microbenches[] = {
+    { "blend", "Premultiplied over kernels, MP/s", micro_blend },
+    { "tileindex", "Summed-area/Fenwick rectangle counts vs scan, ns", tile_index_benchmark },
+    { "regions", "Connected-region labelling Mtiles/s, incremental edits us", regions_benchmark },
+    { "paths", "Hierarchical pathfinding paths/s vs plain A*, edit cost", path_benchmark },
+    { "rays", "Line-of-sight DDA kernels, Mrays/s", ray_benchmark },
+    { "entities", "Entity update, grid culling and radix y-sort, ms/frame", entities_benchmark },
+    { "fog", "Fog-of-war region updates vs full recompute, ms", fog_benchmark },
+    { "autotile", "Neighbour-mask autotiling Mtiles/s, single-cell paints us", autotile_benchmark },
+    { "tint", "Tinted visible-set rebuilds vs plain, ms; tint edit us", tint_benchmark },
+};
+static const int microbench_count = sizeof(microbenches) / sizeof(microbenches[0]);
+
+void print_microbenches(void) {
+    for (int m = 0; m < microbench_count; m++) {
+        printf("  %-16s %s\n", microbenches[m].name, microbenches[m].description);
+    }
+}
+
+int run_microbench(const char* name, const Tileset* tileset, const TileMap* map) {
+    int ran = 0;
+    for (int m = 0; m < microbench_count; m++) {
+        if (strcmp(name, "all") != 0 && strcmp(name, microbenches[m].name) != 0) continue;
+        printf("--- %s ---\n", microbenches[m].name);
+        microbenches[m].run(tileset, map);
+        fflush(stdout);
+        ran++;
+    }
+    if (!ran) {
+        printf("Unknown microbenchmark: %s\n", name);
+        print_microbenches();
+    }
+    return ran;
+}
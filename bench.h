@@ -0,0 +1,61 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Benchmark harness: replays scripted camera scenarios against every
+// backend and path on the same map, printing one result row per run.
+// Microbenchmarks time single components (kernels, data structures)
+// without opening a window.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "tilemap.h"
+
+typedef struct {
+    const char* backend;     // NULL runs every backend
+    const char* path;        // NULL runs every path of each backend
+    const char* scenario;    // NULL runs every scenario
+    int frames;              // Frames per scenario
+    int width, height;       // Window size
+    Uint32 render_flags;     // RENDER_* flags passed to every backend
+    const char* capture;     // Record every benchmark frame to this file, or NULL
+} BenchOptions;
+
+int run_bench(const BenchOptions* options, const Tileset* tileset, const TileMap* map);
+
+// --- Shared by the modules' *_benchmark functions ---
+// Seconds between two SDL_GetPerformanceCounter readings
+static inline double seconds_between(Uint64 start, Uint64 end) {
+    return (double)(end - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static inline double seconds_since(Uint64 start) {
+    return seconds_between(start, SDL_GetPerformanceCounter());
+}
+
+// Suffix for a result row whose output disagreed with its reference
+static inline const char* bench_mismatch(int ok) {
+    return ok ? "" : "  MISMATCH";
+}
+
+// Runs the microbenchmark called `name`, or all of them for "all"; returns how many ran
+int run_microbench(const char* name, const Tileset* tileset, const TileMap* map);
+void print_microbenches(void);
+
+#endif
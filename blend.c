@@ -0,0 +1,222 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "blend.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLEND_X86 1
+#include <immintrin.h>
+#endif
+
+#define BLEND_BENCH_PIXELS (1 << 20)      // One megapixel per pass, as a span-sized working set would be
+#define BLEND_BENCH_PASSES 200
+
+static void over_scalar(Uint32* dst, const Uint32* src, int count, int alpha_shift) {
+    for (int i = 0; i < count; i++) {
+        Uint32 s = src[i];
+        Uint32 a = (s >> alpha_shift) & 0xFF;
+        if (a == 0) continue;
+        if (a == 255) {
+            dst[i] = s;
+            continue;
+        }
+
+        // Two channels per multiply; each product + 128 fits in its 16-bit half
+        Uint32 inv = 255 - a, d = dst[i];
+        Uint32 rb = (d & 0x00FF00FF) * inv + 0x00800080;
+        Uint32 ag = ((d >> 8) & 0x00FF00FF) * inv + 0x00800080;
+        rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        ag = ((ag + ((ag >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        dst[i] = s + (rb | (ag << 8));
+    }
+}
+
+#ifdef BLEND_X86
+// --- x * y / 255 on 16-bit lanes, rounded like the scalar version ---
+__attribute__((target("sse2")))
+static inline __m128i mul_div255_sse2(__m128i x, __m128i y) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+static void over_sse2(Uint32* dst, const Uint32* src, int count, int alpha_shift) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    const __m128i opaque = _mm_set1_epi32(0xFF);
+    const __m128i shift = _mm_cvtsi32_si128(alpha_shift);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i a = _mm_and_si128(_mm_srl_epi32(s, shift), byte);
+        int transparent = _mm_movemask_epi8(_mm_cmpeq_epi32(a, zero));
+        if (transparent == 0xFFFF) continue;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, opaque)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+
+        // Broadcast alpha to every byte of its pixel, then invert: ~a == 255 - a per byte
+        __m128i a4 = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+        a4 = _mm_or_si128(a4, _mm_slli_epi32(a4, 16));
+        __m128i inv = _mm_xor_si128(a4, _mm_set1_epi32(-1));
+
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = mul_div255_sse2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(inv, zero));
+        __m128i hi = mul_div255_sse2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(inv, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), s));
+    }
+    over_scalar(dst + i, src + i, count - i, alpha_shift);
+}
+
+static SDL_bool has_sse2(void) {
+    return SDL_HasSSE2();
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mul_div255_avx2(__m256i x, __m256i y) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// Unpack and pack both work within 128-bit lanes, so pixel order survives the round trip
+__attribute__((target("avx2")))
+static void over_avx2(Uint32* dst, const Uint32* src, int count, int alpha_shift) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m128i shift = _mm_cvtsi32_si128(alpha_shift);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i a = _mm256_and_si256(_mm256_srl_epi32(s, shift), byte);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero)) == -1) continue;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, byte)) == -1) {
+            _mm256_storeu_si256((__m256i*)(dst + i), s);
+            continue;
+        }
+
+        __m256i a4 = _mm256_or_si256(a, _mm256_slli_epi32(a, 8));
+        a4 = _mm256_or_si256(a4, _mm256_slli_epi32(a4, 16));
+        __m256i inv = _mm256_xor_si256(a4, _mm256_set1_epi32(-1));
+
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = mul_div255_avx2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(inv, zero));
+        __m256i hi = mul_div255_avx2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(inv, zero));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), s));
+    }
+    over_scalar(dst + i, src + i, count - i, alpha_shift);
+}
+
+static SDL_bool has_avx2(void) {
+    return SDL_HasAVX2();
+}
+#endif
+
+// Best first
+const BlendKernel blend_kernels[] = {
+#ifdef BLEND_X86
+    { "avx2", over_avx2, has_avx2 },
+    { "sse2", over_sse2, has_sse2 },
+#endif
+    { "scalar", over_scalar, NULL },
+};
+const int blend_kernel_count = sizeof(blend_kernels) / sizeof(blend_kernels[0]);
+
+const BlendKernel* blend_select(void) {
+    for (int i = 0; i < blend_kernel_count; i++) {
+        if (!blend_kernels[i].supported || blend_kernels[i].supported()) return &blend_kernels[i];
+    }
+    return &blend_kernels[blend_kernel_count - 1];
+}
+
+void blend_premultiply_rgba32(Uint32* pixels, int count) {
+    for (int i = 0; i < count; i++) {
+        Uint8* p = (Uint8*)&pixels[i];
+        Uint32 a = p[3];
+        p[0] = (Uint8)((p[0] * a + 127) / 255);
+        p[1] = (Uint8)((p[1] * a + 127) / 255);
+        p[2] = (Uint8)((p[2] * a + 127) / 255);
+    }
+}
+
+void blend_unpremultiply_rgba32(Uint32* pixels, int count) {
+    for (int i = 0; i < count; i++) {
+        Uint8* p = (Uint8*)&pixels[i];
+        Uint32 a = p[3];
+        if (a == 0 || a == 255) continue;
+        p[0] = (Uint8)((p[0] * 255 + a / 2) / a);
+        p[1] = (Uint8)((p[1] * 255 + a / 2) / a);
+        p[2] = (Uint8)((p[2] * 255 + a / 2) / a);
+    }
+}
+
+// --- Benchmark ---
+static Uint32 bench_pixel(unsigned int* seed, int alpha) {
+    Uint32 a = (Uint32)alpha;
+    Uint32 c = (next_random(seed) >> 8) % (a + 1);
+    return c | (c << 8) | (c << 16) | (a << 24);
+}
+
+void blend_benchmark(void) {
+    static const char* const inputs[] = { "opaque", "transparent", "translucent", "mixed" };
+    Uint32* src = malloc(sizeof(Uint32) * BLEND_BENCH_PIXELS);
+    Uint32* dst = malloc(sizeof(Uint32) * BLEND_BENCH_PIXELS);
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return;
+    }
+
+    printf("Premultiplied over, %d passes of %d pixels (selected kernel: %s)\n",
+           BLEND_BENCH_PASSES, BLEND_BENCH_PIXELS, blend_select()->name);
+    printf("%-8s %-12s %10s\n", "kernel", "input", "MP/s");
+
+    for (int k = blend_kernel_count - 1; k >= 0; k--) {
+        const BlendKernel* kernel = &blend_kernels[k];
+        if (kernel->supported && !kernel->supported()) continue;
+
+        for (int input = 0; input < 4; input++) {
+            // Mixed: runs of 16 pixels alternate between the three kinds, as in typical sprites
+            unsigned int seed = 1;
+            for (int i = 0; i < BLEND_BENCH_PIXELS; i++) {
+                int kind = input < 3 ? input : (i / 16) % 3;
+                int alpha = kind == 0 ? 255 : kind == 1 ? 0 : 1 + (int)((seed >> 16) % 254);
+                src[i] = bench_pixel(&seed, alpha);
+                dst[i] = bench_pixel(&seed, 255);
+            }
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int pass = 0; pass < BLEND_BENCH_PASSES; pass++) {
+                kernel->over(dst, src, BLEND_BENCH_PIXELS, 24);
+            }
+            double seconds = seconds_since(start);
+            double megapixels = (double)BLEND_BENCH_PIXELS * BLEND_BENCH_PASSES / 1e6;
+            printf("%-8s %-12s %10.1f\n", kernel->name, inputs[input], seconds > 0 ? megapixels / seconds : 0.0);
+        }
+    }
+
+    free(src);
+    free(dst);
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Premultiplied-alpha "over" kernels for software composition:
+//   dst = src + dst * (255 - src.a) / 255, on all four channels
+// Pixels are 32-bit with alpha at any byte position (`alpha_shift` bits up),
+// so one kernel serves every SDL 32-bit format. SSE2 and AVX2 versions
+// process 4 and 8 pixels per step, copying blocks that are fully opaque and
+// skipping blocks that are fully transparent; blend_select picks the best
+// one the CPU supports at runtime.
+
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <SDL2/SDL.h>
+
+typedef void (*BlendOverFunc)(Uint32* dst, const Uint32* src, int count, int alpha_shift);
+
+typedef struct {
+    const char* name;
+    BlendOverFunc over;
+    SDL_bool (*supported)(void);  // NULL when always available
+} BlendKernel;
+
+extern const BlendKernel blend_kernels[];
+extern const int blend_kernel_count;
+
+// Fastest kernel this CPU can run
+const BlendKernel* blend_select(void);
+
+// Premultiplies RGBA32 pixels in place
+void blend_premultiply_rgba32(Uint32* pixels, int count);
+// Back to straight alpha for image files; colour channels never exceed alpha in premultiplied input
+void blend_unpremultiply_rgba32(Uint32* pixels, int count);
+
+// Prints megapixels/second of every supported kernel on opaque, transparent, translucent and mixed input
+void blend_benchmark(void);
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "capture.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- RGBA rows to planar YUV 4:4:4, BT.601 studio range ---
+static void convert_y4m(const FrameWriter* writer, const unsigned char* rgba, int bottom_up) {
+    int w = writer->width, h = writer->height;
+    size_t plane = (size_t)w * h;
+    unsigned char* py = writer->planes;
+    unsigned char* pu = py + plane;
+    unsigned char* pv = pu + plane;
+
+    for (int y = 0; y < h; y++) {
+        const unsigned char* src = rgba + (size_t)(bottom_up ? h - 1 - y : y) * w * 4;
+        size_t row = (size_t)y * w;
+        for (int x = 0; x < w; x++) {
+            int r = src[x * 4], g = src[x * 4 + 1], b = src[x * 4 + 2];
+            py[row + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            pu[row + x] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            pv[row + x] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static int write_frame(FrameWriter* writer, const unsigned char* rgba, int bottom_up) {
+    int w = writer->width, h = writer->height;
+    size_t row_bytes = (size_t)w * 4;
+
+    if (writer->y4m) {
+        size_t bytes = (size_t)w * h * 3;
+        convert_y4m(writer, rgba, bottom_up);
+        if (fputs("FRAME\n", writer->file) < 0 || fwrite(writer->planes, 1, bytes, writer->file) != bytes) return 0;
+        writer->bytes += bytes + 6;
+    } else if (bottom_up) {
+        for (int y = h - 1; y >= 0; y--) {
+            if (fwrite(rgba + (size_t)y * row_bytes, 1, row_bytes, writer->file) != row_bytes) return 0;
+        }
+        writer->bytes += row_bytes * h;
+    } else {
+        if (fwrite(rgba, 1, row_bytes * h, writer->file) != row_bytes * h) return 0;
+        writer->bytes += row_bytes * h;
+    }
+    return 1;
+}
+
+static int writer_thread(void* data) {
+    FrameWriter* writer = data;
+
+    SDL_LockMutex(writer->lock);
+    for (;;) {
+        while (writer->count == 0 && !writer->closing) SDL_CondWait(writer->queued, writer->lock);
+        if (writer->count == 0) break;
+
+        int slot = writer->tail;
+        SDL_UnlockMutex(writer->lock);
+
+        // The slot is ours until tail advances, so the slow part runs unlocked
+        if (!writer->failed && !write_frame(writer, writer->slots[slot], writer->slot_bottom_up[slot])) {
+            printf("Capture: write to %s failed, discarding further frames\n", writer->path);
+            writer->failed = 1;
+        }
+
+        SDL_LockMutex(writer->lock);
+        writer->tail = (writer->tail + 1) % CAPTURE_SLOTS;
+        writer->count--;
+        writer->frames++;
+        SDL_CondSignal(writer->drained);
+    }
+    SDL_UnlockMutex(writer->lock);
+    return 0;
+}
+
+int capture_open(FrameWriter* writer, const char* path, int width, int height) {
+    memset(writer, 0, sizeof(*writer));
+    writer->path = path;
+    writer->width = width;
+    writer->height = height;
+
+    size_t len = strlen(path);
+    writer->y4m = len >= 4 && strcmp(path + len - 4, ".y4m") == 0;
+
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        printf("Capture: cannot open %s\n", path);
+        return 0;
+    }
+
+    int ok = 1;
+    for (int i = 0; i < CAPTURE_SLOTS; i++) {
+        writer->slots[i] = malloc((size_t)width * height * 4);
+        ok = ok && writer->slots[i];
+    }
+    if (writer->y4m) {
+        writer->planes = malloc((size_t)width * height * 3);
+        ok = ok && writer->planes;
+        fprintf(writer->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, CAPTURE_FPS);
+    }
+
+    writer->lock = SDL_CreateMutex();
+    writer->queued = SDL_CreateCond();
+    writer->drained = SDL_CreateCond();
+    ok = ok && writer->lock && writer->queued && writer->drained;
+    if (ok) writer->thread = SDL_CreateThread(writer_thread, "capture", writer);
+    if (!ok || !writer->thread) {
+        printf("Capture: failed to start the writer for %s\n", path);
+        capture_close(writer);
+        return 0;
+    }
+    return 1;
+}
+
+void capture_close(FrameWriter* writer) {
+    if (writer->thread) {
+        SDL_LockMutex(writer->lock);
+        writer->closing = 1;
+        SDL_CondSignal(writer->queued);
+        SDL_UnlockMutex(writer->lock);
+        SDL_WaitThread(writer->thread, NULL);
+        writer->thread = NULL;
+
+        double overhead_ms = writer->frames ?
+            writer->overhead_ticks * 1000.0 / SDL_GetPerformanceFrequency() / writer->frames : 0.0;
+        printf("Captured %d frames (%dx%d %s) to %s: %.3f ms/frame on the render thread, %d stalls, %.1f MB\n",
+               writer->frames, writer->width, writer->height, writer->y4m ? "y4m" : "rgba", writer->path,
+               overhead_ms, writer->stalls, writer->bytes / (1024.0 * 1024.0));
+    }
+
+    if (writer->file) fclose(writer->file);
+    for (int i = 0; i < CAPTURE_SLOTS; i++) free(writer->slots[i]);
+    free(writer->planes);
+    if (writer->drained) SDL_DestroyCond(writer->drained);
+    if (writer->queued) SDL_DestroyCond(writer->queued);
+    if (writer->lock) SDL_DestroyMutex(writer->lock);
+    memset(writer, 0, sizeof(*writer));
+}
+
+unsigned char* capture_acquire(FrameWriter* writer) {
+    SDL_LockMutex(writer->lock);
+    if (writer->count == CAPTURE_SLOTS) {
+        writer->stalls++;
+        while (writer->count == CAPTURE_SLOTS) SDL_CondWait(writer->drained, writer->lock);
+    }
+    unsigned char* slot = writer->slots[(writer->tail + writer->count) % CAPTURE_SLOTS];
+    SDL_UnlockMutex(writer->lock);
+    return slot;
+}
+
+void capture_submit(FrameWriter* writer, int bottom_up) {
+    SDL_LockMutex(writer->lock);
+    writer->slot_bottom_up[(writer->tail + writer->count) % CAPTURE_SLOTS] = bottom_up;
+    writer->count++;
+    SDL_CondSignal(writer->queued);
+    SDL_UnlockMutex(writer->lock);
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Frame capture to a video file. The render thread fills frame slots (via
+// the backend's capture hook, which on GL reads back through a ring of
+// pixel-pack buffers) and hands them to a writer thread that converts and
+// writes them, so disk and colour conversion never stall drawing unless the
+// writer falls CAPTURE_SLOTS frames behind.
+//
+// Files ending in .y4m get YUV4MPEG2 4:4:4 (BT.601, studio range), anything
+// else raw top-down RGBA frames.
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#define CAPTURE_SLOTS 4                   // Frames queued between the render and writer threads
+#define CAPTURE_FPS 60                    // Frame rate written to the Y4M header
+
+typedef struct {
+    const char* path;
+    FILE* file;
+    int y4m;
+    int width, height;
+    unsigned char* slots[CAPTURE_SLOTS];    // width * height * 4 RGBA each
+    int slot_bottom_up[CAPTURE_SLOTS];      // Row order of each queued frame
+    int tail, count;                        // Oldest queued slot and number queued
+    unsigned char* planes;                  // Writer-side Y4M conversion buffer
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* queued;
+    SDL_cond* drained;
+    int closing;
+    int failed;
+
+    // --- Totals for the summary ---
+    int frames;
+    int stalls;                             // Times the render thread waited for a free slot
+    Uint64 bytes;
+    Uint64 overhead_ticks;                  // Render-thread time spent in capture hooks
+} FrameWriter;
+
+int capture_open(FrameWriter* writer, const char* path, int width, int height);
+// Drains the queue, joins the writer and prints frame count, overhead and stalls
+void capture_close(FrameWriter* writer);
+
+// Render thread: a free slot for the next frame, blocking while the queue is full
+unsigned char* capture_acquire(FrameWriter* writer);
+// Queues the slot returned by the last capture_acquire; rows are bottom-up for GL readbacks
+void capture_submit(FrameWriter* writer, int bottom_up);
+
+#endif
@@ -0,0 +1,334 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "entities.h"
+#include "bench.h"
+#include "tint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define ENTITY_RADIX_BITS 11             // Three passes sort 32-bit keys
+#define ENTITY_RADIX_SIZE (1 << ENTITY_RADIX_BITS)
+#define ENTITY_PARALLEL_MIN 4096         // Fewer entities are moved and emitted on one core
+#define ENTITY_WANDER_SPEED 4.0f         // Fastest random entity, tiles per second
+#define ENTITY_BENCH_FRAMES 20
+
+int entities_create(EntityLayer* layer, const TileMap* map, int capacity) {
+    memset(layer, 0, sizeof(*layer));
+    if (capacity < 1) capacity = 1;
+    layer->map = map;
+    layer->capacity = capacity;
+    layer->cells_x = (map->width + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    layer->cells_y = (map->height + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    layer->entities = malloc(sizeof(Entity) * capacity);
+    layer->cell_start = calloc((size_t)layer->cells_x * layer->cells_y + 1, sizeof(int));
+    layer->spare = malloc(sizeof(Entity) * capacity);
+    layer->cell_of = malloc(sizeof(int) * capacity);
+    layer->visible = malloc(sizeof(int) * capacity);
+    layer->sort_items = malloc(sizeof(int) * capacity);
+    layer->sort_keys[0] = malloc(sizeof(Uint32) * capacity);
+    layer->sort_keys[1] = malloc(sizeof(Uint32) * capacity);
+    if (!layer->entities || !layer->spare || !layer->cell_start || !layer->cell_of || !layer->visible ||
+        !layer->sort_items || !layer->sort_keys[0] || !layer->sort_keys[1]) {
+        printf("Failed to allocate %d entities\n", capacity);
+        entities_free(layer);
+        return 0;
+    }
+    return 1;
+}
+
+void entities_free(EntityLayer* layer) {
+    free(layer->entities);
+    free(layer->cell_start);
+    free(layer->spare);
+    free(layer->cell_of);
+    free(layer->visible);
+    free(layer->sort_items);
+    free(layer->sort_keys[0]);
+    free(layer->sort_keys[1]);
+    memset(layer, 0, sizeof(*layer));
+}
+
+int entities_add(EntityLayer* layer, const Entity* entity) {
+    if (layer->count >= layer->capacity) return 0;
+    layer->entities[layer->count++] = *entity;
+    return 1;
+}
+
+void entities_spawn_random(EntityLayer* layer, int count, const Tileset* tileset, unsigned int* seed) {
+    const TileMap* map = layer->map;
+    int cells = tileset->cols * tileset->rows;
+    for (int i = 0; i < count && layer->count < layer->capacity; i++) {
+        float r[4];
+        for (int k = 0; k < 4; k++) {
+            r[k] = (float)((next_random(seed) >> 8) & 0xFFFF) / 65536.0f;
+        }
+        float angle = r[2] * 6.2831853f, speed = r[3] * ENTITY_WANDER_SPEED;
+        int index = (int)((*seed >> 4) % (unsigned int)cells);
+        Entity entity;
+        entity.x = r[0] * (map->width - 1);
+        entity.y = r[1] * (map->height - 1);
+        entity.vx = cosf(angle) * speed;
+        entity.vy = sinf(angle) * speed;
+        entity.sprite.sx = (Uint8)(index % tileset->cols);
+        entity.sprite.sy = (Uint8)(index / tileset->cols);
+        entities_add(layer, &entity);
+    }
+}
+
+// --- Movement and the grid ---
+static float bounce(float position, float* velocity, float last) {
+    if (position < 0.0f) {
+        position = -position;
+        *velocity = -*velocity;
+    } else if (position > last) {
+        position = 2.0f * last - position;
+        *velocity = -*velocity;
+    }
+    return position < 0.0f ? 0.0f : position > last ? last : position;
+}
+
+void entities_update(EntityLayer* layer, float seconds) {
+    const TileMap* map = layer->map;
+    float last_x = (float)(map->width - 1), last_y = (float)(map->height - 1);
+    int count = layer->count, cells_x = layer->cells_x;
+    Entity* entities = layer->entities;
+    int* cell_of = layer->cell_of;
+
+    #pragma omp parallel for schedule(static) if(count >= ENTITY_PARALLEL_MIN)
+    for (int i = 0; i < count; i++) {
+        Entity* e = &entities[i];
+        e->x = bounce(e->x + e->vx * seconds, &e->vx, last_x);
+        e->y = bounce(e->y + e->vy * seconds, &e->vy, last_y);
+        cell_of[i] = ((int)e->y / MAP_CHUNK_TILES) * cells_x + (int)e->x / MAP_CHUNK_TILES;
+    }
+
+    // Counting sort of the entities by cell. The scatter advances every start to the next cell's, so shift
+    // them back after
+    int cells = cells_x * layer->cells_y;
+    int* start = layer->cell_start;
+    memset(start, 0, sizeof(int) * (cells + 1));
+    for (int i = 0; i < count; i++) start[cell_of[i]]++;
+    for (int c = 0, sum = 0; c < cells; c++) {
+        int n = start[c];
+        start[c] = sum;
+        sum += n;
+    }
+    for (int i = 0; i < count; i++) layer->spare[start[cell_of[i]]++] = entities[i];
+    memmove(start + 1, start, sizeof(int) * cells);
+    start[0] = 0;
+    layer->entities = layer->spare;
+    layer->spare = entities;
+}
+
+// --- Culling and sorting ---
+static int entity_in_view(const Entity* e, const View* view) {
+    return e->x + 1.0f > view->min_x && e->x < view->max_x && e->y + 1.0f > view->min_y && e->y < view->max_y;
+}
+
+// LSD radix sort of layer->visible by y. Non-negative floats order like their bit patterns
+static void sort_visible(EntityLayer* layer) {
+    int n = layer->visible_count;
+    if (n < 2) return;
+    int* items[2] = { layer->visible, layer->sort_items };
+    Uint32* keys[2] = { layer->sort_keys[0], layer->sort_keys[1] };
+    for (int i = 0; i < n; i++) memcpy(&keys[0][i], &layer->entities[items[0][i]].y, sizeof(Uint32));
+
+    int from = 0;
+    for (int shift = 0; shift < 32; shift += ENTITY_RADIX_BITS) {
+        int counts[ENTITY_RADIX_SIZE] = {0};
+        const Uint32* src_keys = keys[from];
+        for (int i = 0; i < n; i++) counts[(src_keys[i] >> shift) & (ENTITY_RADIX_SIZE - 1)]++;
+        // A digit all keys share leaves the order as it is
+        if (counts[(src_keys[0] >> shift) & (ENTITY_RADIX_SIZE - 1)] == n) continue;
+        for (int d = 0, sum = 0; d < ENTITY_RADIX_SIZE; d++) {
+            int c = counts[d];
+            counts[d] = sum;
+            sum += c;
+        }
+        const int* src_items = items[from];
+        Uint32* dst_keys = keys[!from];
+        int* dst_items = items[!from];
+        for (int i = 0; i < n; i++) {
+            int slot = counts[(src_keys[i] >> shift) & (ENTITY_RADIX_SIZE - 1)]++;
+            dst_keys[slot] = src_keys[i];
+            dst_items[slot] = src_items[i];
+        }
+        from = !from;
+    }
+    layer->visible = items[from];
+    layer->sort_items = items[!from];
+}
+
+int entities_collect(EntityLayer* layer, const View* view) {
+    layer->visible_count = 0;
+    if (view->max_x <= view->min_x || view->max_y <= view->min_y) return 0;
+
+    // A sprite reaches one tile right and down of its position, so look one tile up and left
+    int cx0 = (view->min_x > 0 ? view->min_x - 1 : 0) / MAP_CHUNK_TILES;
+    int cy0 = (view->min_y > 0 ? view->min_y - 1 : 0) / MAP_CHUNK_TILES;
+    int cx1 = (view->max_x - 1) / MAP_CHUNK_TILES, cy1 = (view->max_y - 1) / MAP_CHUNK_TILES;
+    if (cx1 >= layer->cells_x) cx1 = layer->cells_x - 1;
+    if (cy1 >= layer->cells_y) cy1 = layer->cells_y - 1;
+
+    int n = 0;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        int first = layer->cell_start[cy * layer->cells_x + cx0];
+        int end = layer->cell_start[cy * layer->cells_x + cx1 + 1];    // Cells of a row are contiguous
+        for (int i = first; i < end; i++) {
+            if (entity_in_view(&layer->entities[i], view)) layer->visible[n++] = i;
+        }
+    }
+    layer->visible_count = n;
+    sort_visible(layer);
+    return n;
+}
+
+void entities_emit(const EntityLayer* layer, const Tileset* tileset, TileVertex* vertices) {
+    float tw = (float)tileset->tile_width, th = (float)tileset->tile_height;
+    float step_u = 1.0f / tileset->cols, step_v = 1.0f / tileset->rows;
+    int count = layer->visible_count;
+
+    #pragma omp parallel for schedule(static) if(count >= ENTITY_PARALLEL_MIN)
+    for (int i = 0; i < count; i++) {
+        const Entity* e = &layer->entities[layer->visible[i]];
+        float x = e->x * tw, y = e->y * th, x2 = x + tw, y2 = y + th;
+        float uv[8];
+        tile_quad_uvs(e->sprite, step_u, step_v, uv);
+        TileVertex* q = &vertices[(size_t)i * 4];
+        q[0] = (TileVertex){ x,  y,  uv[0], uv[1], TINT_WHITE };
+        q[1] = (TileVertex){ x2, y,  uv[2], uv[3], TINT_WHITE };
+        q[2] = (TileVertex){ x2, y2, uv[4], uv[5], TINT_WHITE };
+        q[3] = (TileVertex){ x,  y2, uv[6], uv[7], TINT_WHITE };
+    }
+}
+
+// --- Benchmark: a zoomed-out screen over the map centre, entities moving at 60 frames per second ---
+static int collect_by_scan(EntityLayer* layer, const View* view) {
+    int n = 0;
+    for (int i = 0; i < layer->count; i++) {
+        if (entity_in_view(&layer->entities[i], view)) layer->visible[n++] = i;
+    }
+    layer->visible_count = n;
+    sort_visible(layer);
+    return n;
+}
+
+static int visible_sorted(const EntityLayer* layer) {
+    for (int i = 1; i < layer->visible_count; i++) {
+        if (layer->entities[layer->visible[i - 1]].y > layer->entities[layer->visible[i]].y) return 0;
+    }
+    return 1;
+}
+
+// Orders each run of equal y in a y-sorted list by entity index, so lists collected in different
+// orders compare equal entry by entry
+static void order_ties(const EntityLayer* layer, int* list, int n) {
+    for (int i = 1; i < n; i++) {
+        int item = list[i], j = i;
+        float y = layer->entities[item].y;
+        while (j > 0 && layer->entities[list[j - 1]].y == y && list[j - 1] > item) {
+            list[j] = list[j - 1];
+            j--;
+        }
+        list[j] = item;
+    }
+}
+
+// Whether the scan in layer->visible found the same entities in the same order as `grid`;
+// `check` is scratch space of n entries
+static int same_visible(const EntityLayer* layer, const int* grid, int* check, int n) {
+    if (layer->visible_count != n) return 0;
+    memcpy(check, grid, sizeof(int) * n);
+    order_ties(layer, check, n);
+    order_ties(layer, layer->visible, n);
+    return memcmp(check, layer->visible, sizeof(int) * n) == 0;
+}
+
+void entities_benchmark(const Tileset* tileset, const TileMap* map) {
+    static const int counts[] = { 10000, 100000, 1000000 };
+    Camera camera = { 0.0f, 0.0f, 0.25f, SCREEN_WIDTH, SCREEN_HEIGHT };
+    camera_center(&camera, map, tileset);
+    View view;
+    view_compute(&view, &camera, map, tileset, -1, -1);
+
+    printf("Entities on %dx%d tiles, view of %dx%d tiles, %d frames per run, %d cores\n", map->width, map->height,
+           view.max_x - view.min_x, view.max_y - view.min_y, ENTITY_BENCH_FRAMES, SDL_GetCPUCount());
+    printf("%10s %9s %10s %10s %10s %10s  ms/frame\n", "entities", "visible", "update", "cull+sort", "scan+sort", "emit");
+
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        EntityLayer layer;
+        if (!entities_create(&layer, map, counts[c])) return;
+        unsigned int seed = 5;
+        entities_spawn_random(&layer, counts[c], tileset, &seed);
+        entities_update(&layer, 0.0f);        // The first grouping of a random spawn is not a typical frame
+
+        // The grid's result is kept aside while the scan overwrites layer->visible, then restored for emit
+        int* grid = malloc(sizeof(int) * 2 * (size_t)counts[c]);
+        if (!grid) {
+            entities_free(&layer);
+            return;
+        }
+        int* check = grid + counts[c];
+        TileVertex* vertices = NULL;
+        int vertex_capacity = 0, visible = 0, ok = 1;
+        double update_ms = 0.0, cull_ms = 0.0, scan_ms = 0.0, emit_ms = 0.0;
+        for (int frame = 0; frame < ENTITY_BENCH_FRAMES; frame++) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            entities_update(&layer, 1.0f / 60.0f);
+            update_ms += seconds_since(start) * 1e3;
+
+            start = SDL_GetPerformanceCounter();
+            visible = entities_collect(&layer, &view);
+            cull_ms += seconds_since(start) * 1e3;
+            ok = visible_sorted(&layer) && ok;
+            memcpy(grid, layer.visible, sizeof(int) * visible);
+
+            start = SDL_GetPerformanceCounter();
+            collect_by_scan(&layer, &view);
+            scan_ms += seconds_since(start) * 1e3;
+            ok = same_visible(&layer, grid, check, visible) && ok;
+            memcpy(layer.visible, grid, sizeof(int) * visible);
+            layer.visible_count = visible;
+
+            if (visible * 4 > vertex_capacity) {
+                TileVertex* grown = realloc(vertices, sizeof(TileVertex) * 4 * (size_t)visible);
+                if (!grown) {
+                    printf("Failed to allocate %d entity quads\n", visible);
+                    ok = 0;
+                    break;
+                }
+                vertices = grown;
+                vertex_capacity = visible * 4;
+            }
+            start = SDL_GetPerformanceCounter();
+            entities_emit(&layer, tileset, vertices);
+            emit_ms += seconds_since(start) * 1e3;
+        }
+
+        printf("%10d %9d %10.3f %10.3f %10.3f %10.3f%s\n", counts[c], visible, update_ms / ENTITY_BENCH_FRAMES,
+               cull_ms / ENTITY_BENCH_FRAMES, scan_ms / ENTITY_BENCH_FRAMES, emit_ms / ENTITY_BENCH_FRAMES,
+               bench_mismatch(ok));
+        free(vertices);
+        free(grid);
+        entities_free(&layer);
+    }
+}
@@ -0,0 +1,694 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "export.h"
+#include "bench.h"
+#include "soft_raster.h"
+#include "blend.h"
+#include <zlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <direct.h>
+#define make_directory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define make_directory(path) mkdir(path, 0755)
+#endif
+
+#define EXPORT_MAX_SIDE (1 << 28)         // Keeps row byte counts within an int
+
+// --- One band in flight: its own rasteriser tables, pixels and encoded output ---
+typedef struct {
+    SoftRaster raster;
+    Uint32* pixels;              // Band pixels in RGBA32
+    unsigned char* row;          // PNG filter byte followed by one row
+    unsigned char* packed;       // Encoded band (deflate run); unused for raw output
+    size_t packed_capacity;
+    size_t packed_size;
+    uLong adler;                 // Adler-32 of the band's filtered bytes
+    uLong filtered_bytes;
+    int rows;
+    int ok;
+} ExportWorker;
+
+typedef struct {
+    const ExportOptions* options;
+    const Tileset* tileset;
+    const TileMap* map;
+    int png;
+    int width, height;
+    int band_rows, bands;
+} ExportJob;
+
+static size_t peak_rss_bytes(void) {
+#ifdef __linux__
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) return 0;
+    char line[256];
+    unsigned long kb = 0;
+    while (fgets(line, sizeof(line), status)) {
+        if (sscanf(line, "VmHWM: %lu kB", &kb) == 1) break;
+    }
+    fclose(status);
+    return (size_t)kb * 1024;
+#else
+    return 0;
+#endif
+}
+
+// --- PNG container ---
+static void put_be32(unsigned char* out, uLong value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static int write_chunk(FILE* file, const char* type, const unsigned char* data, size_t size) {
+    unsigned char header[8], crc_bytes[4];
+    put_be32(header, (uLong)size);
+    memcpy(header + 4, type, 4);
+    uLong crc = crc32(0L, header + 4, 4);
+    if (size) crc = crc32(crc, data, (uInt)size);
+    put_be32(crc_bytes, crc);
+    return fwrite(header, 1, 8, file) == 8 && (!size || fwrite(data, 1, size, file) == size) &&
+           fwrite(crc_bytes, 1, 4, file) == 4;
+}
+
+static int write_png_header(FILE* file, int width, int height) {
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    unsigned char ihdr[13];
+    put_be32(ihdr, (uLong)width);
+    put_be32(ihdr + 4, (uLong)height);
+    ihdr[8] = 8;        // Bits per channel
+    ihdr[9] = 6;        // RGBA
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;   // Deflate, adaptive filtering, no interlace
+
+    // zlib stream header: deflate with a 32K window, no dictionary, "fastest" level hint
+    static const unsigned char zlib_header[2] = { 0x78, 0x01 };
+    return fwrite(signature, 1, 8, file) == 8 && write_chunk(file, "IHDR", ihdr, 13) &&
+           write_chunk(file, "IDAT", zlib_header, 2);
+}
+
+static int write_png_trailer(FILE* file, uLong adler) {
+    unsigned char checksum[4];
+    put_be32(checksum, adler);
+    return write_chunk(file, "IDAT", checksum, 4) && write_chunk(file, "IEND", NULL, 0);
+}
+
+// --- In-memory PNG: signature, IHDR, one IDAT holding the whole zlib stream, IEND ---
+static unsigned char* put_chunk_header(unsigned char* out, const char* type, size_t size) {
+    put_be32(out, (uLong)size);
+    memcpy(out + 4, type, 4);
+    return out + 8;
+}
+
+static unsigned char* put_chunk_crc(unsigned char* type, size_t size) {
+    put_be32(type + 4 + size, crc32(0L, type, (uInt)(size + 4)));
+    return type + 8 + size;
+}
+
+int png_encode_rgba(PngBuffer* out, const Uint32* pixels, int width, int height, int pitch) {
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if (deflateInit(&z, EXPORT_DEFLATE_LEVEL) != Z_OK) return 0;
+
+    size_t row_bytes = (size_t)width * 4;
+    size_t bound = deflateBound(&z, (uLong)((row_bytes + 1) * height));
+    size_t needed = 8 + 25 + 12 + bound + 12;
+    if (needed > out->capacity) {
+        unsigned char* data = realloc(out->data, needed);
+        if (!data) {
+            deflateEnd(&z);
+            return 0;
+        }
+        out->data = data;
+        out->capacity = needed;
+    }
+
+    unsigned char* p = out->data;
+    memcpy(p, signature, 8);
+    unsigned char* ihdr = put_chunk_header(p + 8, "IHDR", 13);
+    put_be32(ihdr, (uLong)width);
+    put_be32(ihdr + 4, (uLong)height);
+    ihdr[8] = 8;
+    ihdr[9] = 6;
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    p = put_chunk_crc(ihdr - 4, 13);
+
+    unsigned char* idat = put_chunk_header(p, "IDAT", 0);
+    z.next_out = idat;
+    z.avail_out = (uInt)bound;
+    int ok = 1;
+    for (int y = 0; y < height && ok; y++) {
+        unsigned char filter = 0;
+        z.next_in = &filter;
+        z.avail_in = 1;
+        ok = deflate(&z, Z_NO_FLUSH) == Z_OK;
+        z.next_in = (unsigned char*)(pixels + (size_t)y * pitch);
+        z.avail_in = (uInt)row_bytes;
+        ok = ok && deflate(&z, y + 1 < height ? Z_NO_FLUSH : Z_FINISH) != Z_STREAM_ERROR && z.avail_in == 0;
+    }
+    size_t compressed = bound - z.avail_out;
+    deflateEnd(&z);
+    if (!ok) return 0;
+
+    put_be32(idat - 8, (uLong)compressed);
+    p = put_chunk_crc(idat - 4, compressed);
+    p = put_chunk_crc(put_chunk_header(p, "IEND", 0) - 4, 0);
+    out->size = (size_t)(p - out->data);
+    return 1;
+}
+
+void png_buffer_free(PngBuffer* buffer) {
+    free(buffer->data);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+// --- Workers ---
+static int worker_init(ExportWorker* worker, const ExportJob* job) {
+    memset(worker, 0, sizeof(*worker));
+    if (!soft_init(&worker->raster, job->tileset, SDL_PIXELFORMAT_RGBA32, 0)) return 0;
+
+    size_t row_bytes = (size_t)job->width * 4;
+    worker->pixels = malloc(row_bytes * job->band_rows);
+    if (job->png) {
+        worker->row = malloc(row_bytes + 1);
+        // A bound for a one-shot deflate of the band, plus room for the sync flush marker
+        z_stream probe;
+        memset(&probe, 0, sizeof(probe));
+        if (deflateInit2(&probe, EXPORT_DEFLATE_LEVEL, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+            worker->packed_capacity = deflateBound(&probe, (uLong)((row_bytes + 1) * job->band_rows)) + 64;
+            deflateEnd(&probe);
+            worker->packed = malloc(worker->packed_capacity);
+        }
+    }
+    return worker->pixels && (!job->png || (worker->row && worker->packed));
+}
+
+static void worker_free(ExportWorker* worker) {
+    soft_free(&worker->raster);
+    free(worker->pixels);
+    free(worker->row);
+    free(worker->packed);
+    memset(worker, 0, sizeof(*worker));
+}
+
+// --- Filter and deflate the band's rows as one raw deflate run, ending in a sync flush
+// (or the final block for the last band) so runs can be concatenated byte-wise ---
+static int deflate_band(ExportWorker* worker, int width, int last) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if (deflateInit2(&z, EXPORT_DEFLATE_LEVEL, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return 0;
+    z.next_out = worker->packed;
+    z.avail_out = (uInt)worker->packed_capacity;
+
+    size_t row_bytes = (size_t)width * 4;
+    worker->adler = adler32(0L, Z_NULL, 0);
+    worker->filtered_bytes = 0;
+    int ok = 1;
+    for (int y = 0; y < worker->rows && ok; y++) {
+        // Filter type None: tile art repeats too irregularly for Sub/Up to pay for their cost here
+        worker->row[0] = 0;
+        memcpy(worker->row + 1, worker->pixels + (size_t)y * width, row_bytes);
+        worker->adler = adler32(worker->adler, worker->row, (uInt)(row_bytes + 1));
+        worker->filtered_bytes += (uLong)(row_bytes + 1);
+
+        z.next_in = worker->row;
+        z.avail_in = (uInt)(row_bytes + 1);
+        int flush = y + 1 < worker->rows ? Z_NO_FLUSH : last ? Z_FINISH : Z_SYNC_FLUSH;
+        int result = deflate(&z, flush);
+        ok = z.avail_in == 0 && (result == Z_OK || result == Z_STREAM_END);
+    }
+    worker->packed_size = worker->packed_capacity - z.avail_out;
+    deflateEnd(&z);
+    return ok;
+}
+
+// --- View of the whole image at full detail: the viewer's LOD would skip tiles below 8px ---
+static void export_view(View* view, const Camera* camera, const TileMap* map, const Tileset* tileset) {
+    view_compute(view, camera, map, tileset, -1, -1);
+    view->lod = 1;
+    view->start_x = view->min_x;
+    view->start_y = view->min_y;
+}
+
+static void render_band(ExportWorker* worker, const ExportJob* job, int band) {
+    int y0 = band * job->band_rows;
+    worker->rows = job->height - y0 < job->band_rows ? job->height - y0 : job->band_rows;
+
+    // Every band draws its rows of one view of the whole image, so seams match a single render
+    Camera camera = { 0.0f, 0.0f, job->options->zoom, job->width, job->height };
+    View view;
+    export_view(&view, &camera, job->map, job->tileset);
+
+    FrameStats stats = {0};
+    SoftTarget target = { worker->pixels, job->width, worker->rows, job->width, 0, y0 };
+    soft_draw(&worker->raster, &target, &view, job->map, NULL, &stats);
+    blend_unpremultiply_rgba32(worker->pixels, job->width * worker->rows);
+    worker->ok = !job->png || deflate_band(worker, job->width, band == job->bands - 1);
+}
+
+static int write_band(FILE* file, const ExportWorker* worker, const ExportJob* job) {
+    if (job->png) return write_chunk(file, "IDAT", worker->packed, worker->packed_size);
+    size_t bytes = (size_t)job->width * 4 * worker->rows;
+    return fwrite(worker->pixels, 1, bytes, file) == bytes;
+}
+
+// --- Output image size of the whole map; 0 when out of range ---
+static int export_size(const ExportOptions* options, const Tileset* tileset, const TileMap* map,
+                       int* width_out, int* height_out) {
+    double width = ceil((double)map->width * tileset->tile_width * options->zoom);
+    double height = ceil((double)map->height * tileset->tile_height * options->zoom);
+    if (options->zoom <= 0.0f || width < 1 || height < 1 || width > EXPORT_MAX_SIDE || height > EXPORT_MAX_SIDE) {
+        printf("Export size %.0fx%.0f is outside 1..%d\n", width, height, EXPORT_MAX_SIDE);
+        return 0;
+    }
+    *width_out = (int)width;
+    *height_out = (int)height;
+    return 1;
+}
+
+static int export_image(const ExportOptions* options, const Tileset* tileset, const TileMap* map) {
+    ExportJob job = { options, tileset, map, 0, 0, 0, 0, 0 };
+    size_t length = strlen(options->path);
+    job.png = length >= 4 && strcmp(options->path + length - 4, ".png") == 0;
+    if (!export_size(options, tileset, map, &job.width, &job.height)) return 0;
+    job.band_rows = EXPORT_BAND_BYTES / (job.width * 4);
+    if (job.band_rows < 1) job.band_rows = 1;
+    if (job.band_rows > job.height) job.band_rows = job.height;
+    job.bands = (job.height + job.band_rows - 1) / job.band_rows;
+
+    int worker_count = SDL_GetCPUCount();
+    if (worker_count > job.bands) worker_count = job.bands;
+    if (worker_count < 1) worker_count = 1;
+    ExportWorker* workers = calloc(worker_count, sizeof(ExportWorker));
+    FILE* file = fopen(options->path, "wb");
+    int ok = workers && file;
+    for (int w = 0; w < worker_count && ok; w++) ok = worker_init(&workers[w], &job);
+    if (!ok) printf("Export: could not open %s or allocate %d band buffers\n", options->path, worker_count);
+
+    printf("Exporting %dx%d (%.1f MP) to %s: %d bands of %d rows, %d threads\n", job.width, job.height,
+           (double)job.width * job.height / 1e6, options->path, job.bands, job.band_rows, worker_count);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    uLong adler = adler32(0L, Z_NULL, 0);
+    if (ok && job.png) ok = write_png_header(file, job.width, job.height);
+
+    // Bands are rendered a batch at a time and written in order, so memory stays at one batch
+    for (int first = 0; first < job.bands && ok; first += worker_count) {
+        int batch = job.bands - first < worker_count ? job.bands - first : worker_count;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int k = 0; k < batch; k++) render_band(&workers[k], &job, first + k);
+
+        for (int k = 0; k < batch && ok; k++) {
+            ok = workers[k].ok && write_band(file, &workers[k], &job);
+            adler = adler32_combine(adler, workers[k].adler, (z_off_t)workers[k].filtered_bytes);
+        }
+    }
+    if (ok && job.png) ok = write_png_trailer(file, adler);
+    if (file && fclose(file) != 0) ok = 0;
+    double seconds = seconds_since(start);
+
+    size_t buffer_bytes = 0;
+    for (int w = 0; workers && w < worker_count; w++) {
+        buffer_bytes += (size_t)job.width * 4 * job.band_rows + workers[w].packed_capacity;
+        worker_free(&workers[w]);
+    }
+    free(workers);
+
+    if (!ok) {
+        printf("Export to %s failed\n", options->path);
+        return 0;
+    }
+    double megapixels = (double)job.width * job.height / 1e6;
+    printf("Exported %.1f MP in %.2f s: %.1f MP/s\n", megapixels, seconds, megapixels / seconds);
+    printf("Band buffers %.1f MB, peak resident memory %.1f MB\n", buffer_bytes / 1048576.0,
+           peak_rss_bytes() / 1048576.0);
+    return 1;
+}
+
+// --- XYZ tile pyramid ---
+#define XYZ_MAX_LEVELS 21                 // 256 << 20 covers EXPORT_MAX_SIDE
+#define XYZ_TILE_PIXELS (XYZ_TILE_SIZE * XYZ_TILE_SIZE)
+#define XYZ_HASH_MAGIC 0x485A5958u        // "XYZH"
+
+typedef struct {
+    int cols, rows;          // Tiles of this level that touch the image
+    size_t first;            // Index of the level's first tile in the hash arrays
+} PyramidLevel;
+
+typedef struct {
+    Uint32 magic;
+    Uint32 tile_size;
+    Uint32 width, height;    // Deepest level image size
+    Uint64 tile_count;
+} PyramidHashHeader;
+
+typedef struct {
+    const ExportOptions* options;
+    const TileMap* map;
+    View view;                   // The whole image at the deepest level
+    int width, height;
+    int max_z;
+    int split_z;                 // Subtrees rooted here are built in parallel
+    PyramidLevel levels[XYZ_MAX_LEVELS];
+    size_t tile_count;
+    Uint64* hashes;              // Content hash per tile, 0 for empty tiles
+    Uint64* old_hashes;          // From the previous export into the same directory
+} Pyramid;
+
+typedef struct {
+    SoftRaster raster;
+    Uint32* tile;                // The split-level subtree root
+    Uint32* straight;            // Unpremultiplied copy for encoding
+    PngBuffer png;
+    size_t tile_buffers;         // Child buffers currently allocated by the recursion
+    size_t peak_tile_buffers;
+    int written, unchanged, empty;
+    int failed;
+} PyramidWorker;
+
+static Uint64 hash_pixels(const Uint32* pixels, int count) {
+    Uint64 h = 0x9E3779B97F4A7C15ull ^ (Uint64)count;
+    for (int i = 0; i + 1 < count; i += 2) {
+        h = (h ^ (pixels[i] | (Uint64)pixels[i + 1] << 32)) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    return h ? h : 1;
+}
+
+static int tile_is_blank(const Uint32* pixels) {
+    for (int i = 0; i < XYZ_TILE_PIXELS; i++) {
+        if (pixels[i]) return 0;
+    }
+    return 1;
+}
+
+static void tile_path(char* path, size_t size, const char* dir, int z, int x, int y) {
+    snprintf(path, size, "%s/%d/%d/%d.png", dir, z, x, y);
+}
+
+static int make_directories(const Pyramid* pyramid) {
+    const char* dir = pyramid->options->path;
+    char path[1024];
+    if (make_directory(dir) != 0 && errno != EEXIST) return 0;
+    for (int z = 0; z <= pyramid->max_z; z++) {
+        snprintf(path, sizeof(path), "%s/%d", dir, z);
+        if (make_directory(path) != 0 && errno != EEXIST) return 0;
+        for (int x = 0; x < pyramid->levels[z].cols; x++) {
+            snprintf(path, sizeof(path), "%s/%d/%d", dir, z, x);
+            if (make_directory(path) != 0 && errno != EEXIST) return 0;
+        }
+    }
+    return 1;
+}
+
+// --- The hash file only counts when it describes the same pyramid layout ---
+static void load_hashes(Pyramid* pyramid) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/tiles.hash", pyramid->options->path);
+    FILE* file = fopen(path, "rb");
+    if (!file) return;
+    PyramidHashHeader header;
+    if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == XYZ_HASH_MAGIC &&
+        header.tile_size == XYZ_TILE_SIZE && header.width == (Uint32)pyramid->width &&
+        header.height == (Uint32)pyramid->height && header.tile_count == pyramid->tile_count &&
+        fread(pyramid->old_hashes, sizeof(Uint64), pyramid->tile_count, file) == pyramid->tile_count) {
+        fclose(file);
+        return;
+    }
+    memset(pyramid->old_hashes, 0, sizeof(Uint64) * pyramid->tile_count);
+    fclose(file);
+}
+
+static int save_hashes(const Pyramid* pyramid) {
+    char path[1024], temp[1040];
+    snprintf(path, sizeof(path), "%s/tiles.hash", pyramid->options->path);
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    PyramidHashHeader header = { XYZ_HASH_MAGIC, XYZ_TILE_SIZE, (Uint32)pyramid->width, (Uint32)pyramid->height,
+                                 pyramid->tile_count };
+    FILE* file = fopen(temp, "wb");
+    if (!file) return 0;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(pyramid->hashes, sizeof(Uint64), pyramid->tile_count, file) == pyramid->tile_count;
+    if (fclose(file) != 0) ok = 0;
+    remove(path);
+    return ok && rename(temp, path) == 0;
+}
+
+static int write_png_tile(const char* path, PyramidWorker* worker) {
+    if (!png_encode_rgba(&worker->png, worker->straight, XYZ_TILE_SIZE, XYZ_TILE_SIZE, XYZ_TILE_SIZE)) return 0;
+    FILE* file = fopen(path, "wb");
+    if (!file) return 0;
+    int ok = fwrite(worker->png.data, 1, worker->png.size, file) == worker->png.size;
+    return fclose(file) == 0 && ok;
+}
+
+// --- Hash a finished tile and write it unless the previous export left the same content ---
+static void store_tile(Pyramid* pyramid, PyramidWorker* worker, int z, int x, int y, const Uint32* pixels) {
+    const PyramidLevel* level = &pyramid->levels[z];
+    size_t index = level->first + (size_t)y * level->cols + x;
+    char path[1024];
+    tile_path(path, sizeof(path), pyramid->options->path, z, x, y);
+
+    if (tile_is_blank(pixels)) {
+        // Viewers treat missing tiles as empty; drop one a previous export may have left
+        pyramid->hashes[index] = 0;
+        if (pyramid->old_hashes[index]) remove(path);
+        worker->empty++;
+        return;
+    }
+
+    Uint64 hash = hash_pixels(pixels, XYZ_TILE_PIXELS);
+    pyramid->hashes[index] = hash;
+    FILE* existing;
+    if (hash == pyramid->old_hashes[index] && (existing = fopen(path, "rb"))) {
+        fclose(existing);
+        worker->unchanged++;
+        return;
+    }
+
+    memcpy(worker->straight, pixels, sizeof(Uint32) * XYZ_TILE_PIXELS);
+    blend_unpremultiply_rgba32(worker->straight, XYZ_TILE_PIXELS);
+    if (!write_png_tile(path, worker)) {
+        printf("Export: writing %s failed\n", path);
+        worker->failed = 1;
+        pyramid->hashes[index] = 0;
+        return;
+    }
+    worker->written++;
+}
+
+// --- Box-filter a tile to half size into one quadrant of its parent (premultiplied, so edges stay clean) ---
+static void downsample_quadrant(Uint32* parent, int quadrant, const Uint32* child) {
+    int half = XYZ_TILE_SIZE / 2;
+    Uint32* out = parent + (size_t)(quadrant >> 1) * half * XYZ_TILE_SIZE + (quadrant & 1) * half;
+    for (int y = 0; y < half; y++) {
+        const Uint8* a = (const Uint8*)(child + (size_t)2 * y * XYZ_TILE_SIZE);
+        const Uint8* b = a + XYZ_TILE_SIZE * 4;
+        Uint8* o = (Uint8*)(out + (size_t)y * XYZ_TILE_SIZE);
+        for (int i = 0; i < half * 4; i++) {
+            int s = (i & ~3) * 2 + (i & 3);
+            o[i] = (Uint8)((a[s] + a[s + 4] + b[s] + b[s + 4] + 2) >> 2);
+        }
+    }
+}
+
+static void clear_quadrant(Uint32* parent, int quadrant) {
+    int half = XYZ_TILE_SIZE / 2;
+    Uint32* out = parent + (size_t)(quadrant >> 1) * half * XYZ_TILE_SIZE + (quadrant & 1) * half;
+    for (int y = 0; y < half; y++) memset(out + (size_t)y * XYZ_TILE_SIZE, 0, sizeof(Uint32) * half);
+}
+
+// --- Depth first, so a worker holds one child tile per level below z at a time ---
+static void build_tile(Pyramid* pyramid, PyramidWorker* worker, int z, int x, int y, Uint32* out) {
+    if (z == pyramid->max_z) {
+        FrameStats stats = {0};
+        SoftTarget target = { out, XYZ_TILE_SIZE, XYZ_TILE_SIZE, XYZ_TILE_SIZE, x * XYZ_TILE_SIZE, y * XYZ_TILE_SIZE };
+        soft_draw(&worker->raster, &target, &pyramid->view, pyramid->map, NULL, &stats);
+    } else {
+        Uint32* child = malloc(sizeof(Uint32) * XYZ_TILE_PIXELS);
+        if (!child) {
+            worker->failed = 1;
+            return;
+        }
+        worker->tile_buffers++;
+        if (worker->tile_buffers > worker->peak_tile_buffers) worker->peak_tile_buffers = worker->tile_buffers;
+
+        const PyramidLevel* below = &pyramid->levels[z + 1];
+        for (int q = 0; q < 4; q++) {
+            int cx = x * 2 + (q & 1), cy = y * 2 + (q >> 1);
+            if (cx >= below->cols || cy >= below->rows) {
+                clear_quadrant(out, q);
+                continue;
+            }
+            build_tile(pyramid, worker, z + 1, cx, cy, child);
+            downsample_quadrant(out, q, child);
+        }
+        free(child);
+        worker->tile_buffers--;
+    }
+    store_tile(pyramid, worker, z, x, y, out);
+}
+
+static int pyramid_worker_init(PyramidWorker* worker, const Tileset* tileset) {
+    memset(worker, 0, sizeof(*worker));
+    if (!soft_init(&worker->raster, tileset, SDL_PIXELFORMAT_RGBA32, 0)) return 0;
+    worker->tile = malloc(sizeof(Uint32) * XYZ_TILE_PIXELS);
+    worker->straight = malloc(sizeof(Uint32) * XYZ_TILE_PIXELS);
+    return worker->tile && worker->straight;
+}
+
+static void pyramid_worker_free(PyramidWorker* worker) {
+    soft_free(&worker->raster);
+    free(worker->tile);
+    free(worker->straight);
+    png_buffer_free(&worker->png);
+    memset(worker, 0, sizeof(*worker));
+}
+
+static int export_pyramid(const ExportOptions* options, const Tileset* tileset, const TileMap* map) {
+    Pyramid pyramid;
+    memset(&pyramid, 0, sizeof(pyramid));
+    pyramid.options = options;
+    pyramid.map = map;
+    if (!export_size(options, tileset, map, &pyramid.width, &pyramid.height)) return 0;
+
+    // The deepest level is the first whose grid covers the image
+    int side = pyramid.width > pyramid.height ? pyramid.width : pyramid.height;
+    while ((XYZ_TILE_SIZE << pyramid.max_z) < side) pyramid.max_z++;
+    for (int z = 0; z <= pyramid.max_z; z++) {
+        int scale = 1 << (pyramid.max_z - z);
+        int level_width = (pyramid.width + scale - 1) / scale;
+        int level_height = (pyramid.height + scale - 1) / scale;
+        PyramidLevel* level = &pyramid.levels[z];
+        level->cols = (level_width + XYZ_TILE_SIZE - 1) / XYZ_TILE_SIZE;
+        level->rows = (level_height + XYZ_TILE_SIZE - 1) / XYZ_TILE_SIZE;
+        level->first = pyramid.tile_count;
+        pyramid.tile_count += (size_t)level->cols * level->rows;
+    }
+
+    Camera camera = { 0.0f, 0.0f, options->zoom, pyramid.width, pyramid.height };
+    export_view(&pyramid.view, &camera, map, tileset);
+
+    // Parallel over the first level with a couple of subtrees per core
+    int worker_count = SDL_GetCPUCount();
+    if (worker_count < 1) worker_count = 1;
+    while (pyramid.split_z < pyramid.max_z &&
+           pyramid.levels[pyramid.split_z].cols * pyramid.levels[pyramid.split_z].rows < 2 * worker_count) {
+        pyramid.split_z++;
+    }
+    const PyramidLevel* split = &pyramid.levels[pyramid.split_z];
+    int tasks = split->cols * split->rows;
+    if (worker_count > tasks) worker_count = tasks;
+
+    // Levels above the split are assembled from downsampled subtree roots in one grid per level
+    const PyramidLevel* top = pyramid.split_z > 0 ? &pyramid.levels[pyramid.split_z - 1] : NULL;
+    size_t grid_tiles = top ? (size_t)top->cols * top->rows : 0;
+    Uint32* grid = top ? calloc(grid_tiles, sizeof(Uint32) * XYZ_TILE_PIXELS) : NULL;
+
+    pyramid.hashes = calloc(pyramid.tile_count, sizeof(Uint64));
+    pyramid.old_hashes = calloc(pyramid.tile_count, sizeof(Uint64));
+    PyramidWorker* workers = calloc(worker_count, sizeof(PyramidWorker));
+    int ok = pyramid.hashes && pyramid.old_hashes && workers && (!top || grid) && make_directories(&pyramid);
+    for (int w = 0; w < worker_count && ok; w++) ok = pyramid_worker_init(&workers[w], tileset);
+    if (!ok) printf("Export: could not create %s or allocate pyramid buffers\n", options->path);
+    if (ok) load_hashes(&pyramid);
+
+    printf("Exporting %dx%d (%.1f MP) as a z/x/y pyramid of %zu %dpx tiles, zoom 0..%d, to %s (%d threads)\n",
+           pyramid.width, pyramid.height, (double)pyramid.width * pyramid.height / 1e6, pyramid.tile_count,
+           XYZ_TILE_SIZE, pyramid.max_z, options->path, worker_count);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int first = 0; first < tasks && ok; first += worker_count) {
+        int batch = tasks - first < worker_count ? tasks - first : worker_count;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int k = 0; k < batch; k++) {
+            int task = first + k, x = task % split->cols, y = task / split->cols;
+            PyramidWorker* worker = &workers[k];
+            build_tile(&pyramid, worker, pyramid.split_z, x, y, worker->tile);
+            // Each subtree root fills its own quadrant of a parent, so the writes never overlap
+            if (top) downsample_quadrant(grid + ((size_t)(y / 2) * top->cols + x / 2) * XYZ_TILE_PIXELS,
+                                         (x & 1) | (y & 1) << 1, worker->tile);
+        }
+        for (int k = 0; k < batch; k++) ok = ok && !workers[k].failed;
+    }
+
+    // Finish the few small levels above the split on one thread, halving the grid in place
+    for (int z = pyramid.split_z - 1; z >= 0 && ok; z--) {
+        const PyramidLevel* level = &pyramid.levels[z];
+        for (int y = 0; y < level->rows; y++) {
+            for (int x = 0; x < level->cols; x++) {
+                store_tile(&pyramid, &workers[0], z, x, y, grid + ((size_t)y * level->cols + x) * XYZ_TILE_PIXELS);
+            }
+        }
+        if (z == 0) break;
+        const PyramidLevel* parent = &pyramid.levels[z - 1];
+        for (int y = 0; y < parent->rows; y++) {
+            for (int x = 0; x < parent->cols; x++) {
+                Uint32* out = workers[0].tile;
+                for (int q = 0; q < 4; q++) {
+                    int cx = x * 2 + (q & 1), cy = y * 2 + (q >> 1);
+                    if (cx >= level->cols || cy >= level->rows) clear_quadrant(out, q);
+                    else downsample_quadrant(out, q, grid + ((size_t)cy * level->cols + cx) * XYZ_TILE_PIXELS);
+                }
+                // Slot y * parent->cols + x never comes after a child slot still to be read
+                memcpy(grid + ((size_t)y * parent->cols + x) * XYZ_TILE_PIXELS, out, sizeof(Uint32) * XYZ_TILE_PIXELS);
+            }
+        }
+        ok = !workers[0].failed;
+    }
+    if (ok) ok = save_hashes(&pyramid);
+    double seconds = seconds_since(start);
+
+    int written = 0, unchanged = 0, empty = 0;
+    size_t buffer_bytes = grid_tiles * sizeof(Uint32) * XYZ_TILE_PIXELS + pyramid.tile_count * 2 * sizeof(Uint64);
+    for (int w = 0; workers && w < worker_count; w++) {
+        written += workers[w].written;
+        unchanged += workers[w].unchanged;
+        empty += workers[w].empty;
+        buffer_bytes += (2 + workers[w].peak_tile_buffers) * sizeof(Uint32) * XYZ_TILE_PIXELS +
+                        workers[w].png.capacity;
+        pyramid_worker_free(&workers[w]);
+    }
+    free(workers);
+    free(grid);
+    free(pyramid.hashes);
+    free(pyramid.old_hashes);
+
+    if (!ok) {
+        printf("Export to %s failed\n", options->path);
+        return 0;
+    }
+    double megapixels = (double)pyramid.width * pyramid.height / 1e6;
+    printf("%d tiles written, %d unchanged, %d empty in %.2f s: %.1f MP/s of base level\n",
+           written, unchanged, empty, seconds, megapixels / seconds);
+    printf("Tile buffers %.1f MB, peak resident memory %.1f MB\n", buffer_bytes / 1048576.0,
+           peak_rss_bytes() / 1048576.0);
+    return 1;
+}
+
+int export_map(const ExportOptions* options, const Tileset* tileset, const TileMap* map) {
+    return options->pyramid ? export_pyramid(options, tileset, map) : export_image(options, tileset, map);
+}
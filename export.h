@@ -0,0 +1,65 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+// Offline export of a whole map to one image of any size. The map is drawn
+// on the CPU by soft_raster in horizontal bands of about EXPORT_BAND_BYTES,
+// one band per thread, and finished bands are written out in order, so only
+// a batch of bands is ever in memory. For PNG every band is deflated on its
+// own thread as a sync-flushed raw deflate run; the runs concatenate into a
+// single zlib stream whose Adler-32 is combined from the per-band checksums,
+// so compression scales with the cores as well. Any other file name gets
+// raw top-down RGBA.
+//
+// The pyramid exporter writes a web-map z/x/y tree of XYZ_TILE_SIZE PNG
+// tiles instead: the deepest level is drawn from the tileset and every
+// coarser tile is a 2x2 box filter of its four children. Subtrees are built
+// depth first, one per thread, so each thread holds one tile per level; a
+// hash of every tile's pixels is kept in tiles.hash so a re-export only
+// encodes and writes the tiles whose content changed.
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "tilemap.h"
+
+#define EXPORT_BAND_BYTES (8 << 20)       // Target size of one rendered band
+#define EXPORT_DEFLATE_LEVEL 1            // zlib level; higher levels make compression the bottleneck
+#define XYZ_TILE_SIZE 256                 // Pyramid tile side in pixels, as web maps expect
+
+typedef struct {
+    const char* path;        // .png for PNG, otherwise raw RGBA; the output directory for a pyramid
+    float zoom;              // Output pixels per tileset pixel (of the deepest pyramid level)
+    int pyramid;             // Write a z/x/y tile pyramid instead of one image
+} ExportOptions;
+
+// --- A PNG file in memory; the buffer is reused and only grows ---
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+} PngBuffer;
+
+// Renders the whole map as one image or a tile pyramid and prints output MP/s and peak memory;
+// returns 0 on failure
+int export_map(const ExportOptions* options, const Tileset* tileset, const TileMap* map);
+
+// Encodes straight-alpha RGBA32 pixels (`pitch` pixels per row) as a PNG into `out`
+int png_encode_rgba(PngBuffer* out, const Uint32* pixels, int width, int height, int pitch);
+void png_buffer_free(PngBuffer* buffer);
+
+#endif
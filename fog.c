@@ -0,0 +1,381 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fog.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define FOG_BENCH_RADIUS 8
+#define FOG_BENCH_FRAMES 20
+
+// --- Rectangles, half-open and clipped to the map ---
+static int rect_empty(const SDL_Rect* rect) {
+    return rect->w <= 0 || rect->h <= 0;
+}
+
+static SDL_Rect observer_rect(const FogMap* fog, const FogObserver* o) {
+    int x0 = o->x - o->radius < 0 ? 0 : o->x - o->radius;
+    int y0 = o->y - o->radius < 0 ? 0 : o->y - o->radius;
+    int x1 = o->x + o->radius + 1 > fog->width ? fog->width : o->x + o->radius + 1;
+    int y1 = o->y + o->radius + 1 > fog->height ? fog->height : o->y + o->radius + 1;
+    SDL_Rect rect = { x0, y0, x1 - x0, y1 - y0 };
+    return rect;
+}
+
+static void mark_blocks(FogMap* fog, const SDL_Rect* rect) {
+    if (rect_empty(rect)) return;
+    int bx1 = (rect->x + rect->w - 1) / FOG_BLOCK, by1 = (rect->y + rect->h - 1) / FOG_BLOCK;
+    for (int by = rect->y / FOG_BLOCK; by <= by1; by++) {
+        for (int bx = rect->x / FOG_BLOCK; bx <= bx1; bx++) {
+            Uint8* block = &fog->pending[by * fog->blocks_x + bx];
+            fog->pending_count += !*block;
+            *block = 1;
+        }
+    }
+}
+
+// --- Bits [x0, x1) of a row ---
+static void span_set(Uint64* row, int x0, int x1) {
+    while (x0 < x1) {
+        int bit = x0 & 63, n = x1 - x0 < 64 - bit ? x1 - x0 : 64 - bit;
+        row[x0 >> 6] |= (n == 64 ? ~0ull : ((1ull << n) - 1)) << bit;
+        x0 += n;
+    }
+}
+
+static void span_clear(Uint64* row, int x0, int x1) {
+    while (x0 < x1) {
+        int bit = x0 & 63, n = x1 - x0 < 64 - bit ? x1 - x0 : 64 - bit;
+        row[x0 >> 6] &= ~((n == 64 ? ~0ull : ((1ull << n) - 1)) << bit);
+        x0 += n;
+    }
+}
+
+int fog_create(FogMap* fog, int width, int height, const RayMap* sight) {
+    memset(fog, 0, sizeof(*fog));
+    fog->width = width;
+    fog->height = height;
+    fog->words = (width + 63) / 64;
+    fog->sight = sight;
+    fog->cells_x = (width + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    fog->cells_y = (height + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    fog->visible = calloc((size_t)fog->words * height, sizeof(Uint64));
+    fog->explored = calloc((size_t)fog->words * height, sizeof(Uint64));
+    fog->cell_start = calloc((size_t)fog->cells_x * fog->cells_y + 1, sizeof(int));
+    fog->blocks_x = (width + FOG_BLOCK - 1) / FOG_BLOCK;
+    fog->blocks_y = (height + FOG_BLOCK - 1) / FOG_BLOCK;
+    fog->pending = calloc((size_t)fog->blocks_x * fog->blocks_y, 1);
+    if (!fog->visible || !fog->explored || !fog->cell_start || !fog->pending) {
+        printf("Failed to allocate fog of war for %dx%d tiles\n", width, height);
+        fog_free(fog);
+        return 0;
+    }
+    return 1;
+}
+
+void fog_free(FogMap* fog) {
+    free(fog->visible);
+    free(fog->explored);
+    free(fog->observers);
+    free(fog->cell_start);
+    free(fog->cell_items);
+    free(fog->pending);
+    free(fog->dirty);
+    free(fog->rays);
+    free(fog->hits);
+    memset(fog, 0, sizeof(*fog));
+}
+
+static void clamp_tile(const FogMap* fog, int* x, int* y) {
+    *x = *x < 0 ? 0 : *x >= fog->width ? fog->width - 1 : *x;
+    *y = *y < 0 ? 0 : *y >= fog->height ? fog->height - 1 : *y;
+}
+
+int fog_add_observer(FogMap* fog, int x, int y, int radius) {
+    if (fog->observer_count == fog->observer_capacity) {
+        int capacity = fog->observer_capacity ? fog->observer_capacity * 2 : 16;
+        FogObserver* observers = realloc(fog->observers, sizeof(FogObserver) * capacity);
+        if (!observers) return -1;
+        fog->observers = observers;
+        int* items = realloc(fog->cell_items, sizeof(int) * capacity);
+        if (!items) return -1;
+        fog->cell_items = items;
+        fog->observer_capacity = capacity;
+    }
+    FogObserver* o = &fog->observers[fog->observer_count];
+    clamp_tile(fog, &x, &y);
+    o->x = x;
+    o->y = y;
+    o->radius = radius;
+    if (radius > fog->max_radius) fog->max_radius = radius;
+    SDL_Rect rect = observer_rect(fog, o);
+    mark_blocks(fog, &rect);
+    return fog->observer_count++;
+}
+
+void fog_move_observer(FogMap* fog, int id, int x, int y) {
+    FogObserver* o = &fog->observers[id];
+    clamp_tile(fog, &x, &y);
+    if (o->x == x && o->y == y) return;
+    SDL_Rect before = observer_rect(fog, o);
+    o->x = x;
+    o->y = y;
+    SDL_Rect after = observer_rect(fog, o);
+    mark_blocks(fog, &before);
+    mark_blocks(fog, &after);
+}
+
+void fog_invalidate(FogMap* fog) {
+    SDL_Rect all = { 0, 0, fog->width, fog->height };
+    mark_blocks(fog, &all);
+}
+
+void fog_clear_dirty(FogMap* fog) {
+    fog->dirty_count = 0;
+}
+
+// --- Recompute ---
+static void bucket_observers(FogMap* fog) {
+    int cells = fog->cells_x * fog->cells_y;
+    int* start = fog->cell_start;
+    memset(start, 0, sizeof(int) * (cells + 1));
+    for (int i = 0; i < fog->observer_count; i++) {
+        const FogObserver* o = &fog->observers[i];
+        start[(o->y / MAP_CHUNK_TILES) * fog->cells_x + o->x / MAP_CHUNK_TILES]++;
+    }
+    for (int c = 0, sum = 0; c < cells; c++) {
+        int n = start[c];
+        start[c] = sum;
+        sum += n;
+    }
+    for (int i = 0; i < fog->observer_count; i++) {
+        const FogObserver* o = &fog->observers[i];
+        fog->cell_items[start[(o->y / MAP_CHUNK_TILES) * fog->cells_x + o->x / MAP_CHUNK_TILES]++] = i;
+    }
+    memmove(start + 1, start, sizeof(int) * cells);
+    start[0] = 0;
+}
+
+static int ensure_rays(FogMap* fog, int count) {
+    if (count <= fog->ray_capacity) return 1;
+    Ray* rays = realloc(fog->rays, sizeof(Ray) * count);
+    if (rays) fog->rays = rays;
+    RayHit* hits = realloc(fog->hits, sizeof(RayHit) * count);
+    if (hits) fog->hits = hits;
+    if (!rays || !hits) return 0;
+    fog->ray_capacity = count;
+    return 1;
+}
+
+// Half-width of the observer's disc on row y, or -1 when the row is outside it
+static int disc_half_width(const FogObserver* o, int y) {
+    int dy = y - o->y;
+    if (dy < -o->radius || dy > o->radius) return -1;
+    return (int)sqrtf((float)(o->radius * o->radius - dy * dy));
+}
+
+// Marks the tiles of `o` inside `clip`; with a sight map, those a ray reaches (a wall hit head-on is seen)
+static void observe(FogMap* fog, const FogObserver* o, const SDL_Rect* clip) {
+    int x_end = clip->x + clip->w, y_end = clip->y + clip->h;
+    if (!fog->sight) {
+        for (int y = clip->y; y < y_end; y++) {
+            int half = disc_half_width(o, y);
+            int x0 = o->x - half > clip->x ? o->x - half : clip->x;
+            int x1 = o->x + half + 1 < x_end ? o->x + half + 1 : x_end;
+            if (half >= 0) span_set(fog->visible + (size_t)y * fog->words, x0, x1);
+        }
+        return;
+    }
+
+    if (!ensure_rays(fog, clip->w * clip->h)) return;
+    int count = 0;
+    for (int y = clip->y; y < y_end; y++) {
+        int half = disc_half_width(o, y);
+        for (int x = o->x - half > clip->x ? o->x - half : clip->x; half >= 0 && x <= o->x + half && x < x_end; x++) {
+            Ray ray = { o->x + 0.5f, o->y + 0.5f, x + 0.5f, y + 0.5f };
+            fog->rays[count++] = ray;
+        }
+    }
+    ray_select()->cast(fog->sight, fog->rays, count, fog->hits);
+    for (int i = 0; i < count; i++) {
+        int x = (int)fog->rays[i].x1, y = (int)fog->rays[i].y1;
+        if (!fog->hits[i].blocked || (fog->hits[i].x == x && fog->hits[i].y == y)) {
+            fog->visible[(size_t)y * fog->words + (x >> 6)] |= 1ull << (x & 63);
+        }
+    }
+}
+
+static void recompute_rect(FogMap* fog, const SDL_Rect* rect) {
+    int x_end = rect->x + rect->w, y_end = rect->y + rect->h;
+    for (int y = rect->y; y < y_end; y++) span_clear(fog->visible + (size_t)y * fog->words, rect->x, x_end);
+
+    // Observers sit in the chunk of their tile, so look max_radius beyond the rectangle
+    int r = fog->max_radius;
+    int cx0 = (rect->x - r > 0 ? rect->x - r : 0) / MAP_CHUNK_TILES;
+    int cy0 = (rect->y - r > 0 ? rect->y - r : 0) / MAP_CHUNK_TILES;
+    int cx1 = (x_end - 1 + r) / MAP_CHUNK_TILES, cy1 = (y_end - 1 + r) / MAP_CHUNK_TILES;
+    if (cx1 >= fog->cells_x) cx1 = fog->cells_x - 1;
+    if (cy1 >= fog->cells_y) cy1 = fog->cells_y - 1;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        int first = fog->cell_start[cy * fog->cells_x + cx0], end = fog->cell_start[cy * fog->cells_x + cx1 + 1];
+        for (int k = first; k < end; k++) {
+            const FogObserver* o = &fog->observers[fog->cell_items[k]];
+            SDL_Rect view = observer_rect(fog, o), clip;
+            if (SDL_IntersectRect(&view, rect, &clip)) observe(fog, o, &clip);
+        }
+    }
+
+    // Explored always holds visible, so whole words can be merged
+    int w0 = rect->x >> 6, w1 = (x_end - 1) >> 6;
+    for (int y = rect->y; y < y_end; y++) {
+        Uint64* visible = fog->visible + (size_t)y * fog->words;
+        Uint64* explored = fog->explored + (size_t)y * fog->words;
+        for (int w = w0; w <= w1; w++) explored[w] |= visible[w];
+    }
+}
+
+static int add_dirty(FogMap* fog, const SDL_Rect* rect) {
+    if (fog->dirty_count == fog->dirty_capacity) {
+        int capacity = fog->dirty_capacity ? fog->dirty_capacity * 2 : 64;
+        SDL_Rect* dirty = realloc(fog->dirty, sizeof(SDL_Rect) * capacity);
+        if (!dirty) return 0;
+        fog->dirty = dirty;
+        fog->dirty_capacity = capacity;
+    }
+    fog->dirty[fog->dirty_count++] = *rect;
+    return 1;
+}
+
+void fog_update(FogMap* fog) {
+    if (fog->pending_count == 0) return;
+    bucket_observers(fog);
+    int overflow = 0;
+    for (int by = 0; by < fog->blocks_y; by++) {
+        Uint8* row = fog->pending + by * fog->blocks_x;
+        for (int bx = 0; bx < fog->blocks_x; bx++) {
+            const Uint8* next = memchr(row + bx, 1, fog->blocks_x - bx);
+            if (!next) break;
+            bx = (int)(next - row);
+            int run = bx;
+            while (run < fog->blocks_x && row[run]) row[run++] = 0;
+            int x1 = run * FOG_BLOCK < fog->width ? run * FOG_BLOCK : fog->width;
+            int y1 = (by + 1) * FOG_BLOCK < fog->height ? (by + 1) * FOG_BLOCK : fog->height;
+            SDL_Rect rect = { bx * FOG_BLOCK, by * FOG_BLOCK, x1 - bx * FOG_BLOCK, y1 - by * FOG_BLOCK };
+            recompute_rect(fog, &rect);
+            overflow |= !add_dirty(fog, &rect);
+            bx = run;
+        }
+    }
+    fog->pending_count = 0;
+    // Without room for the runs the whole map has to count as changed
+    if (overflow) {
+        SDL_Rect all = { 0, 0, fog->width, fog->height };
+        fog->dirty_count = 0;
+        add_dirty(fog, &all);
+    }
+}
+
+void fog_luminance(const FogMap* fog, const SDL_Rect* rect, Uint8* out) {
+    for (int y = 0; y < rect->h; y++) {
+        const Uint64* visible = fog->visible + (size_t)(rect->y + y) * fog->words;
+        const Uint64* explored = fog->explored + (size_t)(rect->y + y) * fog->words;
+        Uint8* row = out + (size_t)y * rect->w;
+        for (int x = 0; x < rect->w; x++) {
+            int tx = rect->x + x;
+            Uint64 bit = 1ull << (tx & 63);
+            row[x] = (visible[tx >> 6] & bit) ? FOG_LUMINANCE_VISIBLE :
+                     (explored[tx >> 6] & bit) ? FOG_LUMINANCE_EXPLORED : FOG_LUMINANCE_UNKNOWN;
+        }
+    }
+}
+
+// --- Benchmark: observers on random tiles, a quarter of them taking a step each frame ---
+static void random_walk(FogMap* fog, unsigned int* seed) {
+    for (int i = 0; i < fog->observer_count; i++) {
+        if ((next_random(seed) >> 24) & 3) continue;
+        int step = (int)((*seed >> 12) % 8);
+        step += step >= 4;                // Skip standing still
+        const FogObserver* o = &fog->observers[i];
+        fog_move_observer(fog, i, o->x + step % 3 - 1, o->y + step / 3 - 1);
+    }
+}
+
+void fog_benchmark(const Tileset* tileset, const TileMap* map) {
+    static const int counts[] = { 100, 1000, 10000 };
+    static Uint8 opaque_types[MAX_TILESET_CELLS * MAX_TILESET_CELLS];
+    static RayMap sight;
+    ray_default_opaque(opaque_types, tileset);
+    if (!ray_map_create(&sight, map, opaque_types)) return;
+    size_t bytes = sizeof(Uint64) * (size_t)((map->width + 63) / 64) * map->height;
+    Uint64* reference = malloc(bytes);
+    if (!reference) {
+        printf("Failed to allocate %dx%d fog bits\n", map->width, map->height);
+        ray_map_free(&sight);
+        return;
+    }
+
+    printf("Fog of war on %dx%d tiles, sight radius %d, a quarter of the observers moving, %d frames per run, ray kernel %s\n",
+           map->width, map->height, FOG_BENCH_RADIUS, FOG_BENCH_FRAMES, ray_select()->name);
+    printf("%10s %6s %12s %10s %12s %12s\n", "observers", "sight", "dirty tiles", "runs", "update ms", "full ms");
+    for (int walls = 0; walls < 2; walls++) {
+        for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+            FogMap fog;
+            if (!fog_create(&fog, map->width, map->height, walls ? &sight : NULL)) break;
+            unsigned int seed = 9;
+            int ok = 1;
+            for (int i = 0; i < counts[c] && ok; i++) {
+                unsigned int r = next_random(&seed);
+                ok = fog_add_observer(&fog, (int)((r >> 8) % (unsigned int)map->width),
+                                      (int)((r >> 4) % (unsigned int)map->height), FOG_BENCH_RADIUS) >= 0;
+            }
+            fog_update(&fog);
+            fog_clear_dirty(&fog);
+
+            double update_ms = 0.0;
+            long dirty_tiles = 0, dirty_runs = 0;
+            for (int frame = 0; frame < FOG_BENCH_FRAMES && ok; frame++) {
+                random_walk(&fog, &seed);
+                Uint64 start = SDL_GetPerformanceCounter();
+                fog_update(&fog);
+                update_ms += seconds_since(start) * 1e3;
+                for (int i = 0; i < fog.dirty_count; i++) dirty_tiles += (long)fog.dirty[i].w * fog.dirty[i].h;
+                dirty_runs += fog.dirty_count;
+                fog_clear_dirty(&fog);
+            }
+
+            // The regions must agree with recomputing everything
+            memcpy(reference, fog.visible, bytes);
+            fog_invalidate(&fog);
+            Uint64 start = SDL_GetPerformanceCounter();
+            fog_update(&fog);
+            double full_ms = seconds_since(start) * 1e3;
+            ok = ok && memcmp(reference, fog.visible, bytes) == 0;
+
+            printf("%10d %6s %12ld %10ld %12.3f %12.3f%s\n", counts[c], walls ? "walls" : "none",
+                   dirty_tiles / FOG_BENCH_FRAMES, dirty_runs / FOG_BENCH_FRAMES, update_ms / FOG_BENCH_FRAMES, full_ms,
+                   bench_mismatch(ok));
+            fog_free(&fog);
+        }
+    }
+    free(reference);
+    ray_map_free(&sight);
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Fog of war. Two bit grids, one bit per tile: what observers see now and
+// what they have ever seen. Moving an observer marks the 8x8 tile blocks
+// under its old and new view; fog_update recomputes each horizontal run of
+// marked blocks once, from the observers that reach into it, optionally
+// testing line of sight through a RayMap. The runs stay listed until
+// fog_clear_dirty so a renderer can update its copy, one byte of luminance per
+// tile (fog_luminance), with sub-rectangle uploads.
+
+#ifndef FOG_H
+#define FOG_H
+
+#include "tilemap.h"
+#include "raycast.h"
+
+#define FOG_BLOCK 8                      // Side of the blocks updates are tracked in
+#define FOG_LUMINANCE_VISIBLE 255
+#define FOG_LUMINANCE_EXPLORED 96        // Seen before but not now
+#define FOG_LUMINANCE_UNKNOWN 0
+
+typedef struct {
+    int x, y;                // Tile the observer stands on
+    int radius;              // Sight radius in tiles
+} FogObserver;
+
+typedef struct FogMap {
+    int width, height;
+    int words;               // Uint64 words per row
+    Uint64* visible;
+    Uint64* explored;
+    const RayMap* sight;     // Opaque tiles block sight when set
+    FogObserver* observers;
+    int observer_count, observer_capacity;
+    int max_radius;
+    int cells_x, cells_y;    // Observers bucketed by map chunk while updating
+    int* cell_start;
+    int* cell_items;
+    Ray* rays;               // Sight rays of one observer, cast as a batch
+    RayHit* hits;
+    int ray_capacity;
+    int blocks_x, blocks_y;
+    Uint8* pending;          // Blocks waiting for fog_update
+    int pending_count;
+    SDL_Rect* dirty;         // Runs of blocks recomputed since fog_clear_dirty, clipped to the map
+    int dirty_count, dirty_capacity;
+} FogMap;
+
+// `sight` may be NULL for plain discs
+int fog_create(FogMap* fog, int width, int height, const RayMap* sight);
+void fog_free(FogMap* fog);
+
+// Returns the observer's id, or -1 when out of memory
+int fog_add_observer(FogMap* fog, int x, int y, int radius);
+void fog_move_observer(FogMap* fog, int id, int x, int y);
+// Marks the whole map, e.g. after the opacity in `sight` changed
+void fog_invalidate(FogMap* fog);
+// Recomputes the marked blocks and adds them to the dirty list
+void fog_update(FogMap* fog);
+void fog_clear_dirty(FogMap* fog);
+
+static inline int fog_bit(const Uint64* bits, const FogMap* fog, int x, int y) {
+    return (int)((bits[(size_t)y * fog->words + (x >> 6)] >> (x & 63)) & 1);
+}
+
+// Luminance of the tiles in `rect`, rect->w bytes per row
+void fog_luminance(const FogMap* fog, const SDL_Rect* rect, Uint8* out);
+
+// Prints the cost of region updates against full recomputes for 100 to 10000 moving observers
+void fog_benchmark(const Tileset* tileset, const TileMap* map);
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gl_chunks.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CHUNK_MAX_VERTICES (CHUNK_SIZE * CHUNK_SIZE * 4)
+
+void chunks_init(ChunkCache* cache, GlState* state, ChunkFormat format) {
+    memset(cache, 0, sizeof(*cache));
+    cache->ext = state->ext;
+    cache->state = state;
+    cache->format = format;
+    cache->vertex_size = format == CHUNK_FORMAT_SHORT ? (int)sizeof(ChunkVertex16) : (int)sizeof(ChunkVertex32);
+    cache->scratch = malloc((size_t)cache->vertex_size * CHUNK_MAX_VERTICES);
+}
+
+static void release_mesh(ChunkCache* cache, ChunkMesh* mesh) {
+    if (mesh->vbo) state_delete_buffer(cache->state, mesh->vbo);
+    free(mesh->client);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+void chunks_free(ChunkCache* cache) {
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        if (cache->meshes[i].in_use) release_mesh(cache, &cache->meshes[i]);
+    }
+    free(cache->scratch);
+    cache->scratch = NULL;
+}
+
+// --- Emit one quad per in-map cell of the chunk into the scratch buffer ---
+static int build_vertices(ChunkCache* cache, int level, int cx, int cy, const TileMap* map) {
+    int origin_x = cx * CHUNK_SIZE * level;
+    int origin_y = cy * CHUNK_SIZE * level;
+    int quads = 0;
+
+    for (int j = 0; j < CHUNK_SIZE; j++) {
+        int ty = origin_y + j * level;
+        if (ty >= map->height) break;
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            int tx = origin_x + i * level;
+            if (tx >= map->width) break;
+
+            // Corner k samples cell corner (u + bit 2k, v + bit 2k + 1) of the tile's transform
+            TileEntry tile = map->tiles[(size_t)ty * map->width + tx];
+            unsigned int c = tile_corner_bits[tile_transform(tile)];
+            if (cache->format == CHUNK_FORMAT_SHORT) {
+                ChunkVertex16* q = (ChunkVertex16*)cache->scratch + quads * 4;
+                GLshort x = (GLshort)i, y = (GLshort)j, u = tile.sx, v = (GLshort)tile_row(tile);
+                q[0] = (ChunkVertex16){ x,     y,     u + (c & 1),      v + (c >> 1 & 1) };
+                q[1] = (ChunkVertex16){ x + 1, y,     u + (c >> 2 & 1), v + (c >> 3 & 1) };
+                q[2] = (ChunkVertex16){ x + 1, y + 1, u + (c >> 4 & 1), v + (c >> 5 & 1) };
+                q[3] = (ChunkVertex16){ x,     y + 1, u + (c >> 6 & 1), v + (c >> 7)     };
+            } else {
+                ChunkVertex32* q = (ChunkVertex32*)cache->scratch + quads * 4;
+                GLfloat x = (GLfloat)i, y = (GLfloat)j, u = tile.sx, v = (GLfloat)tile_row(tile);
+                q[0] = (ChunkVertex32){ x,     y,     u + (c & 1),      v + (c >> 1 & 1) };
+                q[1] = (ChunkVertex32){ x + 1, y,     u + (c >> 2 & 1), v + (c >> 3 & 1) };
+                q[2] = (ChunkVertex32){ x + 1, y + 1, u + (c >> 4 & 1), v + (c >> 5 & 1) };
+                q[3] = (ChunkVertex32){ x,     y + 1, u + (c >> 6 & 1), v + (c >> 7)     };
+            }
+            quads++;
+        }
+    }
+    return quads;
+}
+
+// --- Find the mesh for a key, or the least recently used slot to rebuild it in ---
+static ChunkMesh* lookup_mesh(ChunkCache* cache, int level, int cx, int cy, int* hit) {
+    ChunkMesh* victim = &cache->meshes[0];
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        ChunkMesh* mesh = &cache->meshes[i];
+        if (mesh->in_use && mesh->level == level && mesh->cx == cx && mesh->cy == cy) {
+            *hit = 1;
+            return mesh;
+        }
+        if (!mesh->in_use) {
+            if (victim->in_use) victim = mesh;
+        } else if (victim->in_use && mesh->last_used < victim->last_used) {
+            victim = mesh;
+        }
+    }
+    *hit = 0;
+    return victim;
+}
+
+static ChunkMesh* get_mesh(ChunkCache* cache, int level, int cx, int cy, const TileMap* map, FrameStats* stats) {
+    int hit;
+    ChunkMesh* mesh = lookup_mesh(cache, level, cx, cy, &hit);
+    if (hit && mesh->revision != map->revision) {
+        // The map changed somewhere; keep the mesh if none of its tiles did
+        int span = CHUNK_SIZE * level;
+        if (!tilemap_region_changed(map, cx * span, cy * span, (cx + 1) * span, (cy + 1) * span, mesh->revision)) {
+            mesh->revision = map->revision;
+        }
+    }
+    if (hit && mesh->revision == map->revision) {
+        mesh->last_used = cache->frame;
+        return mesh;
+    }
+
+    // Miss or stale: (re)build in place
+    const GlExtensions* ext = cache->ext;
+    int quads = build_vertices(cache, level, cx, cy, map);
+    size_t bytes = (size_t)quads * 4 * cache->vertex_size;
+
+    if (ext->has_vbo) {
+        if (!mesh->vbo) ext->GenBuffers(1, &mesh->vbo);
+        state_bind_buffer(cache->state, GL_ARRAY_BUFFER, mesh->vbo);
+        ext->BufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, cache->scratch, GL_STATIC_DRAW);
+    } else {
+        void* client = realloc(mesh->client, bytes ? bytes : 1);
+        if (!client) return NULL;
+        memcpy(client, cache->scratch, bytes);
+        mesh->client = client;
+    }
+
+    mesh->in_use = 1;
+    mesh->level = level;
+    mesh->cx = cx;
+    mesh->cy = cy;
+    mesh->revision = map->revision;
+    mesh->last_used = cache->frame;
+    mesh->quad_count = quads;
+
+    stats->tiles_built += quads;
+    stats->bytes_streamed += bytes;
+    return mesh;
+}
+
+void chunks_draw(ChunkCache* cache, const QuadIndexBuffer* quads, const View* view, const TileMap* map, const Tileset* tileset,
+                 FrameStats* stats) {
+    const Camera* cam = &view->camera;
+    const GlExtensions* ext = cache->ext;
+    if (!cache->scratch) return;
+    cache->frame++;
+
+    // Power-of-two LOD so chunks at one level tile the chunks of the next
+    int level = 1;
+    while (level < view->lod) level *= 2;
+
+    float cell_w = (float)view->tile_width * level;
+    float cell_h = (float)view->tile_height * level;
+    float span_w = cell_w * CHUNK_SIZE;
+    float span_h = cell_h * CHUNK_SIZE;
+
+    int chunks_x = (map->width + CHUNK_SIZE * level - 1) / (CHUNK_SIZE * level);
+    int chunks_y = (map->height + CHUNK_SIZE * level - 1) / (CHUNK_SIZE * level);
+    int min_cx = (int)floorf(-cam->offset_x / span_w);
+    int min_cy = (int)floorf(-cam->offset_y / span_h);
+    int max_cx = (int)ceilf((cam->screen_w / cam->zoom - cam->offset_x) / span_w);
+    int max_cy = (int)ceilf((cam->screen_h / cam->zoom - cam->offset_y) / span_h);
+    if (min_cx < 0) min_cx = 0;
+    if (min_cy < 0) min_cy = 0;
+    if (max_cx > chunks_x) max_cx = chunks_x;
+    if (max_cy > chunks_y) max_cy = chunks_y;
+
+    GLenum type = cache->format == CHUNK_FORMAT_SHORT ? GL_SHORT : GL_FLOAT;
+    int component = cache->format == CHUNK_FORMAT_SHORT ? (int)sizeof(GLshort) : (int)sizeof(GLfloat);
+
+    // Integer atlas cells to normalised texture coordinates
+    glMatrixMode(GL_TEXTURE);
+    glLoadIdentity();
+    glScalef(1.0f / tileset->cols, 1.0f / tileset->rows, 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+
+    glPushMatrix();
+    glScalef(cam->zoom, cam->zoom, 1.0f);
+    glTranslatef(cam->offset_x, cam->offset_y, 0.0f);
+
+    state_enable(cache->state, STATE_VERTEX_ARRAY | STATE_TEXCOORD_ARRAY);
+    state_disable(cache->state, STATE_COLOR_ARRAY);
+
+    for (int cy = min_cy; cy < max_cy; cy++) {
+        for (int cx = min_cx; cx < max_cx; cx++) {
+            ChunkMesh* mesh = get_mesh(cache, level, cx, cy, map, stats);
+            if (!mesh || mesh->quad_count == 0) continue;
+
+            const unsigned char* base = ext->has_vbo ? NULL : mesh->client;
+            state_bind_buffer(cache->state, GL_ARRAY_BUFFER, mesh->vbo);
+            glPushMatrix();
+            glTranslatef(cx * span_w, cy * span_h, 0.0f);
+            glScalef(cell_w, cell_h, 1.0f);
+            if (quads) {
+                QuadArrays arrays = { base, cache->vertex_size, type, 2 * component, -1 };
+                draw_indexed_quads(quads, &arrays, mesh->quad_count, stats);
+            } else {
+                glVertexPointer(2, type, cache->vertex_size, base);
+                glTexCoordPointer(2, type, cache->vertex_size, base + 2 * component);
+                glDrawArrays(GL_QUADS, 0, mesh->quad_count * 4);
+                stats->draw_calls++;
+            }
+            glPopMatrix();
+
+            stats->tiles_drawn += mesh->quad_count;
+            stats->vertex_bytes += (Uint64)mesh->quad_count * 4 * cache->vertex_size;
+        }
+    }
+
+    glPopMatrix();
+
+    glMatrixMode(GL_TEXTURE);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+
+    for (int i = 0; i < CHUNK_CACHE_SIZE; i++) {
+        if (cache->meshes[i].in_use) {
+            stats->vertex_memory += (Uint64)cache->meshes[i].quad_count * 4 * cache->vertex_size;
+        }
+    }
+    stats->lod = level;
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Static per-chunk geometry cache. A chunk is CHUNK_SIZE x CHUNK_SIZE LOD
+// cells, where a cell covers `level` tiles along each axis (level is the
+// view's LOD rounded up to a power of two), so the number of visible chunks
+// stays small at every zoom. Geometry is built once per chunk and level,
+// kept in a buffer object, and reused until one of the map chunks it covers
+// is edited (see tilemap_region_changed).
+//
+// Vertices are stored relative to the chunk in cell units. The compressed
+// format uses GLshort positions and integer atlas-cell UVs (8 bytes per
+// vertex); the chunk origin, cell size, zoom and offsets come from the
+// modelview matrix and 1/cols, 1/rows from the texture matrix. The float
+// format holds the same values as GLfloat (16 bytes per vertex) for
+// comparison.
+
+#ifndef GL_CHUNKS_H
+#define GL_CHUNKS_H
+
+#include "gl_ext.h"
+#include "gl_quads.h"
+#include "gl_state.h"
+#include "tilemap.h"
+
+#define CHUNK_SIZE 32                     // Cells per chunk side; cell coordinates fit in a GLshort
+#define CHUNK_CACHE_SIZE 256              // Cached chunk meshes before least recently used eviction
+
+typedef enum { CHUNK_FORMAT_SHORT, CHUNK_FORMAT_FLOAT } ChunkFormat;
+
+typedef struct {
+    GLshort x, y;    // Position in cells from the chunk origin
+    GLshort u, v;    // Tileset grid cell, scaled by the texture matrix
+} ChunkVertex16;
+
+typedef struct {
+    GLfloat x, y;
+    GLfloat u, v;
+} ChunkVertex32;
+
+typedef struct {
+    int in_use;
+    int level, cx, cy;           // Cache key: LOD level and chunk coordinates at that level
+    Uint32 revision;             // Map revision the mesh was built from
+    Uint32 last_used;            // Frame counter for LRU eviction
+    int quad_count;
+    GLuint vbo;
+    void* client;                // Mesh in client memory when buffer objects are unavailable
+} ChunkMesh;
+
+typedef struct {
+    const GlExtensions* ext;
+    GlState* state;
+    ChunkFormat format;
+    int vertex_size;
+    Uint32 frame;
+    ChunkMesh meshes[CHUNK_CACHE_SIZE];
+    void* scratch;               // Build buffer for one chunk
+} ChunkCache;
+
+void chunks_init(ChunkCache* cache, GlState* state, ChunkFormat format);
+void chunks_free(ChunkCache* cache);
+
+// Draws the visible chunks with the tileset texture bound; the camera transform is applied here.
+// With `quads` the meshes are drawn as indexed triangles, otherwise as GL_QUADS.
+void chunks_draw(ChunkCache* cache, const QuadIndexBuffer* quads, const View* view, const TileMap* map, const Tileset* tileset,
+                 FrameStats* stats);
+
+#endif
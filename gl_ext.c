@@ -0,0 +1,170 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gl_ext.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+// --- Resolve `name`, falling back to the `name` + `suffix` extension variant ---
+static void* load_proc(const char* name, const char* suffix) {
+    void* proc = SDL_GL_GetProcAddress(name);
+    if (!proc && suffix) {
+        char ext_name[96];
+        snprintf(ext_name, sizeof(ext_name), "%s%s", name, suffix);
+        proc = SDL_GL_GetProcAddress(ext_name);
+    }
+    return proc;
+}
+
+static int parse_version(void) {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 1, minor = 1;
+    if (version) sscanf(version, "%d.%d", &major, &minor);
+    return major * 10 + minor;
+}
+
+void gl_ext_load(GlExtensions* ext) {
+    memset(ext, 0, sizeof(*ext));
+    ext->version = parse_version();
+
+    const char* fbo_suffix = NULL;
+    if (ext->version >= 30 || SDL_GL_ExtensionSupported("GL_ARB_framebuffer_object")) {
+        ext->has_fbo = 1;
+    } else if (SDL_GL_ExtensionSupported("GL_EXT_framebuffer_object")) {
+        ext->has_fbo = 1;
+        fbo_suffix = "EXT";
+    }
+    if (ext->has_fbo) {
+        ext->GenFramebuffers = load_proc("glGenFramebuffers", fbo_suffix);
+        ext->DeleteFramebuffers = load_proc("glDeleteFramebuffers", fbo_suffix);
+        ext->BindFramebuffer = load_proc("glBindFramebuffer", fbo_suffix);
+        ext->FramebufferTexture2D = load_proc("glFramebufferTexture2D", fbo_suffix);
+        ext->CheckFramebufferStatus = load_proc("glCheckFramebufferStatus", fbo_suffix);
+        ext->has_fbo = ext->GenFramebuffers && ext->DeleteFramebuffers && ext->BindFramebuffer &&
+                       ext->FramebufferTexture2D && ext->CheckFramebufferStatus;
+    }
+
+    const char* vbo_suffix = NULL;
+    if (ext->version >= 15) {
+        ext->has_vbo = 1;
+    } else if (SDL_GL_ExtensionSupported("GL_ARB_vertex_buffer_object")) {
+        ext->has_vbo = 1;
+        vbo_suffix = "ARB";
+    }
+    if (ext->has_vbo) {
+        ext->GenBuffers = load_proc("glGenBuffers", vbo_suffix);
+        ext->DeleteBuffers = load_proc("glDeleteBuffers", vbo_suffix);
+        ext->BindBuffer = load_proc("glBindBuffer", vbo_suffix);
+        ext->BufferData = load_proc("glBufferData", vbo_suffix);
+        ext->BufferSubData = load_proc("glBufferSubData", vbo_suffix);
+        ext->MapBuffer = load_proc("glMapBuffer", vbo_suffix);
+        ext->UnmapBuffer = load_proc("glUnmapBuffer", vbo_suffix);
+        ext->has_vbo = ext->GenBuffers && ext->DeleteBuffers && ext->BindBuffer && ext->BufferData &&
+                       ext->BufferSubData && ext->MapBuffer && ext->UnmapBuffer;
+    }
+    // Pixel buffers are new binding targets for the buffer object entry points
+    ext->has_pbo = ext->has_vbo &&
+                   (ext->version >= 21 || SDL_GL_ExtensionSupported("GL_ARB_pixel_buffer_object"));
+
+    // The ARB variants of these use the core names, so no suffix fallback is needed
+    if (ext->has_vbo &&
+        (ext->version >= 44 || SDL_GL_ExtensionSupported("GL_ARB_buffer_storage")) &&
+        (ext->version >= 32 || SDL_GL_ExtensionSupported("GL_ARB_sync")) &&
+        (ext->version >= 30 || SDL_GL_ExtensionSupported("GL_ARB_map_buffer_range"))) {
+        ext->BufferStorage = load_proc("glBufferStorage", NULL);
+        ext->MapBufferRange = load_proc("glMapBufferRange", NULL);
+        ext->FenceSync = load_proc("glFenceSync", NULL);
+        ext->ClientWaitSync = load_proc("glClientWaitSync", NULL);
+        ext->DeleteSync = load_proc("glDeleteSync", NULL);
+        ext->has_persistent = ext->BufferStorage && ext->MapBufferRange && ext->FenceSync &&
+                              ext->ClientWaitSync && ext->DeleteSync;
+    }
+
+    if (ext->version >= 20) {
+        ext->CreateShader = load_proc("glCreateShader", NULL);
+        ext->ShaderSource = load_proc("glShaderSource", NULL);
+        ext->CompileShader = load_proc("glCompileShader", NULL);
+        ext->GetShaderiv = load_proc("glGetShaderiv", NULL);
+        ext->GetShaderInfoLog = load_proc("glGetShaderInfoLog", NULL);
+        ext->DeleteShader = load_proc("glDeleteShader", NULL);
+        ext->CreateProgram = load_proc("glCreateProgram", NULL);
+        ext->AttachShader = load_proc("glAttachShader", NULL);
+        ext->LinkProgram = load_proc("glLinkProgram", NULL);
+        ext->GetProgramiv = load_proc("glGetProgramiv", NULL);
+        ext->GetProgramInfoLog = load_proc("glGetProgramInfoLog", NULL);
+        ext->DeleteProgram = load_proc("glDeleteProgram", NULL);
+        ext->UseProgram = load_proc("glUseProgram", NULL);
+        ext->GetUniformLocation = load_proc("glGetUniformLocation", NULL);
+        ext->Uniform1i = load_proc("glUniform1i", NULL);
+        ext->Uniform2f = load_proc("glUniform2f", NULL);
+        ext->has_shaders = ext->CreateShader && ext->ShaderSource && ext->CompileShader && ext->GetShaderiv &&
+                           ext->GetShaderInfoLog && ext->DeleteShader && ext->CreateProgram &&
+                           ext->AttachShader && ext->LinkProgram && ext->GetProgramiv &&
+                           ext->GetProgramInfoLog && ext->DeleteProgram && ext->UseProgram &&
+                           ext->GetUniformLocation && ext->Uniform1i && ext->Uniform2f;
+    }
+}
+
+static GLuint compile_shader(const GlExtensions* ext, GLenum type, const char* source) {
+    GLuint shader = ext->CreateShader(type);
+    ext->ShaderSource(shader, 1, &source, NULL);
+    ext->CompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    ext->GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        ext->GetShaderInfoLog(shader, sizeof(log), NULL, log);
+        printf("Shader compile failed: %s\n", log);
+        ext->DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint gl_build_program(const GlExtensions* ext, const char* vertex_source, const char* fragment_source) {
+    if (!ext->has_shaders) return 0;
+
+    GLuint vs = compile_shader(ext, GL_VERTEX_SHADER, vertex_source);
+    GLuint fs = compile_shader(ext, GL_FRAGMENT_SHADER, fragment_source);
+    if (!vs || !fs) {
+        if (vs) ext->DeleteShader(vs);
+        if (fs) ext->DeleteShader(fs);
+        return 0;
+    }
+
+    GLuint program = ext->CreateProgram();
+    ext->AttachShader(program, vs);
+    ext->AttachShader(program, fs);
+    ext->LinkProgram(program);
+    ext->DeleteShader(vs);
+    ext->DeleteShader(fs);
+
+    GLint ok = GL_FALSE;
+    ext->GetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        ext->GetProgramInfoLog(program, sizeof(log), NULL, log);
+        printf("Program link failed: %s\n", log);
+        ext->DeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
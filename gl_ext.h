@@ -0,0 +1,86 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Optional OpenGL entry points beyond 1.1, resolved at runtime so the
+// backend still starts on plain 1.1 drivers. Each feature has a has_ flag;
+// callers check it and fall back to the 1.1 code path when it is zero.
+
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+typedef struct {
+    int version;                      // Context version as major * 10 + minor
+
+    // --- Framebuffer objects (GL 3.0, ARB_framebuffer_object or EXT_framebuffer_object) ---
+    int has_fbo;
+    PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
+    PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers;
+    PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+    PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus;
+
+    // --- Vertex buffer objects (GL 1.5 or ARB_vertex_buffer_object) ---
+    int has_vbo;
+    PFNGLGENBUFFERSPROC GenBuffers;
+    PFNGLDELETEBUFFERSPROC DeleteBuffers;
+    PFNGLBINDBUFFERPROC BindBuffer;
+    PFNGLBUFFERDATAPROC BufferData;
+    PFNGLBUFFERSUBDATAPROC BufferSubData;
+    PFNGLMAPBUFFERPROC MapBuffer;
+    PFNGLUNMAPBUFFERPROC UnmapBuffer;
+    int has_pbo;                      // GL_PIXEL_PACK_BUFFER (GL 2.1 or ARB_pixel_buffer_object)
+
+    // --- Persistent mapping: buffer storage (GL 4.4) with map range and fences (GL 3.2) ---
+    int has_persistent;
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+    PFNGLFENCESYNCPROC FenceSync;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    PFNGLDELETESYNCPROC DeleteSync;
+
+    // --- GLSL programs (GL 2.0) ---
+    int has_shaders;
+    PFNGLCREATESHADERPROC CreateShader;
+    PFNGLSHADERSOURCEPROC ShaderSource;
+    PFNGLCOMPILESHADERPROC CompileShader;
+    PFNGLGETSHADERIVPROC GetShaderiv;
+    PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog;
+    PFNGLDELETESHADERPROC DeleteShader;
+    PFNGLCREATEPROGRAMPROC CreateProgram;
+    PFNGLATTACHSHADERPROC AttachShader;
+    PFNGLLINKPROGRAMPROC LinkProgram;
+    PFNGLGETPROGRAMIVPROC GetProgramiv;
+    PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog;
+    PFNGLDELETEPROGRAMPROC DeleteProgram;
+    PFNGLUSEPROGRAMPROC UseProgram;
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+    PFNGLUNIFORM1IPROC Uniform1i;
+    PFNGLUNIFORM2FPROC Uniform2f;
+} GlExtensions;
+
+// Must be called with the context current
+void gl_ext_load(GlExtensions* ext);
+
+// Compiles and links a vertex + fragment program; returns 0 and prints the log on failure
+GLuint gl_build_program(const GlExtensions* ext, const char* vertex_source, const char* fragment_source);
+
+#endif
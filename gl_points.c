@@ -0,0 +1,150 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gl_points.h"
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+
+// The second coordinate is TileEntry.sy as stored: row plus transform * 32 (TILE_ROW_BITS).
+// GLSL 1.10 has no bit operations, so the transform bits are split off with floor and mod
+static const char* const point_vertex_source =
+    "#version 110\n"
+    "varying vec2 cell;\n"
+    "varying vec3 flips;\n"
+    "void main() {\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+    "    float transform = floor(gl_MultiTexCoord0.y / 32.0);\n"
+    "    cell = vec2(gl_MultiTexCoord0.x, gl_MultiTexCoord0.y - transform * 32.0);\n"
+    "    flips = mod(floor(transform / vec3(1.0, 2.0, 4.0)), 2.0);\n"
+    "}\n";
+
+// gl_PointCoord starts at the upper left like the tileset rows, and never reaches 0 or 1
+// at fragment centres, so nearest sampling stays inside the cell. The flips undo x and y,
+// then the transpose, as mixes rather than branches
+static const char* const point_fragment_source =
+    "#version 110\n"
+    "uniform sampler2D tileset;\n"
+    "uniform vec2 cell_size;\n"
+    "varying vec2 cell;\n"
+    "varying vec3 flips;\n"
+    "void main() {\n"
+    "    vec2 p = mix(gl_PointCoord, 1.0 - gl_PointCoord, flips.xy);\n"
+    "    p = mix(p, p.yx, flips.z);\n"
+    "    gl_FragColor = texture2D(tileset, (cell + p) * cell_size);\n"
+    "}\n";
+
+int points_init(PointSprites* points, GlState* state, const Tileset* tileset) {
+    const GlExtensions* ext = state->ext;
+    memset(points, 0, sizeof(*points));
+    points->state = state;
+    if (!ext->has_shaders || tileset->tile_width != tileset->tile_height) return 0;
+
+    GLfloat range[2] = { 1.0f, 1.0f };
+    glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, range);
+    points->max_point_size = range[1];
+
+    points->program = gl_build_program(ext, point_vertex_source, point_fragment_source);
+    if (!points->program) return 0;
+
+    state_use_program(state, points->program);
+    ext->Uniform1i(ext->GetUniformLocation(points->program, "tileset"), 0);
+    ext->Uniform2f(ext->GetUniformLocation(points->program, "cell_size"),
+                   1.0f / tileset->cols, 1.0f / tileset->rows);
+    return 1;
+}
+
+void points_free(PointSprites* points) {
+    if (points->program) points->state->ext->DeleteProgram(points->program);
+    points->program = 0;
+}
+
+int points_draw(PointSprites* points, StreamBuffer* stream, const View* view, const TileMap* map,
+                int width, int height, FrameStats* stats) {
+    const Camera* cam = &view->camera;
+    int lod = view->lod;
+
+    // Aliased points snap to whole pixels; rounding up overlaps neighbours instead of leaving seams
+    float size = ceilf(view->tile_width * cam->zoom * lod);
+    if (!points->program || size > points->max_point_size) return 0;
+
+    int tiles_x = (view->max_x - view->start_x + lod - 1) / lod;
+    int tiles_y = (view->max_y - view->start_y + lod - 1) / lod;
+    if (tiles_x <= 0 || tiles_y <= 0) return 1;
+    int count = tiles_x * tiles_y;
+
+    size_t bytes = sizeof(PointVertex) * (size_t)count;
+    PointVertex* out = stream_begin(stream, bytes, stats);
+    if (!out) return 0;
+
+    // Every tile has a fixed slot, so rows can be written in parallel without a shared counter
+    float half_w = 0.5f * view->tile_width * lod, half_h = 0.5f * view->tile_height * lod;
+    #pragma omp parallel for schedule(static)
+    for (int row = 0; row < tiles_y; row++) {
+        int y = view->start_y + row * lod;
+        const TileEntry* src = &map->tiles[(size_t)y * map->width];
+        PointVertex* dst = &out[(size_t)row * tiles_x];
+        for (int col = 0; col < tiles_x; col++) {
+            int x = view->start_x + col * lod;
+            dst[col].x = (GLfloat)x * view->tile_width + half_w;
+            dst[col].y = (GLfloat)y * view->tile_height + half_h;
+            dst[col].sx = src[x].sx;
+            dst[col].sy = src[x].sy;
+        }
+    }
+    const unsigned char* base = stream_end(stream);
+
+    // Points are clipped by their centre: widen the viewport by half a sprite so edge tiles survive,
+    // with a projection that keeps world-to-window pixels unchanged
+    int margin = (int)(size * 0.5f) + 1;
+    glViewport(-margin, -margin, width + 2 * margin, height + 2 * margin);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(-margin, width + margin, height + margin, -margin, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glScalef(cam->zoom, cam->zoom, 1.0f);
+    glTranslatef(cam->offset_x, cam->offset_y, 0.0f);
+
+    state_enable(points->state, STATE_POINT_SPRITE | STATE_VERTEX_ARRAY | STATE_TEXCOORD_ARRAY);
+    state_disable(points->state, STATE_COLOR_ARRAY);
+    state_use_program(points->state, points->program);
+    glPointSize(size);
+
+    glVertexPointer(2, GL_FLOAT, sizeof(PointVertex), base + offsetof(PointVertex, x));
+    glTexCoordPointer(2, GL_SHORT, sizeof(PointVertex), base + offsetof(PointVertex, sx));
+    glDrawArrays(GL_POINTS, 0, count);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glViewport(0, 0, width, height);
+
+    if (stream->mode != STREAM_CLIENT) stream_fence(stream);
+
+    stats->draw_calls++;
+    stats->tiles_drawn += count;
+    stats->tiles_built += count;
+    stats->vertex_bytes += bytes;
+    stats->vertex_memory += stream->region_size * (stream->mode == STREAM_PERSISTENT ? STREAM_REGIONS : 1);
+    return 1;
+}
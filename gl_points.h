@@ -0,0 +1,57 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Point-sprite tile drawing: one vertex per visible tile instead of four. Each
+// vertex carries the tile centre and its tileset cell; GL_POINT_SPRITE expands
+// it to a square of glPointSize pixels and a small GLSL program looks the
+// texel up as (cell + gl_PointCoord) / grid, with gl_PointCoord mirrored and
+// transposed by the tile's transform bits. Needs GL 2.0, square tiles, and
+// an on-screen tile size within GL_ALIASED_POINT_SIZE_RANGE; points_draw
+// returns 0 otherwise and the caller draws quads instead.
+
+#ifndef GL_POINTS_H
+#define GL_POINTS_H
+
+#include "gl_ext.h"
+#include "gl_stream.h"
+#include "gl_state.h"
+#include "tilemap.h"
+
+typedef struct {
+    GLfloat x, y;                // Tile centre in world pixels
+    GLshort sx, sy;              // TileEntry as stored, transform bits included; read as gl_MultiTexCoord0
+} PointVertex;
+
+typedef struct {
+    GlState* state;
+    GLuint program;              // 0 when point sprites are unavailable
+    float max_point_size;
+} PointSprites;
+
+// Builds the sprite program for `tileset`; returns 0 (and leaves the path to quads) if unsupported
+int points_init(PointSprites* points, GlState* state, const Tileset* tileset);
+void points_free(PointSprites* points);
+
+// Streams one vertex per visible tile and draws them as sprites, leaving the sprite program
+// bound. `width`/`height` is the viewport, restored afterwards. Returns 0 without drawing if
+// the view can't use sprites.
+int points_draw(PointSprites* points, StreamBuffer* stream, const View* view, const TileMap* map,
+                int width, int height, FrameStats* stats);
+
+#endif
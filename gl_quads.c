@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gl_quads.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define QUAD_INDEX_COUNT (QUAD_INDEX_MAX_QUADS * 6)
+
+int quad_indices_init(QuadIndexBuffer* quads, GlState* state) {
+    const GlExtensions* ext = state->ext;
+    memset(quads, 0, sizeof(*quads));
+    quads->state = state;
+
+    GLushort* indices = malloc(sizeof(GLushort) * QUAD_INDEX_COUNT);
+    if (!indices) return 0;
+    for (int q = 0; q < QUAD_INDEX_MAX_QUADS; q++) {
+        GLushort v = (GLushort)(q * 4);
+        GLushort* i = &indices[q * 6];
+        i[0] = v;     i[1] = v + 1; i[2] = v + 2;
+        i[3] = v;     i[4] = v + 2; i[5] = v + 3;
+    }
+
+    if (ext->has_vbo) {
+        ext->GenBuffers(1, &quads->ibo);
+        state_bind_buffer(state, GL_ELEMENT_ARRAY_BUFFER, quads->ibo);
+        ext->BufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * QUAD_INDEX_COUNT, indices, GL_STATIC_DRAW);
+        free(indices);
+    } else {
+        quads->client = indices;
+    }
+    return 1;
+}
+
+void quad_indices_free(QuadIndexBuffer* quads) {
+    if (quads->ibo) state_delete_buffer(quads->state, quads->ibo);
+    free(quads->client);
+    quads->ibo = 0;
+    quads->client = NULL;
+}
+
+void draw_indexed_quads(const QuadIndexBuffer* quads, const QuadArrays* arrays, int quad_count,
+                        FrameStats* stats) {
+    // The index buffer stays bound between draws; the shadow state makes re-binding it free
+    const GLvoid* indices = quads->ibo ? NULL : (const GLvoid*)quads->client;
+    state_bind_buffer(quads->state, GL_ELEMENT_ARRAY_BUFFER, quads->ibo);
+    state_enable(quads->state, STATE_VERTEX_ARRAY | STATE_TEXCOORD_ARRAY);
+    if (arrays->colour_offset >= 0) state_enable(quads->state, STATE_COLOR_ARRAY);
+    else state_disable(quads->state, STATE_COLOR_ARRAY);
+
+    for (int first = 0; first < quad_count; first += QUAD_INDEX_MAX_QUADS) {
+        int count = quad_count - first < QUAD_INDEX_MAX_QUADS ? quad_count - first : QUAD_INDEX_MAX_QUADS;
+        const unsigned char* base = arrays->base + (size_t)first * 4 * arrays->stride;
+
+        glVertexPointer(2, arrays->type, arrays->stride, base);
+        glTexCoordPointer(2, arrays->type, arrays->stride, base + arrays->uv_offset);
+        if (arrays->colour_offset >= 0) glColorPointer(4, GL_UNSIGNED_BYTE, arrays->stride, base + arrays->colour_offset);
+        glDrawElements(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, indices);
+        stats->draw_calls++;
+    }
+    if (arrays->colour_offset >= 0) state_forget_colour(quads->state);
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Shared static index buffer for drawing quads as indexed triangles. The
+// buffer is built once per context for QUAD_INDEX_MAX_QUADS quads (0,1,2 /
+// 0,2,3 per quad) and reused by every batch and chunk, so each tile only
+// produces and transfers its four corner vertices. Batches larger than the
+// buffer are drawn in segments by advancing the vertex pointers.
+
+#ifndef GL_QUADS_H
+#define GL_QUADS_H
+
+#include "gl_ext.h"
+#include "gl_state.h"
+#include "tilemap.h"
+
+#define QUAD_INDEX_MAX_QUADS 16384        // 65536 vertices: the most GLushort indices can address
+
+typedef struct {
+    GlState* state;
+    GLuint ibo;                  // Element buffer, or 0 when buffer objects are unavailable
+    GLushort* client;            // Client-side copy used without buffer objects
+} QuadIndexBuffer;
+
+// --- Vertex arrays for a run of quads, four vertices each ---
+typedef struct {
+    const unsigned char* base;   // Client pointer, or offset into the bound GL_ARRAY_BUFFER
+    GLsizei stride;
+    GLenum type;                 // Component type of position and texture coordinates
+    int uv_offset;               // Byte offset of the texture coordinates within a vertex
+    int colour_offset;           // Byte offset of RGBA byte colours, or -1 to draw in the current colour
+} QuadArrays;
+
+int quad_indices_init(QuadIndexBuffer* quads, GlState* state);
+void quad_indices_free(QuadIndexBuffer* quads);
+
+// Sets the vertex/texcoord (and colour) pointers and draws `quad_count` quads with glDrawElements.
+// The vertex and texcoord arrays are enabled here and left enabled; the colour array follows
+// colour_offset.
+void draw_indexed_quads(const QuadIndexBuffer* quads, const QuadArrays* arrays, int quad_count,
+                        FrameStats* stats);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gl_readback.h"
+#include <string.h>
+
+void readback_init(PixelReadback* readback, GlState* state) {
+    memset(readback, 0, sizeof(*readback));
+    readback->state = state;
+}
+
+void readback_free(PixelReadback* readback) {
+    for (int i = 0; i < READBACK_BUFFERS; i++) {
+        if (readback->buffers[i]) state_delete_buffer(readback->state, readback->buffers[i]);
+        readback->buffers[i] = 0;
+    }
+}
+
+// --- Map the oldest pending buffer and queue its pixels ---
+static void retrieve(PixelReadback* readback, FrameWriter* writer) {
+    const GlExtensions* ext = readback->state->ext;
+    size_t bytes = (size_t)readback->width * readback->height * 4;
+
+    state_bind_buffer(readback->state, GL_PIXEL_PACK_BUFFER, readback->buffers[readback->retrieved % READBACK_BUFFERS]);
+    const void* pixels = ext->MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pixels) {
+        memcpy(capture_acquire(writer), pixels, bytes);
+        capture_submit(writer, 1);
+        ext->UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    readback->retrieved++;
+}
+
+void readback_frame(PixelReadback* readback, FrameWriter* writer, int width, int height) {
+    if (width != writer->width || height != writer->height) return;
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    if (!readback->state->ext->has_pbo) {
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, capture_acquire(writer));
+        capture_submit(writer, 1);
+        return;
+    }
+
+    const GlExtensions* ext = readback->state->ext;
+    if (readback->width != width || readback->height != height) {
+        readback_finish(readback, writer);
+        for (int i = 0; i < READBACK_BUFFERS; i++) {
+            if (!readback->buffers[i]) ext->GenBuffers(1, &readback->buffers[i]);
+            state_bind_buffer(readback->state, GL_PIXEL_PACK_BUFFER, readback->buffers[i]);
+            ext->BufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, NULL, GL_STREAM_READ);
+        }
+        readback->width = width;
+        readback->height = height;
+    }
+
+    state_bind_buffer(readback->state, GL_PIXEL_PACK_BUFFER, readback->buffers[readback->issued % READBACK_BUFFERS]);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    readback->issued++;
+
+    // Keep READBACK_BUFFERS - 1 frames in flight
+    if (readback->issued - readback->retrieved >= READBACK_BUFFERS) retrieve(readback, writer);
+    state_bind_buffer(readback->state, GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void readback_finish(PixelReadback* readback, FrameWriter* writer) {
+    while (readback->retrieved < readback->issued) retrieve(readback, writer);
+    state_bind_buffer(readback->state, GL_PIXEL_PACK_BUFFER, 0);
+}
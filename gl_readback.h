@@ -0,0 +1,51 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Asynchronous frame readback for capture. Each frame's glReadPixels goes
+// into the next of READBACK_BUFFERS pixel-pack buffers and returns at once;
+// the buffer filled READBACK_BUFFERS - 1 frames earlier, which the GPU has
+// long finished, is then mapped and copied into a FrameWriter slot. Without
+// pixel buffers the read is synchronous into the slot.
+
+#ifndef GL_READBACK_H
+#define GL_READBACK_H
+
+#include "gl_state.h"
+#include "capture.h"
+
+#define READBACK_BUFFERS 3                // Frame N is read while N-2 is copied out
+
+typedef struct {
+    GlState* state;
+    GLuint buffers[READBACK_BUFFERS];
+    int width, height;           // Size the buffers were allocated for
+    int issued;                  // Frames read into buffers so far
+    int retrieved;               // Frames copied out to the writer so far
+} PixelReadback;
+
+void readback_init(PixelReadback* readback, GlState* state);
+void readback_free(PixelReadback* readback);
+
+// Starts reading the current back buffer and hands completed older frames to `writer`.
+// Frames whose size differs from the writer's are skipped.
+void readback_frame(PixelReadback* readback, FrameWriter* writer, int width, int height);
+// Hands over every frame still in flight
+void readback_finish(PixelReadback* readback, FrameWriter* writer);
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gl_state.h"
+#include <string.h>
+#include <math.h>
+
+void state_init(GlState* state, const GlExtensions* ext) {
+    memset(state, 0, sizeof(*state));
+    state->ext = ext;
+    state->known_bits = ~0u;     // Everything starts disabled
+    state->colour[0] = state->colour[1] = state->colour[2] = state->colour[3] = 1.0f;
+}
+
+void state_invalidate(GlState* state) {
+    state->known_bits = 0;
+    state->texture = state->array_buffer = state->element_buffer = state->pack_buffer = STATE_UNKNOWN_NAME;
+    state->program = STATE_UNKNOWN_NAME;
+    state->colour[0] = state->colour[1] = state->colour[2] = state->colour[3] = NAN;
+}
+
+static void set_bit(GlState* state, Uint32 bit, int on) {
+    int current = (state->enabled & bit) != 0;
+    if ((state->known_bits & bit) && current == on) {
+        state->skipped++;
+        return;
+    }
+
+    GLenum cap = 0;
+    int client = 0;
+    switch (bit) {
+    case STATE_TEXTURE_2D:     cap = GL_TEXTURE_2D; break;
+    case STATE_SCISSOR_TEST:   cap = GL_SCISSOR_TEST; break;
+    case STATE_POINT_SPRITE:   cap = GL_POINT_SPRITE; break;
+    case STATE_BLEND:          cap = GL_BLEND; break;
+    case STATE_VERTEX_ARRAY:   cap = GL_VERTEX_ARRAY; client = 1; break;
+    case STATE_TEXCOORD_ARRAY: cap = GL_TEXTURE_COORD_ARRAY; client = 1; break;
+    case STATE_COLOR_ARRAY:    cap = GL_COLOR_ARRAY; client = 1; break;
+    default: return;
+    }
+
+    if (client) {
+        if (on) glEnableClientState(cap); else glDisableClientState(cap);
+    } else {
+        if (on) glEnable(cap); else glDisable(cap);
+    }
+    state->enabled = on ? (state->enabled | bit) : (state->enabled & ~bit);
+    state->known_bits |= bit;
+    state->issued++;
+}
+
+void state_enable(GlState* state, Uint32 bits) {
+    for (Uint32 bit = 1; bit <= STATE_COLOR_ARRAY; bit <<= 1) {
+        if (bits & bit) set_bit(state, bit, 1);
+    }
+}
+
+void state_disable(GlState* state, Uint32 bits) {
+    for (Uint32 bit = 1; bit <= STATE_COLOR_ARRAY; bit <<= 1) {
+        if (bits & bit) set_bit(state, bit, 0);
+    }
+}
+
+void state_bind_texture(GlState* state, GLuint texture) {
+    if (state->texture == texture) {
+        state->skipped++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    state->texture = texture;
+    state->issued++;
+}
+
+void state_bind_buffer(GlState* state, GLenum target, GLuint buffer) {
+    if (!state->ext->has_vbo) return;
+
+    GLuint* current = target == GL_ELEMENT_ARRAY_BUFFER ? &state->element_buffer :
+                      target == GL_PIXEL_PACK_BUFFER ? &state->pack_buffer : &state->array_buffer;
+    if (*current == buffer) {
+        state->skipped++;
+        return;
+    }
+    state->ext->BindBuffer(target, buffer);
+    *current = buffer;
+    state->issued++;
+}
+
+void state_use_program(GlState* state, GLuint program) {
+    if (!state->ext->has_shaders) return;
+    if (state->program == program) {
+        state->skipped++;
+        return;
+    }
+    state->ext->UseProgram(program);
+    state->program = program;
+    state->issued++;
+}
+
+void state_colour(GlState* state, GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    if (state->colour[0] == r && state->colour[1] == g &&
+        state->colour[2] == b && state->colour[3] == a) {
+        state->skipped++;
+        return;
+    }
+    glColor4f(r, g, b, a);
+    state->colour[0] = r;
+    state->colour[1] = g;
+    state->colour[2] = b;
+    state->colour[3] = a;
+    state->issued++;
+}
+
+void state_forget_colour(GlState* state) {
+    state->colour[0] = state->colour[1] = state->colour[2] = state->colour[3] = NAN;
+}
+
+void state_delete_texture(GlState* state, GLuint texture) {
+    if (!texture) return;
+    glDeleteTextures(1, &texture);
+    if (state->texture == texture) state->texture = 0;
+}
+
+void state_delete_buffer(GlState* state, GLuint buffer) {
+    if (!buffer) return;
+    state->ext->DeleteBuffers(1, &buffer);
+    if (state->array_buffer == buffer) state->array_buffer = 0;
+    if (state->element_buffer == buffer) state->element_buffer = 0;
+    if (state->pack_buffer == buffer) state->pack_buffer = 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Shadow copy of the GL state the backend touches. Every bind, enable and
+// colour change goes through here and is dropped when it would not change
+// anything, so draw code can simply declare what it needs before each draw
+// ("texturing on, white, this buffer") instead of restoring state after
+// itself. Issued and suppressed calls are counted for FrameStats.
+//
+// The shadow starts from the defaults of a fresh context; anything that
+// changes tracked state behind its back must call state_invalidate.
+
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "gl_ext.h"
+#include <SDL2/SDL.h>
+
+// --- Tracked capabilities (glEnable/glDisable) and client arrays ---
+#define STATE_TEXTURE_2D      0x01
+#define STATE_SCISSOR_TEST    0x02
+#define STATE_POINT_SPRITE    0x04
+#define STATE_BLEND           0x08
+#define STATE_VERTEX_ARRAY    0x10
+#define STATE_TEXCOORD_ARRAY  0x20
+#define STATE_COLOR_ARRAY     0x40
+
+#define STATE_UNKNOWN_NAME    0xFFFFFFFFu  // Never returned by glGen*/glCreate*
+
+typedef struct {
+    const GlExtensions* ext;
+    Uint32 enabled;              // STATE_* bits currently on
+    Uint32 known_bits;           // STATE_* bits whose value is known
+    GLuint texture;              // GL_TEXTURE_2D binding on unit 0; STATE_UNKNOWN_NAME when unknown
+    GLuint array_buffer;
+    GLuint element_buffer;
+    GLuint pack_buffer;          // GL_PIXEL_PACK_BUFFER
+    GLuint program;
+    GLfloat colour[4];           // NaN when unknown, so no colour compares equal
+    Uint64 issued;               // Calls passed through to GL
+    Uint64 skipped;              // Redundant calls suppressed
+} GlState;
+
+// Assumes a freshly created context with `ext` loaded
+void state_init(GlState* state, const GlExtensions* ext);
+// Forget everything; use after foreign code has touched GL state
+void state_invalidate(GlState* state);
+
+// `bits` is one STATE_* capability or client array
+void state_enable(GlState* state, Uint32 bits);
+void state_disable(GlState* state, Uint32 bits);
+void state_bind_texture(GlState* state, GLuint texture);
+void state_bind_buffer(GlState* state, GLenum target, GLuint buffer);
+void state_use_program(GlState* state, GLuint program);
+void state_colour(GlState* state, GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+// Drawing with the colour array on leaves the current colour undefined
+void state_forget_colour(GlState* state);
+
+// Deleting a bound object resets its binding to 0 in GL; these keep the shadow in step
+void state_delete_texture(GlState* state, GLuint texture);
+void state_delete_buffer(GlState* state, GLuint buffer);
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gl_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_MIN_REGION (64 * 1024)
+#define STREAM_WAIT_TIMEOUT_NS 1000000000ull
+
+const char* const stream_mode_names[] = { "persistent", "orphan", "client" };
+
+void stream_init(StreamBuffer* stream, GlState* state, StreamMode max_mode) {
+    const GlExtensions* ext = state->ext;
+    memset(stream, 0, sizeof(*stream));
+    stream->ext = ext;
+    stream->state = state;
+    stream->mode = max_mode;
+    if (stream->mode == STREAM_PERSISTENT && !ext->has_persistent) stream->mode = STREAM_ORPHAN;
+    if (stream->mode == STREAM_ORPHAN && !ext->has_vbo) stream->mode = STREAM_CLIENT;
+}
+
+static void release_buffer(StreamBuffer* stream) {
+    const GlExtensions* ext = stream->ext;
+    for (int i = 0; i < STREAM_REGIONS; i++) {
+        if (stream->fences[i]) ext->DeleteSync(stream->fences[i]);
+        stream->fences[i] = 0;
+    }
+    if (stream->buffer) {
+        // Deleting a mapped buffer unmaps it; the driver keeps it alive until pending draws finish
+        state_delete_buffer(stream->state, stream->buffer);
+        stream->buffer = 0;
+    }
+    stream->mapped = NULL;
+}
+
+void stream_free(StreamBuffer* stream) {
+    if (stream->mode != STREAM_CLIENT) release_buffer(stream);
+    free(stream->client);
+    stream->client = NULL;
+    stream->region_size = 0;
+}
+
+// --- Create immutable storage for all regions and map it for the buffer's lifetime ---
+static int create_persistent(StreamBuffer* stream, size_t region_size) {
+    const GlExtensions* ext = stream->ext;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr total = (GLsizeiptr)(region_size * STREAM_REGIONS);
+
+    ext->GenBuffers(1, &stream->buffer);
+    state_bind_buffer(stream->state, GL_ARRAY_BUFFER, stream->buffer);
+    ext->BufferStorage(GL_ARRAY_BUFFER, total, NULL, flags);
+    stream->mapped = ext->MapBufferRange(GL_ARRAY_BUFFER, 0, total, flags);
+    return stream->mapped != NULL;
+}
+
+static int ensure_capacity(StreamBuffer* stream, size_t bytes) {
+    if (bytes <= stream->region_size) return 1;
+
+    size_t size = stream->region_size ? stream->region_size : STREAM_MIN_REGION;
+    while (size < bytes) size *= 2;
+
+    switch (stream->mode) {
+    case STREAM_PERSISTENT:
+        release_buffer(stream);
+        if (create_persistent(stream, size)) break;
+        printf("Persistent mapping failed, falling back to orphaning\n");
+        release_buffer(stream);
+        stream->mode = STREAM_ORPHAN;
+        // fall through
+    case STREAM_ORPHAN:
+        if (!stream->buffer) stream->ext->GenBuffers(1, &stream->buffer);
+        break;
+    case STREAM_CLIENT: {
+        unsigned char* client = realloc(stream->client, size);
+        if (!client) return 0;
+        stream->client = client;
+        break;
+    }
+    }
+    stream->region_size = size;
+    stream->region = 0;
+    return 1;
+}
+
+// --- Block until the GPU has finished reading the region we are about to overwrite ---
+static void wait_region(StreamBuffer* stream, FrameStats* stats) {
+    const GlExtensions* ext = stream->ext;
+    GLsync fence = stream->fences[stream->region];
+    if (!fence) return;
+
+    GLenum result = ext->ClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        stats->fence_waits++;
+        do {
+            result = ext->ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_WAIT_TIMEOUT_NS);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    ext->DeleteSync(fence);
+    stream->fences[stream->region] = 0;
+}
+
+void* stream_begin(StreamBuffer* stream, size_t bytes, FrameStats* stats) {
+    if (!ensure_capacity(stream, bytes)) return NULL;
+    stats->bytes_streamed += bytes;
+
+    const GlExtensions* ext = stream->ext;
+    switch (stream->mode) {
+    case STREAM_PERSISTENT:
+        stream->region = (stream->region + 1) % STREAM_REGIONS;
+        wait_region(stream, stats);
+        state_bind_buffer(stream->state, GL_ARRAY_BUFFER, stream->buffer);
+        return stream->mapped + (size_t)stream->region * stream->region_size;
+    case STREAM_ORPHAN:
+        state_bind_buffer(stream->state, GL_ARRAY_BUFFER, stream->buffer);
+        ext->BufferData(GL_ARRAY_BUFFER, (GLsizeiptr)stream->region_size, NULL, GL_STREAM_DRAW);
+        stream->mapped = ext->MapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+        if (stream->mapped) return stream->mapped;
+        // Deleting the buffer also unbinds it, so client arrays are not read as buffer offsets
+        printf("Buffer mapping failed, falling back to client arrays\n");
+        release_buffer(stream);
+        stream->mode = STREAM_CLIENT;
+        stream->region_size = 0;
+        if (!ensure_capacity(stream, bytes)) return NULL;
+        return stream->client;
+    case STREAM_CLIENT:
+        return stream->client;
+    }
+    return NULL;
+}
+
+const unsigned char* stream_end(StreamBuffer* stream) {
+    switch (stream->mode) {
+    case STREAM_PERSISTENT:
+        // Coherent mapping: no flush or unmap needed, just point at our region
+        return (const unsigned char*)((size_t)stream->region * stream->region_size);
+    case STREAM_ORPHAN:
+        stream->ext->UnmapBuffer(GL_ARRAY_BUFFER);
+        stream->mapped = NULL;
+        return (const unsigned char*)0;
+    case STREAM_CLIENT:
+        state_bind_buffer(stream->state, GL_ARRAY_BUFFER, 0);
+        return stream->client;
+    }
+    return NULL;
+}
+
+void stream_fence(StreamBuffer* stream) {
+    const GlExtensions* ext = stream->ext;
+    if (stream->mode == STREAM_PERSISTENT) {
+        stream->fences[stream->region] = ext->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
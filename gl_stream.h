@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Per-frame vertex streaming. The best available mode is picked at init:
+//   persistent - one buffer created with glBufferStorage, mapped once with
+//                MAP_PERSISTENT | MAP_COHERENT and split into STREAM_REGIONS
+//                regions; each frame writes the next region after waiting on
+//                the fence placed when that region was last drawn from
+//   orphan     - glBufferData(NULL) to orphan the previous contents, then
+//                glMapBuffer to write the new ones; a failed map drops to
+//                client for the rest of the session
+//   client     - plain client memory handed to gl*Pointer (GL 1.1)
+
+#ifndef GL_STREAM_H
+#define GL_STREAM_H
+
+#include "gl_ext.h"
+#include "gl_state.h"
+#include "tilemap.h"
+#include <stddef.h>
+
+#define STREAM_REGIONS 3
+
+typedef enum { STREAM_PERSISTENT, STREAM_ORPHAN, STREAM_CLIENT } StreamMode;
+
+typedef struct {
+    const GlExtensions* ext;
+    GlState* state;
+    StreamMode mode;
+    GLuint buffer;
+    size_t region_size;          // Bytes per region (the whole buffer outside persistent mode)
+    int region;                  // Region written by the current frame
+    unsigned char* mapped;       // Persistent mapping or the current glMapBuffer pointer
+    unsigned char* client;       // Storage for the client mode
+    GLsync fences[STREAM_REGIONS];
+} StreamBuffer;
+
+extern const char* const stream_mode_names[];
+
+// Picks the best mode supported by the context, or a lower one if `max_mode` asks for it
+void stream_init(StreamBuffer* stream, GlState* state, StreamMode max_mode);
+void stream_free(StreamBuffer* stream);
+
+// Returns `bytes` of writable memory for this frame's vertices, or NULL on failure
+void* stream_begin(StreamBuffer* stream, size_t bytes, FrameStats* stats);
+// Finishes writing and leaves the matching GL_ARRAY_BUFFER bound (0 for client memory);
+// returns the base to pass to gl*Pointer (an offset when a buffer is bound)
+const unsigned char* stream_end(StreamBuffer* stream);
+// Call after the draw calls that read this frame's vertices
+void stream_fence(StreamBuffer* stream);
+
+#endif
@@ -17,184 +17,602 @@
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
-// Compile with: gcc main.c -o tilemap_demo -lSDL2 -lSDL2_image -lm -std=c99
-
-#include <SDL2/SDL.h>
+// Compile with: gcc main.c tilemap.c render.c render_sdl.c render_gl.c render_soft.c soft_raster.c gl_ext.c gl_state.c gl_stream.c gl_chunks.c gl_quads.c gl_points.c gl_readback.c visset.c bench.c capture.c blend.c export.c server.c map_store.c tile_index.c regions.c pathfind.c raycast.c entities.c fog.c autotile.c tint.c -o tilemap_demo -lSDL2 -lSDL2_image -lGL -lz -lm -std=c99 -fopenmp
+
+#include "tilemap.h"
+#include "render.h"
+#include "bench.h"
+#include "export.h"
+#include "server.h"
+#include "map_store.h"
+#include "pathfind.h"
+#include "entities.h"
+#include "fog.h"
+#include "autotile.h"
+#include "tint.h"
 #include <SDL2/SDL_image.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-#include <math.h>
-
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 600
-#define MAP_WIDTH 1000
-#define MAP_HEIGHT 1000
 
-typedef struct {
-    char* filepath;
-    int tile_width;
-    int tile_height;
-    int rows;
-    int cols;
-    SDL_Texture* texture;
-} Tileset;
+#define FOG_CURSOR_RADIUS 12              // Sight of the observer following the cursor with --fog
+#define TINT_HEAT_LEVELS 16               // Palette entries of the --tint heat map
 
 typedef struct {
-    int tiles[MAP_HEIGHT][MAP_WIDTH];
-} TileMap;
+    const char* backend;
+    const char* path;
+    const char* tileset;
+    int map_width, map_height;
+    int layers;
+    int entities;
+    int fog;
+    int tint;
+    int autotile;
+    int transforms;
+    unsigned int seed;
+    int bench;
+    Uint32 render_flags;
+    const char* capture;
+    const char* microbench;
+    ExportOptions export_options;
+    const char* serve;
+    const char* share_map;
+    const char* attach_map;
+    LoadOptions load_options;
+    BenchOptions bench_options;
+} Options;
+
+static void print_usage(const char* argv0) {
+    printf("Usage: %s [options]\n", argv0);
+    printf("  --backend NAME     Render backend (default: %s)\n", renderer_backends[0]->name);
+    printf("  --path NAME        Drawing path of the backend (default: its first path)\n");
+    printf("  --tileset FILE     Tileset image (default: tileset.png)\n");
+    printf("  --map WxH          Map size in tiles (default: %dx%d)\n", MAP_WIDTH, MAP_HEIGHT);
+    printf("  --layers N         Tile layers, composited bottom to top by the soft backend (default: 1, max %d)\n",
+           MAX_LAYERS);
+    printf("  --entities N       Moving sprites drawn over the map by the GL batched and visset paths\n");
+    printf("  --fog              GL: fog of war; the hovered tile sees %d tiles around it\n", FOG_CURSOR_RADIUS);
+    printf("  --tint             GL: tint tiles with a heat map carried in the vertex stream (immediate, batched, visset)\n");
+    printf("  --transforms       Mirror and rotate every tile at random\n");
+    printf("  --autotile         Base layer from terrain blobs and neighbour rules; right-drag paints terrain\n");
+    printf("  --share-map NAME   Keep the map in shared memory NAME; right-click edits reach attached viewers\n");
+    printf("  --attach-map NAME  Draw the map another process shares as NAME instead of generating one\n");
+    printf("  --seed N           Random seed for the map (default: time, 1 for benchmarks)\n");
+    printf("  --damage           Damage tracking: only redraw what changed since the last frame\n");
+    printf("  --stream MODE      GL vertex streaming: persistent, orphan or client (default: best available)\n");
+    printf("  --gl-quads         GL: draw batches with GL_QUADS instead of indexed triangles\n");
+    printf("  --capture FILE     Record frames to FILE (.y4m for YUV4MPEG2, otherwise raw RGBA)\n");
+    printf("  --export FILE      Render the whole map to FILE (.png, otherwise raw RGBA) instead of the viewer\n");
+    printf("  --export-xyz DIR   Write a z/x/y pyramid of %dpx PNG tiles to DIR, rewriting changed tiles only\n",
+           XYZ_TILE_SIZE);
+    printf("  --export-zoom Z    Output pixels per tileset pixel for --export, or the deepest --export-xyz level (default: 1)\n");
+    printf("  --serve SOCKET     Answer viewport requests on a Unix socket instead of the viewer\n");
+    printf("  --load SOCKET      Send requests to a --serve instance and report throughput and latency\n");
+    printf("  --clients N        Connections for --load (default: 8)\n");
+    printf("  --requests N       Requests per connection for --load (default: 200)\n");
+    printf("  --request-size WxH Image size asked for by --load (default: %dx%d)\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    printf("  --request-rgba     --load asks for raw RGBA instead of PNG\n");
+    printf("  --bench            Run the benchmark scenarios instead of the viewer\n");
+    printf("  --frames N         Frames per benchmark scenario (default: 300)\n");
+    printf("  --scenario NAME    Only run one benchmark scenario\n");
+    printf("  --microbench NAME  Run one component microbenchmark, or all, instead of the viewer\n");
+    printf("  --list             List backends, paths and microbenchmarks\n");
+    printf("With --bench, --backend and --path restrict the sweep instead of selecting.\n");
+}
 
-int load_tileset(SDL_Renderer* renderer, Tileset* tileset) {
-    SDL_Surface* surface = IMG_Load(tileset->filepath);
-    if (!surface) {
-        printf("IMG_Load failed: %s\n", IMG_GetError());
-        return 0;
+static void print_backends(void) {
+    for (int b = 0; b < renderer_backend_count; b++) {
+        printf("%s:", renderer_backends[b]->name);
+        for (int p = 0; p < renderer_backends[b]->path_count; p++) {
+            printf(" %s", renderer_backends[b]->path_names[p]);
+        }
+        printf("\n");
     }
-    tileset->texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
+}
 
-    if (!tileset->texture) {
-        printf("SDL_CreateTextureFromSurface failed: %s\n", SDL_GetError());
-        return 0;
-    }
+// --- Only the GL batched paths append entity quads to their vertex stream ---
+static int path_draws_entities(const RendererBackend* backend, int path) {
+    const char* name = backend->path_names[path];
+    return backend == &gl_backend && (strcmp(name, "batched") == 0 || strcmp(name, "visset") == 0);
+}
+
+// --- Every GL path shades the fog over its tiles; the sdl and soft backends draw none ---
+static int path_draws_fog(const RendererBackend* backend) {
+    return backend == &gl_backend;
+}
+
+// --- Tints ride in the visible set's vertex colours, or one glColor per tile on the immediate path ---
+static int path_draws_tints(const RendererBackend* backend, int path) {
+    const char* name = backend->path_names[path];
+    return backend == &gl_backend && (strcmp(name, "immediate") == 0 || strcmp(name, "batched") == 0 ||
+                                      strcmp(name, "visset") == 0);
+}
 
+// --- Returns 0 to exit with `*status` ---
+static int parse_options(int argc, char* argv[], Options* options, int* status) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--bench") == 0) {
+            options->bench = 1;
+        } else if (strcmp(arg, "--damage") == 0) {
+            options->render_flags |= RENDER_DAMAGE_TRACKING;
+        } else if (strcmp(arg, "--request-rgba") == 0) {
+            options->load_options.format = SERVER_FORMAT_RGBA;
+        } else if (strcmp(arg, "--fog") == 0) {
+            options->fog = 1;
+        } else if (strcmp(arg, "--tint") == 0) {
+            options->tint = 1;
+        } else if (strcmp(arg, "--transforms") == 0) {
+            options->transforms = 1;
+        } else if (strcmp(arg, "--autotile") == 0) {
+            options->autotile = 1;
+        } else if (strcmp(arg, "--gl-quads") == 0) {
+            options->render_flags |= RENDER_GL_QUADS;
+        } else if (strcmp(arg, "--list") == 0) {
+            print_backends();
+            printf("Microbenchmarks:\n");
+            print_microbenches();
+            *status = 0;
+            return 0;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            *status = 0;
+            return 0;
+        } else if (!value) {
+            printf("Missing value for %s\n", arg);
+            print_usage(argv[0]);
+            *status = 1;
+            return 0;
+        } else {
+            i++;
+            if (strcmp(arg, "--backend") == 0) options->backend = value;
+            else if (strcmp(arg, "--path") == 0) options->path = value;
+            else if (strcmp(arg, "--tileset") == 0) options->tileset = value;
+            else if (strcmp(arg, "--seed") == 0) options->seed = (unsigned int)strtoul(value, NULL, 10);
+            else if (strcmp(arg, "--frames") == 0) options->bench_options.frames = atoi(value);
+            else if (strcmp(arg, "--scenario") == 0) options->bench_options.scenario = value;
+            else if (strcmp(arg, "--capture") == 0) options->capture = value;
+            else if (strcmp(arg, "--microbench") == 0) options->microbench = value;
+            else if (strcmp(arg, "--export") == 0) options->export_options.path = value;
+            else if (strcmp(arg, "--serve") == 0) options->serve = value;
+            else if (strcmp(arg, "--share-map") == 0) options->share_map = value;
+            else if (strcmp(arg, "--attach-map") == 0) options->attach_map = value;
+            else if (strcmp(arg, "--load") == 0) options->load_options.socket_path = value;
+            else if (strcmp(arg, "--clients") == 0) options->load_options.clients = atoi(value);
+            else if (strcmp(arg, "--requests") == 0) options->load_options.requests = atoi(value);
+            else if (strcmp(arg, "--request-size") == 0) {
+                if (sscanf(value, "%dx%d", &options->load_options.width, &options->load_options.height) != 2 ||
+                    options->load_options.width < 1 || options->load_options.height < 1) {
+                    printf("Invalid request size: %s\n", value);
+                    *status = 1;
+                    return 0;
+                }
+            }
+            else if (strcmp(arg, "--export-xyz") == 0) {
+                options->export_options.path = value;
+                options->export_options.pyramid = 1;
+            }
+            else if (strcmp(arg, "--export-zoom") == 0) options->export_options.zoom = (float)atof(value);
+            else if (strcmp(arg, "--entities") == 0) options->entities = atoi(value);
+            else if (strcmp(arg, "--layers") == 0) {
+                options->layers = atoi(value);
+                if (options->layers < 1 || options->layers > MAX_LAYERS) {
+                    printf("Layer count must be 1..%d\n", MAX_LAYERS);
+                    *status = 1;
+                    return 0;
+                }
+            }
+            else if (strcmp(arg, "--stream") == 0) {
+                if (strcmp(value, "orphan") == 0) options->render_flags |= RENDER_STREAM_ORPHAN;
+                else if (strcmp(value, "client") == 0) options->render_flags |= RENDER_STREAM_CLIENT;
+                else if (strcmp(value, "persistent") != 0) {
+                    printf("Unknown stream mode: %s\n", value);
+                    *status = 1;
+                    return 0;
+                }
+            }
+            else if (strcmp(arg, "--map") == 0) {
+                if (sscanf(value, "%dx%d", &options->map_width, &options->map_height) != 2 ||
+                    options->map_width < 1 || options->map_height < 1) {
+                    printf("Invalid map size: %s\n", value);
+                    *status = 1;
+                    return 0;
+                }
+            } else {
+                printf("Unknown option: %s\n", arg);
+                print_usage(argv[0]);
+                *status = 1;
+                return 0;
+            }
+        }
+    }
+    if (options->bench_options.frames < 1) options->bench_options.frames = 1;
+    if (options->load_options.clients < 1) options->load_options.clients = 1;
+    if (options->load_options.clients > SERVER_MAX_CLIENTS) options->load_options.clients = SERVER_MAX_CLIENTS;
+    if (options->load_options.requests < 1) options->load_options.requests = 1;
     return 1;
 }
 
-void fill_random_tilemap(TileMap* map, int max_tile_index) {
-    for (int y = 0; y < MAP_HEIGHT; y++) {
-        for (int x = 0; x < MAP_WIDTH; x++) {
-            map->tiles[y][x] = rand() % max_tile_index;
+static void handle_events(int* running, int* dragging, int* painting, int* picking, int* last_mouse_x,
+                   int* last_mouse_y, Camera* camera, Renderer* renderer) {
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        if (e.type == SDL_QUIT) *running = 0;
+        else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
+            *dragging = 1;
+            *last_mouse_x = e.button.x;
+            *last_mouse_y = e.button.y;
+        } else if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT) {
+            *dragging = 0;
+        } else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_RIGHT) {
+            *painting = 1;
+        } else if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_RIGHT) {
+            *painting = 0;
+        } else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_MIDDLE) {
+            *picking = 1;
+        } else if (e.type == SDL_MOUSEMOTION && *dragging) {
+            camera_pan(camera, e.motion.x - *last_mouse_x, e.motion.y - *last_mouse_y);
+            *last_mouse_x = e.motion.x;
+            *last_mouse_y = e.motion.y;
+        } else if (e.type == SDL_MOUSEWHEEL) {
+            int mx, my;
+            SDL_GetMouseState(&mx, &my);
+            camera_zoom_at(camera, mx, my, (e.wheel.y > 0) ? ZOOM_STEP : (1.0f / ZOOM_STEP));
+        } else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_RESIZED) {
+            renderer->backend->resize(renderer->impl, e.window.data1, e.window.data2);
         }
     }
 }
 
-int main(int argc, char* argv[]) {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0 || IMG_Init(IMG_INIT_PNG) == 0) {
-        printf("SDL_Init or IMG_Init failed: %s\n", SDL_GetError());
-        return 1;
+// --- Right-drag edits: each newly hovered base tile steps to the next tileset cell ---
+static void paint_tile(TileMap* map, const Tileset* tileset, const View* view, int* last_x, int* last_y) {
+    if (view->hover_x < 0 || (view->hover_x == *last_x && view->hover_y == *last_y)) return;
+    *last_x = view->hover_x;
+    *last_y = view->hover_y;
+
+    TileEntry tile = map->tiles[(size_t)view->hover_y * map->width + view->hover_x];
+    int next = (tile_index_of(tileset, tile) + 1) % (tileset->cols * tileset->rows);
+    tile = tile_make(next % tileset->cols, next / tileset->cols, tile_transform(tile));
+    tilemap_set_tile(map, 0, view->hover_x, view->hover_y, tile);
+}
+
+// --- With --autotile the hovered cell steps to the next terrain instead, retiling its neighbours ---
+static void paint_terrain(Autotiler* autotiler, const View* view, int* last_x, int* last_y) {
+    if (view->hover_x < 0 || (view->hover_x == *last_x && view->hover_y == *last_y)) return;
+    *last_x = view->hover_x;
+    *last_y = view->hover_y;
+
+    int terrain = autotile_terrain(autotiler, view->hover_x, view->hover_y) + 1;
+    autotile_paint(autotiler, view->hover_x, view->hover_y, terrain % autotiler->rules->terrain_count);
+}
+
+// --- Middle click sets a path start; the hovered tile is the goal, re-pathed when it or the map changes ---
+typedef struct {
+    PathMap* paths;          // Built on the first middle click
+    int start_x, start_y;
+    int goal_x, goal_y;
+    Uint32 revision;
+    int steps;               // -1 when there is no path
+    double micros;
+} PathProbe;
+
+// The graph follows local edits through the map listener; a map reloaded from shared memory is rebuilt
+static int path_probe_build(PathProbe* probe, TileMap* map, const Tileset* tileset) {
+    static Uint8 walkable[MAX_TILESET_CELLS * MAX_TILESET_CELLS];
+    path_default_walkable(walkable, tileset);
+    if (probe->paths) {
+        path_map_free(probe->paths);
+    } else {
+        probe->paths = malloc(sizeof(PathMap));
+        if (!probe->paths || !tilemap_add_listener(map, path_on_edit, probe->paths)) {
+            free(probe->paths);
+            probe->paths = NULL;
+            return 0;
+        }
     }
+    probe->goal_x = -1;
+    if (path_map_create(probe->paths, map, walkable)) return 1;
+    tilemap_remove_listener(map, path_on_edit, probe->paths);
+    free(probe->paths);
+    probe->paths = NULL;
+    return 0;
+}
 
-    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+static void path_probe_update(PathProbe* probe, TileMap* map, const Tileset* tileset, const View* view,
+                              int picking, int map_reloaded) {
+    if (probe->paths && map_reloaded && !path_probe_build(probe, map, tileset)) return;
+    if (picking && view->hover_x >= 0) {
+        if (!probe->paths && !path_probe_build(probe, map, tileset)) return;
+        probe->start_x = view->hover_x;
+        probe->start_y = view->hover_y;
+        probe->goal_x = -1;
+    }
+    if (!probe->paths || view->hover_x < 0) return;
+    if (view->hover_x == probe->goal_x && view->hover_y == probe->goal_y && map->revision == probe->revision) return;
+
+    PathQuery query = { probe->start_x, probe->start_y, view->hover_x, view->hover_y };
+    PathResult result;
+    Uint64 start = SDL_GetPerformanceCounter();
+    probe->steps = path_find(probe->paths, &query, &result) ? result.cost : -1;
+    probe->micros = seconds_since(start) * 1e6;
+    path_result_free(&result);
+    probe->goal_x = view->hover_x;
+    probe->goal_y = view->hover_y;
+    probe->revision = map->revision;
+}
 
-    SDL_Window* window = SDL_CreateWindow("Tilemap Demo", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+static void path_probe_close(PathProbe* probe, TileMap* map) {
+    if (!probe->paths) return;
+    tilemap_remove_listener(map, path_on_edit, probe->paths);
+    path_map_free(probe->paths);
+    free(probe->paths);
+    probe->paths = NULL;
+}
 
-    Tileset tileset = {"tileset.png", 32, 32, 0, 0, NULL};
-    if (!load_tileset(renderer, &tileset)) return 1;
+static int run_viewer(const RendererBackend* backend, int path, Uint32 flags, const char* capture_path,
+                      int entity_count, int use_fog, int use_tint, Autotiler* autotiler, const Tileset* tileset, TileMap* map,
+                      MapStore* store) {
+    // Recordings have a fixed frame size, so capturing pins the window size
+    FrameWriter capture, *writer = NULL;
+    if (capture_path) {
+        if (!capture_open(&capture, capture_path, SCREEN_WIDTH, SCREEN_HEIGHT)) return 1;
+        writer = &capture;
+    }
 
-    int tex_w, tex_h;
-    SDL_QueryTexture(tileset.texture, NULL, NULL, &tex_w, &tex_h);
-    tileset.cols = tex_w / tileset.tile_width;
-    tileset.rows = tex_h / tileset.tile_height;
+    Renderer renderer;
+    if (!renderer_open(&renderer, backend, path, flags, "Tilemap", SCREEN_WIDTH, SCREEN_HEIGHT,
+                       SDL_WINDOW_SHOWN | (writer ? 0 : SDL_WINDOW_RESIZABLE), tileset, map)) {
+        if (writer) capture_close(writer);
+        return 1;
+    }
 
-    TileMap map;
-    srand((unsigned int)time(NULL));
-    fill_random_tilemap(&map, tileset.cols * tileset.rows);
+    EntityLayer entities, *sprites = NULL;
+    FogMap fog_map, *fog = NULL;
+    TintMap tint_map, *tints = NULL;
+    int ok = 1;
+    if (entity_count > 0 && (ok = entities_create(&entities, map, entity_count))) {
+        unsigned int seed = (unsigned int)rand();
+        entities_spawn_random(&entities, entity_count, tileset, &seed);
+        sprites = &entities;
+    }
+    if (ok && use_fog && (ok = fog_create(&fog_map, map->width, map->height, NULL))) {
+        fog = &fog_map;
+        ok = fog_add_observer(fog, map->width / 2, map->height / 2, FOG_CURSOR_RADIUS) >= 0;
+    }
+    if (ok && use_tint && (ok = tint_create(&tint_map, map->width, map->height))) {
+        tints = &tint_map;
+        tint_fill_heat(tints, TINT_HEAT_LEVELS, (unsigned int)rand());
+    }
+    if (!ok) {
+        if (sprites) entities_free(sprites);
+        if (fog) fog_free(fog);
+        if (tints) tint_free(tints);
+        renderer_close(&renderer);
+        if (writer) capture_close(writer);
+        return 1;
+    }
+    Uint32 last_ticks = SDL_GetTicks();
 
-    float offset_x = (MAP_WIDTH * tileset.tile_width - SCREEN_WIDTH) / -2.0f;
-    float offset_y = (MAP_HEIGHT * tileset.tile_height - SCREEN_HEIGHT) / -2.0f;
-    int zoom = 1; // Integer zoom only: 1, 2, etc.
+    Camera camera = { 0.0f, 0.0f, 1.0f, SCREEN_WIDTH, SCREEN_HEIGHT };
+    camera_center(&camera, map, tileset);
 
-    int dragging = 0;
+    int dragging = 0, painting = 0, picking = 0;
     int last_mouse_x = 0, last_mouse_y = 0;
+    int painted_x = -1, painted_y = -1;
+    int can_edit = !store || store->writer;
 
     Uint32 fps_last_time = SDL_GetTicks();
     int fps_frames = 0;
+    DamageTracker tracker = {0};
+    PathProbe probe = {0};
 
-    SDL_Event e;
     int running = 1;
-
     while (running) {
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) running = 0;
-            else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
-                dragging = 1;
-                last_mouse_x = e.button.x;
-                last_mouse_y = e.button.y;
-            } else if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT) {
-                dragging = 0;
-            } else if (e.type == SDL_MOUSEMOTION && dragging) {
-                offset_x += (e.motion.x - last_mouse_x) / (float)zoom;
-                offset_y += (e.motion.y - last_mouse_y) / (float)zoom;
-                last_mouse_x = e.motion.x;
-                last_mouse_y = e.motion.y;
-            } else if (e.type == SDL_MOUSEWHEEL) {
-                if (e.wheel.y > 0 && zoom < 4) zoom *= 2;
-                else if (e.wheel.y < 0 && zoom > 1) zoom /= 2;
-            }
-        }
-
-        SDL_RenderClear(renderer);
-
-        int tile_screen_w = tileset.tile_width * zoom;
-        int tile_screen_h = tileset.tile_height * zoom;
-
-        int min_x = (int)(-offset_x / tileset.tile_width);
-        int min_y = (int)(-offset_y / tileset.tile_height);
-        int max_x = (int)((SCREEN_WIDTH / (float)zoom - offset_x) / tileset.tile_width) + 1;
-        int max_y = (int)((SCREEN_HEIGHT / (float)zoom - offset_y) / tileset.tile_height) + 1;
+        picking = 0;
+        handle_events(&running, &dragging, &painting, &picking, &last_mouse_x, &last_mouse_y, &camera, &renderer);
+        int reloaded = store && !store->writer && map_store_poll(store, map);
 
-        if (min_x < 0) min_x = 0;
-        if (min_y < 0) min_y = 0;
-        if (max_x > MAP_WIDTH) max_x = MAP_WIDTH;
-        if (max_y > MAP_HEIGHT) max_y = MAP_HEIGHT;
-
-        for (int y = min_y; y < max_y; y++) {
-            for (int x = min_x; x < max_x; x++) {
-                int tile_index = map.tiles[y][x];
-                int sx = (tile_index % tileset.cols) * tileset.tile_width;
-                int sy = (tile_index / tileset.cols) * tileset.tile_height;
-                SDL_Rect src = {sx, sy, tileset.tile_width, tileset.tile_height};
-
-                int dx = (x * tileset.tile_width + (int)offset_x) * zoom;
-                int dy = (y * tileset.tile_height + (int)offset_y) * zoom;
-                SDL_Rect dst = {dx, dy, tile_screen_w, tile_screen_h};
-
-                SDL_RenderCopy(renderer, tileset.texture, &src, &dst);
-            }
-        }
+        // Get current window size (important if user resized)
+        SDL_GetWindowSize(renderer.window, &camera.screen_w, &camera.screen_h);
 
         int mx, my;
         SDL_GetMouseState(&mx, &my);
-        int tile_x = (mx / zoom - (int)offset_x) / tileset.tile_width;
-        int tile_y = (my / zoom - (int)offset_y) / tileset.tile_height;
-
-        if (tile_x >= 0 && tile_x < MAP_WIDTH && tile_y >= 0 && tile_y < MAP_HEIGHT) {
-            SDL_Rect highlight = {
-                (tile_x * tileset.tile_width + (int)offset_x) * zoom,
-                (tile_y * tileset.tile_height + (int)offset_y) * zoom,
-                tile_screen_w,
-                tile_screen_h
-            };
-            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-            SDL_SetRenderDrawColor(renderer, 255, 255, 0, 100);
-            SDL_RenderFillRect(renderer, &highlight);
-        }
-
-        SDL_RenderPresent(renderer);
 
+        View view;
+        FrameStats stats = {0};
+        view_compute(&view, &camera, map, tileset, mx, my);
+        if (painting && can_edit) {
+            if (autotiler) paint_terrain(autotiler, &view, &painted_x, &painted_y);
+            else paint_tile(map, tileset, &view, &painted_x, &painted_y);
+            if (store) map_store_publish(store, map);
+        } else {
+            painted_x = painted_y = -1;
+        }
+        path_probe_update(&probe, map, tileset, &view, picking, reloaded);
+        if (sprites) {
+            Uint32 ticks = SDL_GetTicks();
+            entities_update(sprites, (ticks - last_ticks) / 1000.0f);
+            entities_collect(sprites, &view);
+            view.entities = sprites;
+            last_ticks = ticks;
+        }
+        if (fog) {
+            if (view.hover_x >= 0) fog_move_observer(fog, 0, view.hover_x, view.hover_y);
+            fog_update(fog);
+            view.fog = fog;
+        }
+        view.tints = tints;
+        if (flags & RENDER_DAMAGE_TRACKING) damage_update(&tracker, &view, map);
+        if (sprites || (fog && fog->dirty_count)) view.damage = DAMAGE_FULL;
+        backend->draw(renderer.impl, &view, &stats);
+        if (fog) fog_clear_dirty(fog);
+        renderer_capture(&renderer, writer, 0);
+        backend->present(renderer.impl);
+
+        // --- FPS COUNTER ---
         fps_frames++;
         Uint32 fps_current_time = SDL_GetTicks();
         if (fps_current_time > fps_last_time + 1000) {
             float fps = fps_frames * 1000.0f / (fps_current_time - fps_last_time);
-            char title[128];
-            snprintf(title, sizeof(title), "Tilemap Demo - FPS: %.2f (Zoom: %dx)", fps, zoom);
-            SDL_SetWindowTitle(window, title);
+            char title[192], path_info[64] = "", entity_info[48] = "";
+            if (probe.paths) {
+                if (probe.steps >= 0) snprintf(path_info, sizeof(path_info), " | Path: %d steps, %.0f us", probe.steps, probe.micros);
+                else snprintf(path_info, sizeof(path_info), " | Path: none");
+            }
+            if (sprites) snprintf(entity_info, sizeof(entity_info), " | Entities: %d/%d", stats.entities_drawn, sprites->count);
+            snprintf(title, sizeof(title), "Tilemap %s/%s - FPS: %.2f | Zoom: %.3f | LOD: %d | Draws: %d%s%s",
+                     backend->name, backend->path_names[path], fps, camera.zoom, stats.lod, stats.draw_calls, path_info,
+                     entity_info);
+            SDL_SetWindowTitle(renderer.window, title); // Display FPS and zoom level in the title bar
 
             fps_last_time = fps_current_time;
             fps_frames = 0;
         }
 
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_Delay(16);
+        SDL_Delay(16); // Optional cap to ~60 FPS
     }
 
-    SDL_DestroyTexture(tileset.texture);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    IMG_Quit();
-    SDL_Quit();
+    path_probe_close(&probe, map);
+    if (sprites) entities_free(sprites);
+    if (fog) fog_free(fog);
+    if (tints) tint_free(tints);
+    renderer_capture(&renderer, writer, 1);
+    renderer_close(&renderer);
+    if (writer) capture_close(writer);
     return 0;
 }
 
+int main(int argc, char* argv[]) {
+    Options options = {0};
+    options.tileset = "tileset.png";
+    options.map_width = MAP_WIDTH;
+    options.map_height = MAP_HEIGHT;
+    options.layers = 1;
+    options.export_options.zoom = 1.0f;
+    options.load_options.clients = 8;
+    options.load_options.requests = 200;
+    options.load_options.width = SCREEN_WIDTH;
+    options.load_options.height = SCREEN_HEIGHT;
+    options.bench_options.frames = 300;
+    options.bench_options.width = SCREEN_WIDTH;
+    options.bench_options.height = SCREEN_HEIGHT;
+
+    int status = 0;
+    if (!parse_options(argc, argv, &options, &status)) return status;
+
+    const RendererBackend* backend = renderer_backends[0];
+    int path = 0;
+    if (options.backend && !(backend = find_backend(options.backend))) {
+        printf("Unknown backend: %s\n", options.backend);
+        print_backends();
+        return 1;
+    }
+    if (options.path && (path = find_backend_path(backend, options.path)) < 0 && !options.bench) {
+        printf("Backend %s has no path %s\n", backend->name, options.path);
+        print_backends();
+        return 1;
+    }
+
+    // Exports, the server and microbenchmarks never open a window, so they also run without a display
+    int headless = options.microbench || options.export_options.path || options.serve ||
+                   options.load_options.socket_path;
+    if (SDL_Init(headless ? 0 : SDL_INIT_VIDEO) != 0 || IMG_Init(IMG_INIT_PNG) == 0) {
+        printf("SDL_Init or IMG_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // The load generator only needs the map size, which must match the server's
+    if (options.load_options.socket_path) {
+        status = run_load(&options.load_options, options.map_width * TILE_WIDTH, options.map_height * TILE_HEIGHT) ? 0 : 1;
+        IMG_Quit();
+        SDL_Quit();
+        return status;
+    }
+
+    Tileset tileset = { (char*)options.tileset, TILE_WIDTH, TILE_HEIGHT, 0, 0, NULL, NULL, NULL };
+    TileMap map = {0};
+    MapStore shared, *store = NULL;
+    int map_ok;
+    if (options.attach_map) {
+        map_ok = map_store_attach(&shared, options.attach_map, &map);
+        store = &shared;
+    } else if (options.share_map) {
+        map_ok = map_store_create(&shared, options.share_map, &map, options.map_width, options.map_height,
+                                  options.layers);
+        store = &shared;
+    } else {
+        map_ok = tilemap_create(&map, options.map_width, options.map_height, options.layers);
+    }
+    if (!load_tileset(&tileset) || !map_ok) {
+        if (store) map_store_close(store, &map);
+        else tilemap_destroy(&map);
+        free_tileset(&tileset);
+        IMG_Quit();
+        SDL_Quit();
+        return 1;
+    }
+
+    // Benchmarks use a fixed seed unless one is given so runs are comparable
+    if (!options.seed) options.seed = (options.bench || options.microbench) ? 1u : (unsigned int)time(NULL);
+    srand(options.seed);
+    if (!options.attach_map) fill_random_tilemap(&map, tileset.cols * tileset.rows, &tileset);
+    if (options.transforms && !options.attach_map) fill_random_transforms(&map);
+
+    // Terrain replaces the random base layer; tilesets too small for two blob terrains get edge rules
+    static AutotileRules autotile_rules;
+    Autotiler autotile_state, *autotiler = NULL;
+    if (options.autotile && !options.attach_map) {
+        int cells = tileset.cols * tileset.rows;
+        autotile_default_rules(&autotile_rules, &tileset, cells >= 2 * AUTOTILE_BLOB_TILES ? AUTOTILE_8 : AUTOTILE_4);
+        if (autotile_create(&autotile_state, &map, 0, &autotile_rules)) {
+            autotiler = &autotile_state;
+            autotile_fill_random(autotiler, options.seed);
+            autotile_apply_all(autotiler);
+        }
+    }
+    if (options.share_map) map_store_publish(store, &map);
+
+    if (options.microbench) {
+        status = run_microbench(options.microbench, &tileset, &map) > 0 ? 0 : 1;
+    } else if (options.serve) {
+        status = run_server(options.serve, &tileset, &map) ? 0 : 1;
+    } else if (options.export_options.path) {
+        status = export_map(&options.export_options, &tileset, &map) ? 0 : 1;
+    } else if (options.bench) {
+        options.bench_options.backend = options.backend;
+        options.bench_options.path = options.path;
+        options.bench_options.render_flags = options.render_flags;
+        options.bench_options.capture = options.capture;
+        status = run_bench(&options.bench_options, &tileset, &map) > 0 ? 0 : 1;
+    } else {
+        // Entities on other paths would only cost a full redraw every frame without showing up
+        if (options.entities > 0 && !path_draws_entities(backend, path)) {
+            printf("--entities needs the gl backend's batched or visset path, ignoring it on %s/%s\n",
+                   backend->name, backend->path_names[path]);
+            options.entities = 0;
+        }
+        // A fog nobody draws would still force full redraws whenever the observer moves
+        if (options.fog && !path_draws_fog(backend)) {
+            printf("--fog needs the gl backend, ignoring it on %s/%s\n", backend->name, backend->path_names[path]);
+            options.fog = 0;
+        }
+        if (options.tint && !path_draws_tints(backend, path)) {
+            printf("--tint needs the gl backend's immediate, batched or visset path, ignoring it on %s/%s\n",
+                   backend->name, backend->path_names[path]);
+            options.tint = 0;
+        }
+        status = run_viewer(backend, path, options.render_flags, options.capture, options.entities, options.fog,
+                            options.tint, autotiler, &tileset, &map, store);
+    }
+
+    if (autotiler) autotile_free(autotiler);
+    if (store) map_store_close(store, &map);
+    else tilemap_destroy(&map);
+    free_tileset(&tileset);
+    IMG_Quit();
+    SDL_Quit();
+    return status;
+}
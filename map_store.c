@@ -0,0 +1,200 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L      // shm_open, ftruncate and mmap under -std=c99
+
+#include "map_store.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int map_store_create(MapStore* store, const char* name, TileMap* map, int width, int height, int layers) {
+    (void)store;
+    (void)name;
+    (void)map;
+    (void)width;
+    (void)height;
+    (void)layers;
+    printf("Shared maps need POSIX shared memory\n");
+    return 0;
+}
+
+int map_store_attach(MapStore* store, const char* name, TileMap* map) {
+    return map_store_create(store, name, map, 0, 0, 0);
+}
+
+void map_store_publish(MapStore* store, const TileMap* map) {
+    (void)store;
+    (void)map;
+}
+
+int map_store_poll(MapStore* store, TileMap* map) {
+    (void)store;
+    (void)map;
+    return 0;
+}
+
+void map_store_close(MapStore* store, TileMap* map) {
+    (void)store;
+    (void)map;
+}
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static size_t align_up(size_t value) {
+    return (value + MAP_STORE_ALIGN - 1) & ~(size_t)(MAP_STORE_ALIGN - 1);
+}
+
+static int set_name(MapStore* store, const char* name) {
+    // POSIX names are "/something" with no further slashes
+    if (strchr(name, '/') || strlen(name) + 2 > sizeof(store->name)) {
+        printf("Invalid shared map name: %s\n", name);
+        return 0;
+    }
+    snprintf(store->name, sizeof(store->name), "/%s", name);
+    return 1;
+}
+
+static void point_map(MapStore* store, TileMap* map) {
+    const MapStoreHeader* header = store->header;
+    unsigned char* base = store->base;
+    map->width = header->width;
+    map->height = header->height;
+    map->layers = header->layers;
+    map->chunks_x = header->chunks_x;
+    map->chunks_y = header->chunks_y;
+    map->chunk_versions = (Uint32*)(base + header->versions_offset);
+    map->tiles = (TileEntry*)(base + header->tiles_offset);
+    map->revision = header->revision;
+    map->listener_count = 0;
+}
+
+int map_store_create(MapStore* store, const char* name, TileMap* map, int width, int height, int layers) {
+    memset(store, 0, sizeof(*store));
+    if (!set_name(store, name)) return 0;
+
+    int chunks_x = (width + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    int chunks_y = (height + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    size_t versions_offset = align_up(sizeof(MapStoreHeader));
+    size_t tiles_offset = align_up(versions_offset + sizeof(Uint32) * (size_t)chunks_x * chunks_y);
+    store->size = tiles_offset + sizeof(TileEntry) * (size_t)width * height * layers;
+
+    // A fresh segment each time, so readers of an old one never see a resize
+    shm_unlink(store->name);
+    int fd = shm_open(store->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)store->size) != 0) {
+        perror(store->name);
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(store->name);
+        }
+        return 0;
+    }
+    store->base = mmap(NULL, store->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (store->base == MAP_FAILED) {
+        perror("mmap");
+        shm_unlink(store->name);
+        store->base = NULL;
+        return 0;
+    }
+
+    // ftruncate zero-fills, so every chunk version starts at revision 0
+    store->writer = 1;
+    store->header = store->base;
+    MapStoreHeader* header = store->header;
+    header->magic = MAP_STORE_MAGIC;
+    header->entry_size = sizeof(TileEntry);
+    header->width = width;
+    header->height = height;
+    header->layers = layers;
+    header->chunks_x = chunks_x;
+    header->chunks_y = chunks_y;
+    header->versions_offset = versions_offset;
+    header->tiles_offset = tiles_offset;
+    point_map(store, map);
+    printf("Shared map %s: %dx%dx%d, %.1f MB\n", store->name, width, height, layers, store->size / 1048576.0);
+    return 1;
+}
+
+int map_store_attach(MapStore* store, const char* name, TileMap* map) {
+    memset(store, 0, sizeof(*store));
+    if (!set_name(store, name)) return 0;
+
+    int fd = shm_open(store->name, O_RDONLY, 0);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(MapStoreHeader)) {
+        printf("No shared map %s (start a viewer with --share-map %s first)\n", store->name, name);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    store->size = (size_t)info.st_size;
+    store->base = mmap(NULL, store->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (store->base == MAP_FAILED) {
+        perror("mmap");
+        store->base = NULL;
+        return 0;
+    }
+
+    store->header = store->base;
+    const MapStoreHeader* header = store->header;
+    int ready = header->ready;
+    SDL_MemoryBarrierAcquire();
+    if (!ready || header->magic != MAP_STORE_MAGIC || header->entry_size != sizeof(TileEntry) ||
+        header->tiles_offset + sizeof(TileEntry) * (size_t)header->width * header->height * header->layers >
+        store->size) {
+        printf("Shared map %s is not ready or from an incompatible build\n", store->name);
+        map_store_close(store, map);
+        return 0;
+    }
+    point_map(store, map);
+    printf("Attached shared map %s: %dx%dx%d, %.1f MB, revision %u\n", store->name, map->width, map->height,
+           map->layers, store->size / 1048576.0, map->revision);
+    return 1;
+}
+
+void map_store_publish(MapStore* store, const TileMap* map) {
+    SDL_MemoryBarrierRelease();
+    store->header->revision = map->revision;
+    store->header->ready = 1;
+}
+
+int map_store_poll(MapStore* store, TileMap* map) {
+    Uint32 revision = store->header->revision;
+    SDL_MemoryBarrierAcquire();
+    if (revision == map->revision) return 0;
+    map->revision = revision;
+    return 1;
+}
+
+void map_store_close(MapStore* store, TileMap* map) {
+    if (store->base) munmap(store->base, store->size);
+    if (store->writer) shm_unlink(store->name);
+    memset(store, 0, sizeof(*store));
+    map->tiles = NULL;
+    map->chunk_versions = NULL;
+}
+
+#endif
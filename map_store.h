@@ -0,0 +1,71 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+// Map storage in a named POSIX shared memory segment, so several viewer
+// processes on one host draw one copy of a large map. One process creates
+// the segment and is its only writer; the others attach it read-only and
+// their TileMap.tiles and chunk_versions point straight into it, so nothing
+// is copied. Edits go through tilemap_set_tile in the writer, which orders
+// the tile store before the chunk version; map_store_publish then makes the
+// new revision visible. Readers call map_store_poll once a frame to adopt
+// it, after which the usual per-chunk version checks rebuild only the
+// chunks that changed.
+//
+// Segment layout: MapStoreHeader, chunk versions, then the layer planes.
+
+#ifndef MAP_STORE_H
+#define MAP_STORE_H
+
+#include "tilemap.h"
+
+#define MAP_STORE_MAGIC 0x5350414Du       // "MAPS"
+#define MAP_STORE_ALIGN 64                // Sections start on their own cache line
+
+typedef struct {
+    Uint32 magic;
+    Uint32 entry_size;           // sizeof(TileEntry), so mismatched builds refuse to attach
+    Sint32 width, height, layers;
+    Sint32 chunks_x, chunks_y;
+    volatile Uint32 ready;       // Set by the writer once the tiles are filled in
+    volatile Uint32 revision;    // Last published map revision
+    Uint32 pad;
+    Uint64 versions_offset;
+    Uint64 tiles_offset;
+} MapStoreHeader;
+
+typedef struct {
+    char name[64];               // Segment name, with the leading '/'
+    int writer;
+    void* base;
+    size_t size;
+    MapStoreHeader* header;
+} MapStore;
+
+// Creates (replacing any old one) and maps the segment for writing, and points `map` into it.
+// Fill the tiles, then call map_store_publish to let readers attach.
+int map_store_create(MapStore* store, const char* name, TileMap* map, int width, int height, int layers);
+// Maps an existing, published segment read-only; the map size comes from the segment
+int map_store_attach(MapStore* store, const char* name, TileMap* map);
+// Writer: publishes map->revision after edits
+void map_store_publish(MapStore* store, const TileMap* map);
+// Reader: adopts the published revision; returns 1 when it changed
+int map_store_poll(MapStore* store, TileMap* map);
+// Unmaps; the writer also removes the name (attached readers keep their mapping)
+void map_store_close(MapStore* store, TileMap* map);
+
+#endif
@@ -0,0 +1,696 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pathfind.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PATH_LONG_ENTRANCE 6             // Runs at least this wide get a transition at each end
+#define PATH_TIE_SCALE 1024              // Abstract f = g + h * 1025/1024: among the many equal-cost grid paths,
+                                         // head for the goal instead of widening the search
+#define LOCAL_SIDE (MAP_CHUNK_TILES + 2)  // One cluster with a blocked frame, so local searches skip bounds checks
+#define LOCAL_CELLS (LOCAL_SIDE * LOCAL_SIDE)
+#define PATH_BENCH_QUERIES 2048
+#define PATH_BENCH_SINGLE_QUERIES 256
+#define PATH_BENCH_FLAT_QUERIES 8        // Plain A* is slow enough that a few show the difference
+#define PATH_BENCH_EDITS 1024
+
+// --- Binary min-heap on f, deeper nodes first among equals ---
+typedef struct {
+    Uint32 f, g;
+    Uint32 node;
+} HeapItem;
+
+typedef struct {
+    HeapItem* items;
+    size_t count, capacity;
+} PathHeap;
+
+static int heap_less(const HeapItem* a, const HeapItem* b) {
+    return a->f < b->f || (a->f == b->f && a->g > b->g);
+}
+
+static int heap_push(PathHeap* heap, Uint32 f, Uint32 g, Uint32 node) {
+    if (heap->count == heap->capacity) {
+        size_t capacity = heap->capacity ? heap->capacity * 2 : 1024;
+        HeapItem* items = realloc(heap->items, sizeof(HeapItem) * capacity);
+        if (!items) {
+            printf("Failed to grow the path search heap to %zu entries\n", capacity);
+            return 0;
+        }
+        heap->items = items;
+        heap->capacity = capacity;
+    }
+    size_t i = heap->count++;
+    HeapItem item = { f, g, node };
+    while (i > 0 && heap_less(&item, &heap->items[(i - 1) / 2])) {
+        heap->items[i] = heap->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->items[i] = item;
+    return 1;
+}
+
+static HeapItem heap_pop(PathHeap* heap) {
+    HeapItem top = heap->items[0];
+    HeapItem last = heap->items[--heap->count];
+    size_t i = 0;
+    for (;;) {
+        size_t child = i * 2 + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap_less(&heap->items[child + 1], &heap->items[child])) child++;
+        if (!heap_less(&heap->items[child], &last)) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0) heap->items[i] = last;
+    return top;
+}
+
+// --- Per-worker search state. Node slots are cluster * PATH_MAX_CLUSTER_NODES + node, then start and
+// goal; a slot's g and parent only count when its stamp is the current generation ---
+struct PathSearch {
+    size_t slots;
+    Uint32* stamp;
+    Uint32* g;
+    Uint32* parent;
+    Uint32 generation;
+    PathHeap heap;
+    Uint32* waypoints;
+    size_t waypoint_capacity;
+    Uint16 start_dist[PATH_MAX_CLUSTER_NODES];
+    Uint16 goal_dist[PATH_MAX_CLUSTER_NODES];
+    int local_cluster;                      // Cluster copied into local_open, or -1
+    Uint8 local_open[LOCAL_CELLS];          // By local_index
+    Uint16 local_dist[LOCAL_CELLS];
+    Uint16 local_parent[LOCAL_CELLS];
+    Uint16 local_queue[LOCAL_CELLS];
+    PathHeap local_heap;
+};
+
+typedef struct {
+    int x0, y0, x1, y1;
+} ClusterRect;
+
+static ClusterRect cluster_rect(const PathMap* paths, int c) {
+    ClusterRect r;
+    r.x0 = (c % paths->clusters_x) * MAP_CHUNK_TILES;
+    r.y0 = (c / paths->clusters_x) * MAP_CHUNK_TILES;
+    r.x1 = r.x0 + MAP_CHUNK_TILES < paths->map->width ? r.x0 + MAP_CHUNK_TILES : paths->map->width;
+    r.y1 = r.y0 + MAP_CHUNK_TILES < paths->map->height ? r.y0 + MAP_CHUNK_TILES : paths->map->height;
+    return r;
+}
+
+static int cluster_of(const PathMap* paths, int x, int y) {
+    return (y / MAP_CHUNK_TILES) * paths->clusters_x + x / MAP_CHUNK_TILES;
+}
+
+static int tile_walkable(const PathMap* paths, TileEntry tile) {
+    return paths->walkable[tile_cell(tile)];
+}
+
+static int cell_walkable(const PathMap* paths, int x, int y) {
+    return paths->open[(size_t)y * paths->map->width + x];
+}
+
+static int local_index(const ClusterRect* r, int x, int y) {
+    return (y - r->y0 + 1) * LOCAL_SIDE + x - r->x0 + 1;
+}
+
+static const int local_steps[4] = { -1, 1, -LOCAL_SIDE, LOCAL_SIDE };
+
+static ClusterRect load_cluster(const PathMap* paths, PathSearch* search, int c) {
+    ClusterRect r = cluster_rect(paths, c);
+    if (search->local_cluster == c) return r;
+    memset(search->local_open, 0, sizeof(search->local_open));
+    for (int y = r.y0; y < r.y1; y++) {
+        memcpy(&search->local_open[local_index(&r, r.x0, y)], &paths->open[(size_t)y * paths->map->width + r.x0], r.x1 - r.x0);
+    }
+    search->local_cluster = c;
+    return r;
+}
+
+// Breadth-first steps from (sx, sy) to every tile of its cluster, into local_dist
+static void local_distances(const PathMap* paths, PathSearch* search, int sx, int sy) {
+    ClusterRect r = load_cluster(paths, search, cluster_of(paths, sx, sy));
+    memset(search->local_dist, 0xFF, sizeof(search->local_dist));
+
+    int head = 0, tail = 0;
+    int start = local_index(&r, sx, sy);
+    search->local_dist[start] = 0;
+    search->local_queue[tail++] = (Uint16)start;
+    while (head < tail) {
+        int i = search->local_queue[head++];
+        Uint16 next = (Uint16)(search->local_dist[i] + 1);
+        for (int d = 0; d < 4; d++) {
+            int j = i + local_steps[d];
+            if (!search->local_open[j] || search->local_dist[j] != PATH_UNREACHABLE) continue;
+            search->local_dist[j] = next;
+            search->local_queue[tail++] = (Uint16)j;
+        }
+    }
+}
+
+// A* from (sx, sy) to (gx, gy) inside their shared cluster; appends the steps after the start to `out`
+static int local_path(const PathMap* paths, PathSearch* search, int sx, int sy, int gx, int gy,
+                      SDL_Point* out, int* out_count, int out_capacity) {
+    ClusterRect r = load_cluster(paths, search, cluster_of(paths, sx, sy));
+    memset(search->local_dist, 0xFF, sizeof(search->local_dist));
+
+    PathHeap* heap = &search->local_heap;
+    heap->count = 0;
+    int start = local_index(&r, sx, sy), goal = local_index(&r, gx, gy);
+    int goal_lx = goal % LOCAL_SIDE, goal_ly = goal / LOCAL_SIDE;
+    search->local_dist[start] = 0;
+    if (!heap_push(heap, (Uint32)(abs(gx - sx) + abs(gy - sy)), 0, (Uint32)start)) return 0;
+
+    while (heap->count > 0) {
+        HeapItem item = heap_pop(heap);
+        int i = (int)item.node;
+        if (item.g > search->local_dist[i]) continue;
+        if (i == goal) break;
+        for (int d = 0; d < 4; d++) {
+            int j = i + local_steps[d];
+            Uint32 g = item.g + 1;
+            if (!search->local_open[j] || g >= search->local_dist[j]) continue;
+            search->local_dist[j] = (Uint16)g;
+            search->local_parent[j] = (Uint16)i;
+            Uint32 h = (Uint32)(abs(goal_lx - j % LOCAL_SIDE) + abs(goal_ly - j / LOCAL_SIDE));
+            if (!heap_push(heap, g + h, g, (Uint32)j)) return 0;
+        }
+    }
+    int steps = search->local_dist[goal];
+    if (steps == PATH_UNREACHABLE || *out_count + steps > out_capacity) return 0;
+
+    // Walk back from the goal, writing the steps in forward order
+    int i = goal;
+    for (int s = steps - 1; s >= 0; s--) {
+        out[*out_count + s].x = r.x0 + i % LOCAL_SIDE - 1;
+        out[*out_count + s].y = r.y0 + i / LOCAL_SIDE - 1;
+        i = search->local_parent[i];
+    }
+    *out_count += steps;
+    return 1;
+}
+
+// --- Abstract graph ---
+static void add_node(PathCluster* cluster, int x, int y) {
+    for (int i = 0; i < cluster->node_count; i++) {
+        if (cluster->node_x[i] == x && cluster->node_y[i] == y) return;   // Corner shared by two borders
+    }
+    cluster->node_x[cluster->node_count] = (Uint16)x;
+    cluster->node_y[cluster->node_count] = (Uint16)y;
+    cluster->node_count++;
+}
+
+// Transitions along one border of `length` tiles from (x, y), stepping (step_x, step_y), facing (dx, dy).
+// Both clusters of a border find the same runs, so their transitions always pair up
+static void add_border(const PathMap* paths, PathCluster* cluster, int x, int y, int step_x, int step_y,
+                       int dx, int dy, int length) {
+    int run = 0;
+    for (int i = 0; i <= length; i++) {
+        int cx = x + i * step_x, cy = y + i * step_y;
+        if (i < length && cell_walkable(paths, cx, cy) && cell_walkable(paths, cx + dx, cy + dy)) {
+            run++;
+            continue;
+        }
+        if (run == 0) continue;
+        int first = i - run, last = i - 1;
+        if (run >= PATH_LONG_ENTRANCE) {
+            add_node(cluster, x + first * step_x, y + first * step_y);
+            add_node(cluster, x + last * step_x, y + last * step_y);
+        } else {
+            int mid = (first + last) / 2;
+            add_node(cluster, x + mid * step_x, y + mid * step_y);
+        }
+        run = 0;
+    }
+}
+
+static int build_cluster(PathMap* paths, PathSearch* search, int c) {
+    PathCluster* cluster = &paths->clusters[c];
+    ClusterRect r = cluster_rect(paths, c);
+    int cx = c % paths->clusters_x, cy = c / paths->clusters_x;
+
+    cluster->node_count = 0;
+    if (cx > 0) add_border(paths, cluster, r.x0, r.y0, 0, 1, -1, 0, r.y1 - r.y0);
+    if (cx + 1 < paths->clusters_x) add_border(paths, cluster, r.x1 - 1, r.y0, 0, 1, 1, 0, r.y1 - r.y0);
+    if (cy > 0) add_border(paths, cluster, r.x0, r.y0, 1, 0, 0, -1, r.x1 - r.x0);
+    if (cy + 1 < paths->clusters_y) add_border(paths, cluster, r.x0, r.y1 - 1, 1, 0, 0, 1, r.x1 - r.x0);
+
+    int n = cluster->node_count;
+    search->local_cluster = -1;
+    free(cluster->dist);
+    cluster->dist = n ? malloc(sizeof(Uint16) * n * n) : NULL;
+    if (n && !cluster->dist) {
+        printf("Failed to allocate the distances of %d path nodes\n", n);
+        cluster->node_count = 0;
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        local_distances(paths, search, cluster->node_x[i], cluster->node_y[i]);
+        for (int j = 0; j < n; j++) {
+            cluster->dist[i * n + j] = search->local_dist[local_index(&r, cluster->node_x[j], cluster->node_y[j])];
+        }
+    }
+    return 1;
+}
+
+static PathSearch* search_create(void) {
+    PathSearch* search = calloc(1, sizeof(PathSearch));
+    if (!search) printf("Failed to allocate a path search\n");
+    else search->local_cluster = -1;
+    return search;
+}
+
+static void search_free(PathSearch* search) {
+    if (!search) return;
+    free(search->stamp);
+    free(search->g);
+    free(search->parent);
+    free(search->heap.items);
+    free(search->local_heap.items);
+    free(search->waypoints);
+    free(search);
+}
+
+void path_default_walkable(Uint8* walkable, const Tileset* tileset) {
+    memset(walkable, 0, MAX_TILESET_CELLS * MAX_TILESET_CELLS);
+    for (int index = 0; index < tileset->cols * tileset->rows; index++) {
+        walkable[(index / tileset->cols) * MAX_TILESET_CELLS + index % tileset->cols] = index % 8 != 0;
+    }
+}
+
+int path_map_create(PathMap* paths, const TileMap* map, const Uint8* walkable) {
+    memset(paths, 0, sizeof(*paths));
+    paths->map = map;
+    memcpy(paths->walkable, walkable, sizeof(paths->walkable));
+    paths->clusters_x = map->chunks_x;
+    paths->clusters_y = map->chunks_y;
+    paths->search_count = SDL_GetCPUCount();
+    paths->clusters = calloc((size_t)paths->clusters_x * paths->clusters_y, sizeof(PathCluster));
+    paths->searches = calloc(paths->search_count, sizeof(PathSearch*));
+    size_t tile_count = (size_t)map->width * map->height;
+    paths->open = malloc(tile_count);
+    int ok = paths->clusters && paths->searches && paths->open;
+    for (int k = 0; ok && k < paths->search_count; k++) ok = (paths->searches[k] = search_create()) != NULL;
+    if (!ok) {
+        printf("Failed to allocate the path graph of %dx%d clusters\n", paths->clusters_x, paths->clusters_y);
+        path_map_free(paths);
+        return 0;
+    }
+
+    for (size_t i = 0; i < tile_count; i++) paths->open[i] = (Uint8)tile_walkable(paths, map->tiles[i]);
+    int cluster_count = paths->clusters_x * paths->clusters_y;
+    int built = 1;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(&&:built)
+    for (int k = 0; k < paths->search_count; k++) {
+        for (int c = k; c < cluster_count; c += paths->search_count) built = build_cluster(paths, paths->searches[k], c) && built;
+    }
+    if (!built) {
+        path_map_free(paths);
+        return 0;
+    }
+    return 1;
+}
+
+void path_map_free(PathMap* paths) {
+    if (paths->clusters) {
+        for (int c = 0; c < paths->clusters_x * paths->clusters_y; c++) free(paths->clusters[c].dist);
+    }
+    for (int k = 0; paths->searches && k < paths->search_count; k++) search_free(paths->searches[k]);
+    free(paths->clusters);
+    free(paths->searches);
+    free(paths->open);
+    paths->clusters = NULL;
+    paths->searches = NULL;
+    paths->open = NULL;
+}
+
+void path_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile) {
+    PathMap* paths = user;
+    if (layer != 0 || tile_walkable(paths, old_tile) == tile_walkable(paths, new_tile)) return;
+    paths->open[(size_t)y * paths->map->width + x] = (Uint8)tile_walkable(paths, new_tile);
+
+    // Inside a cluster only its distances change; on a border the entrances of both sides do too
+    int c = cluster_of(paths, x, y);
+    ClusterRect r = cluster_rect(paths, c);
+    PathSearch* search = paths->searches[0];
+    build_cluster(paths, search, c);
+    if (x == r.x0 && x > 0) build_cluster(paths, search, c - 1);
+    if (x == r.x1 - 1 && c % paths->clusters_x + 1 < paths->clusters_x) build_cluster(paths, search, c + 1);
+    if (y == r.y0 && y > 0) build_cluster(paths, search, c - paths->clusters_x);
+    if (y == r.y1 - 1 && c / paths->clusters_x + 1 < paths->clusters_y) build_cluster(paths, search, c + paths->clusters_x);
+}
+
+// --- Queries ---
+static int search_prepare(const PathMap* paths, PathSearch* search) {
+    if (search->stamp) return 1;
+    size_t slots = (size_t)paths->clusters_x * paths->clusters_y * PATH_MAX_CLUSTER_NODES + 2;
+    search->stamp = calloc(slots, sizeof(Uint32));
+    search->g = malloc(sizeof(Uint32) * slots);
+    search->parent = malloc(sizeof(Uint32) * slots);
+    if (!search->stamp || !search->g || !search->parent) {
+        printf("Failed to allocate path search state for %zu nodes\n", slots);
+        free(search->stamp);
+        free(search->g);
+        free(search->parent);
+        search->stamp = search->g = search->parent = NULL;
+        return 0;
+    }
+    search->slots = slots;
+    search->generation = 0;
+    return 1;
+}
+
+static int relax(PathSearch* search, Uint32 node, Uint32 g, Uint32 from, int x, int y, const PathQuery* query) {
+    if (search->stamp[node] == search->generation && search->g[node] <= g) return 1;
+    search->stamp[node] = search->generation;
+    search->g[node] = g;
+    search->parent[node] = from;
+    Uint32 h = (Uint32)(abs(query->goal_x - x) + abs(query->goal_y - y));
+    return heap_push(&search->heap, g * PATH_TIE_SCALE + h * (PATH_TIE_SCALE + 1), g, node);
+}
+
+static void node_position(const PathMap* paths, const PathSearch* search, const PathQuery* query, Uint32 node,
+                          int* x, int* y) {
+    if (node == search->slots - 2) {
+        *x = query->start_x;
+        *y = query->start_y;
+    } else if (node == search->slots - 1) {
+        *x = query->goal_x;
+        *y = query->goal_y;
+    } else {
+        const PathCluster* cluster = &paths->clusters[node / PATH_MAX_CLUSTER_NODES];
+        *x = cluster->node_x[node % PATH_MAX_CLUSTER_NODES];
+        *y = cluster->node_y[node % PATH_MAX_CLUSTER_NODES];
+    }
+}
+
+// Abstract A* from start to goal over the transition nodes, with start and goal linked into their clusters
+static int abstract_search(const PathMap* paths, PathSearch* search, const PathQuery* query) {
+    Uint32 start = (Uint32)search->slots - 2, goal = (Uint32)search->slots - 1;
+    int sc = cluster_of(paths, query->start_x, query->start_y);
+    int gc = cluster_of(paths, query->goal_x, query->goal_y);
+    const PathCluster* start_cluster = &paths->clusters[sc];
+    const PathCluster* goal_cluster = &paths->clusters[gc];
+    ClusterRect sr = cluster_rect(paths, sc), gr = cluster_rect(paths, gc);
+
+    local_distances(paths, search, query->start_x, query->start_y);
+    for (int i = 0; i < start_cluster->node_count; i++) {
+        search->start_dist[i] = search->local_dist[local_index(&sr, start_cluster->node_x[i], start_cluster->node_y[i])];
+    }
+    Uint16 direct = sc == gc ? search->local_dist[local_index(&sr, query->goal_x, query->goal_y)] : PATH_UNREACHABLE;
+    local_distances(paths, search, query->goal_x, query->goal_y);
+    for (int i = 0; i < goal_cluster->node_count; i++) {
+        search->goal_dist[i] = search->local_dist[local_index(&gr, goal_cluster->node_x[i], goal_cluster->node_y[i])];
+    }
+
+    if (++search->generation == 0) {
+        memset(search->stamp, 0, sizeof(Uint32) * search->slots);
+        search->generation = 1;
+    }
+    search->heap.count = 0;
+    if (!relax(search, start, 0, start, query->start_x, query->start_y, query)) return 0;
+
+    while (search->heap.count > 0) {
+        HeapItem item = heap_pop(&search->heap);
+        Uint32 n = item.node;
+        if (item.g > search->g[n]) continue;
+        if (n == goal) return 1;
+
+        int ok = 1;
+        if (n == start) {
+            for (int i = 0; i < start_cluster->node_count; i++) {
+                if (search->start_dist[i] == PATH_UNREACHABLE) continue;
+                ok &= relax(search, (Uint32)(sc * PATH_MAX_CLUSTER_NODES + i), search->start_dist[i], n,
+                            start_cluster->node_x[i], start_cluster->node_y[i], query);
+            }
+            if (direct != PATH_UNREACHABLE) ok &= relax(search, goal, direct, n, query->goal_x, query->goal_y, query);
+            if (!ok) return 0;
+            continue;
+        }
+
+        int c = (int)(n / PATH_MAX_CLUSTER_NODES), i = (int)(n % PATH_MAX_CLUSTER_NODES);
+        const PathCluster* cluster = &paths->clusters[c];
+        int x = cluster->node_x[i], y = cluster->node_y[i];
+        for (int j = 0; j < cluster->node_count; j++) {
+            Uint16 d = cluster->dist[i * cluster->node_count + j];
+            if (j == i || d == PATH_UNREACHABLE) continue;
+            ok &= relax(search, (Uint32)(c * PATH_MAX_CLUSTER_NODES + j), item.g + d, n,
+                        cluster->node_x[j], cluster->node_y[j], query);
+        }
+        // The transition paired with this one across a border
+        static const int dx[4] = { -1, 1, 0, 0 }, dy[4] = { 0, 0, -1, 1 };
+        for (int d = 0; d < 4; d++) {
+            int nx = x + dx[d], ny = y + dy[d];
+            if (nx < 0 || ny < 0 || nx >= paths->map->width || ny >= paths->map->height) continue;
+            int other = cluster_of(paths, nx, ny);
+            if (other == c) continue;
+            const PathCluster* neighbour = &paths->clusters[other];
+            for (int j = 0; j < neighbour->node_count; j++) {
+                if (neighbour->node_x[j] != nx || neighbour->node_y[j] != ny) continue;
+                ok &= relax(search, (Uint32)(other * PATH_MAX_CLUSTER_NODES + j), item.g + 1, n, nx, ny, query);
+                break;
+            }
+        }
+        if (c == gc && search->goal_dist[i] != PATH_UNREACHABLE) {
+            ok &= relax(search, goal, item.g + search->goal_dist[i], n, query->goal_x, query->goal_y, query);
+        }
+        if (!ok) return 0;
+    }
+    return 0;
+}
+
+// Turns the abstract path into tiles: border crossings are single steps, everything else a local A*
+static int refine(const PathMap* paths, PathSearch* search, const PathQuery* query, PathResult* result) {
+    Uint32 start = (Uint32)search->slots - 2, goal = (Uint32)search->slots - 1;
+    size_t count = 0;
+    for (Uint32 n = goal;; n = search->parent[n]) {
+        if (count == search->waypoint_capacity) {
+            size_t capacity = search->waypoint_capacity ? search->waypoint_capacity * 2 : 256;
+            Uint32* waypoints = realloc(search->waypoints, sizeof(Uint32) * capacity);
+            if (!waypoints) {
+                printf("Failed to grow path waypoints to %zu\n", capacity);
+                return 0;
+            }
+            search->waypoints = waypoints;
+            search->waypoint_capacity = capacity;
+        }
+        search->waypoints[count++] = n;
+        if (n == start) break;
+    }
+
+    int cost = (int)search->g[goal];
+    SDL_Point* points = malloc(sizeof(SDL_Point) * (cost + 1));
+    if (!points) {
+        printf("Failed to allocate a path of %d steps\n", cost);
+        return 0;
+    }
+    points[0].x = query->start_x;
+    points[0].y = query->start_y;
+    int point_count = 1;
+    for (size_t w = count - 1; w > 0; w--) {
+        int ax, ay, bx, by;
+        node_position(paths, search, query, search->waypoints[w], &ax, &ay);
+        node_position(paths, search, query, search->waypoints[w - 1], &bx, &by);
+        int ok;
+        if (cluster_of(paths, ax, ay) != cluster_of(paths, bx, by)) {
+            ok = point_count < cost + 1;
+            if (ok) {
+                points[point_count].x = bx;
+                points[point_count].y = by;
+                point_count++;
+            }
+        } else {
+            ok = local_path(paths, search, ax, ay, bx, by, points, &point_count, cost + 1);
+        }
+        if (!ok) {
+            free(points);
+            return 0;
+        }
+    }
+
+    result->found = 1;
+    result->cost = cost;
+    result->point_count = point_count;
+    result->points = points;
+    return 1;
+}
+
+static int find_path(const PathMap* paths, PathSearch* search, const PathQuery* query, PathResult* result) {
+    memset(result, 0, sizeof(*result));
+    const TileMap* map = paths->map;
+    if (query->start_x < 0 || query->start_y < 0 || query->start_x >= map->width || query->start_y >= map->height
+        || query->goal_x < 0 || query->goal_y < 0 || query->goal_x >= map->width || query->goal_y >= map->height) return 0;
+    if (!cell_walkable(paths, query->start_x, query->start_y) || !cell_walkable(paths, query->goal_x, query->goal_y)) return 0;
+    if (!search_prepare(paths, search)) return 0;
+    search->local_cluster = -1;
+    return abstract_search(paths, search, query) && refine(paths, search, query, result);
+}
+
+int path_find(PathMap* paths, const PathQuery* query, PathResult* result) {
+    return find_path(paths, paths->searches[0], query, result);
+}
+
+int path_find_batch(PathMap* paths, const PathQuery* queries, int count, PathResult* results) {
+    int found = 0;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:found)
+    for (int k = 0; k < paths->search_count; k++) {
+        for (int q = k; q < count; q += paths->search_count) found += find_path(paths, paths->searches[k], &queries[q], &results[q]);
+    }
+    return found;
+}
+
+void path_result_free(PathResult* result) {
+    free(result->points);
+    result->points = NULL;
+    result->point_count = 0;
+}
+
+// --- Benchmark ---
+// Plain A* over every tile of the map, as units would path without the graph; returns the steps or -1
+static int flat_astar(const PathMap* paths, const PathQuery* query, Uint32* g, PathHeap* heap) {
+    const TileMap* map = paths->map;
+    int w = map->width;
+    memset(g, 0xFF, sizeof(Uint32) * (size_t)w * map->height);
+    heap->count = 0;
+    Uint32 start = (Uint32)query->start_y * w + query->start_x, goal = (Uint32)query->goal_y * w + query->goal_x;
+    g[start] = 0;
+    if (!heap_push(heap, (Uint32)(abs(query->goal_x - query->start_x) + abs(query->goal_y - query->start_y)), 0, start)) return -1;
+
+    while (heap->count > 0) {
+        HeapItem item = heap_pop(heap);
+        if (item.g > g[item.node]) continue;
+        if (item.node == goal) return (int)item.g;
+        int x = (int)(item.node % w), y = (int)(item.node / w);
+        static const int dx[4] = { -1, 1, 0, 0 }, dy[4] = { 0, 0, -1, 1 };
+        for (int d = 0; d < 4; d++) {
+            int nx = x + dx[d], ny = y + dy[d];
+            if (nx < 0 || ny < 0 || nx >= w || ny >= map->height || !cell_walkable(paths, nx, ny)) continue;
+            Uint32 j = (Uint32)ny * w + nx;
+            if (item.g + 1 >= g[j]) continue;
+            g[j] = item.g + 1;
+            if (!heap_push(heap, g[j] + (Uint32)(abs(query->goal_x - nx) + abs(query->goal_y - ny)), g[j], j)) return -1;
+        }
+    }
+    return -1;
+}
+
+static void random_walkable(const PathMap* paths, unsigned int* seed, int* x, int* y) {
+    do {
+        *x = (int)((next_random(seed) >> 8) % (Uint32)paths->map->width);
+        *y = (int)((next_random(seed) >> 8) % (Uint32)paths->map->height);
+    } while (!cell_walkable(paths, *x, *y));
+}
+
+static void bench_size(const Tileset* tileset, const Uint8* walkable, int size) {
+    TileMap map;
+    if (!tilemap_create(&map, size, size, 1)) return;
+    fill_random_tilemap(&map, tileset->cols * tileset->rows, tileset);
+
+    PathMap* paths = malloc(sizeof(PathMap));
+    PathQuery* queries = malloc(sizeof(PathQuery) * PATH_BENCH_QUERIES);
+    PathResult* results = malloc(sizeof(PathResult) * PATH_BENCH_QUERIES);
+    Uint32* flat_g = malloc(sizeof(Uint32) * (size_t)size * size);
+    PathHeap flat_heap = { NULL, 0, 0 };
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (!paths || !queries || !results || !flat_g || !path_map_create(paths, &map, walkable)) {
+        free(paths);
+        free(queries);
+        free(results);
+        free(flat_g);
+        tilemap_destroy(&map);
+        return;
+    }
+    double build_ms = seconds_since(start) * 1e3;
+    int cluster_count = paths->clusters_x * paths->clusters_y;
+    long nodes = 0;
+    for (int c = 0; c < cluster_count; c++) nodes += paths->clusters[c].node_count;
+
+    unsigned int seed = 11;
+    for (int q = 0; q < PATH_BENCH_QUERIES; q++) {
+        random_walkable(paths, &seed, &queries[q].start_x, &queries[q].start_y);
+        random_walkable(paths, &seed, &queries[q].goal_x, &queries[q].goal_y);
+    }
+
+    start = SDL_GetPerformanceCounter();
+    for (int q = 0; q < PATH_BENCH_SINGLE_QUERIES; q++) {
+        path_find(paths, &queries[q], &results[q]);
+        path_result_free(&results[q]);
+    }
+    double single_rate = PATH_BENCH_SINGLE_QUERIES / seconds_since(start);
+
+    start = SDL_GetPerformanceCounter();
+    int found = path_find_batch(paths, queries, PATH_BENCH_QUERIES, results);
+    double batch_rate = PATH_BENCH_QUERIES / seconds_since(start);
+
+    // Plain A* on the first few queries gives the speed-up and how much longer the HPA* paths are
+    long hpa_steps = 0, flat_steps = 0;
+    start = SDL_GetPerformanceCounter();
+    for (int q = 0; q < PATH_BENCH_FLAT_QUERIES; q++) {
+        int steps = flat_astar(paths, &queries[q], flat_g, &flat_heap);
+        if (steps >= 0 && results[q].found) {
+            flat_steps += steps;
+            hpa_steps += results[q].cost;
+        }
+    }
+    double flat_rate = PATH_BENCH_FLAT_QUERIES / seconds_since(start);
+
+    // Walkability flips on random tiles, through the map listener
+    tilemap_add_listener(&map, path_on_edit, paths);
+    start = SDL_GetPerformanceCounter();
+    for (int e = 0; e < PATH_BENCH_EDITS; e++) {
+        int x, y;
+        random_walkable(paths, &seed, &x, &y);
+        TileEntry blocked = { 0, 0 };
+        tilemap_set_tile(&map, 0, x, y, blocked);
+    }
+    double edit_us = seconds_since(start) * 1e6 / PATH_BENCH_EDITS;
+    tilemap_remove_listener(&map, path_on_edit, paths);
+
+    printf("%6d %9.1f %8.1f %7.1f%% %10.0f %10.0f %10.1f %7.1f%% %9.1f\n", size, build_ms,
+           (double)nodes / cluster_count, 100.0 * found / PATH_BENCH_QUERIES, single_rate, batch_rate, flat_rate,
+           flat_steps ? 100.0 * (hpa_steps - flat_steps) / flat_steps : 0.0, edit_us);
+
+    for (int q = 0; q < PATH_BENCH_QUERIES; q++) path_result_free(&results[q]);
+    path_map_free(paths);
+    free(paths);
+    free(queries);
+    free(results);
+    free(flat_g);
+    free(flat_heap.items);
+    tilemap_destroy(&map);
+}
+
+void path_benchmark(const Tileset* tileset, const TileMap* map) {
+    static const int sizes[] = { 256, 1024, 4096 };
+    (void)map;
+    static Uint8 walkable[MAX_TILESET_CELLS * MAX_TILESET_CELLS];
+    path_default_walkable(walkable, tileset);
+
+    printf("HPA* on random maps, %dx%d clusters, %d queries (%d on one core, %d with plain A*), %d cores\n",
+           MAP_CHUNK_TILES, MAP_CHUNK_TILES, PATH_BENCH_QUERIES, PATH_BENCH_SINGLE_QUERIES, PATH_BENCH_FLAT_QUERIES,
+           SDL_GetCPUCount());
+    printf("%6s %9s %8s %8s %10s %10s %10s %8s %9s\n", "size", "build ms", "nodes/cl", "found", "paths/s 1",
+           "paths/s", "A* paths/s", "longer", "us/edit");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) bench_size(tileset, walkable, sizes[s]);
+}
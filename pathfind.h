@@ -0,0 +1,87 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Hierarchical pathfinding (HPA*) over the base layer, 4-connected with unit
+// steps. Every map chunk is a cluster; wherever a run of walkable tiles faces
+// another one across a chunk border, the run becomes an entrance with a
+// transition node on each side (one in the middle, or one at each end of wide
+// runs). Each cluster stores the walking distances between its nodes. A query
+// links start and goal into their clusters, runs A* over the nodes and then
+// refines every step between two nodes of one cluster with a local A* bounded
+// to that cluster. Paths are near-optimal, not optimal.
+// Registered as a map listener with path_on_edit, an edit that changes
+// walkability rebuilds only its cluster and the neighbours whose shared border
+// it lies on. Queries only read the graph, so batches run on all cores.
+
+#ifndef PATHFIND_H
+#define PATHFIND_H
+
+#include "tilemap.h"
+
+#define PATH_MAX_CLUSTER_NODES 64      // Up to 16 transitions per border, when walkable and blocked tiles alternate
+#define PATH_UNREACHABLE 0xFFFF        // Distance between nodes of a cluster that cannot reach each other
+
+typedef struct {
+    int node_count;
+    Uint16 node_x[PATH_MAX_CLUSTER_NODES], node_y[PATH_MAX_CLUSTER_NODES];
+    Uint16* dist;            // node_count * node_count steps inside the cluster, PATH_UNREACHABLE when cut off
+} PathCluster;
+
+typedef struct PathSearch PathSearch;
+
+typedef struct {
+    const TileMap* map;
+    Uint8 walkable[MAX_TILESET_CELLS * MAX_TILESET_CELLS];   // By grid cell (sy * 256 + sx)
+    Uint8* open;             // Walkability of every base tile, kept current by path_on_edit
+    int clusters_x, clusters_y;
+    PathCluster* clusters;
+    int search_count;
+    PathSearch** searches;   // One per worker, created on first use
+} PathMap;
+
+typedef struct {
+    int start_x, start_y;
+    int goal_x, goal_y;
+} PathQuery;
+
+typedef struct {
+    int found;
+    int cost;                // Steps from start to goal
+    int point_count;         // cost + 1 when found
+    SDL_Point* points;       // Start to goal inclusive
+} PathResult;
+
+// Demo walkability: every eighth tile type blocks, until tile types carry game data
+void path_default_walkable(Uint8* walkable, const Tileset* tileset);
+// `walkable` as in PathMap, copied
+int path_map_create(PathMap* paths, const TileMap* map, const Uint8* walkable);
+void path_map_free(PathMap* paths);
+// TileEditFunc; `user` is the PathMap
+void path_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile);
+
+int path_find(PathMap* paths, const PathQuery* query, PathResult* result);
+// Answers `count` queries on all cores; returns how many paths were found
+int path_find_batch(PathMap* paths, const PathQuery* queries, int count, PathResult* results);
+void path_result_free(PathResult* result);
+
+// Prints graph build time, paths/second on one and all cores and edit cost at several map sizes,
+// with plain A* over the tiles for comparison
+void path_benchmark(const Tileset* tileset, const TileMap* map);
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "raycast.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAY_X86 1
+#include <immintrin.h>
+// The AVX2 kernel sets up rays too; a call to a non-VEX copy of the setup costs more than the steps
+#define RAY_SETUP_INLINE static inline __attribute__((always_inline))
+#else
+#define RAY_SETUP_INLINE static inline
+#endif
+
+#define RAY_GATHER_PADDING 3             // A 32-bit gather at the last tile reads 3 bytes past it
+#define RAY_PARALLEL_BLOCK 1024          // Rays per parallel work item
+#define RAY_REFILL_LANES 6               // Finished AVX2 lanes that trigger loading new rays
+#define RAY_BENCH_SHORT 16               // Longest short ray, tiles
+#define RAY_BENCH_LONG 512
+#define RAY_BENCH_RAYS (1 << 18)
+
+static int cell_opaque(const RayMap* rays, int x, int y) {
+    const TileMap* map = rays->map;
+    for (int layer = 0; layer < map->layers; layer++) {
+        TileEntry tile = tilemap_layer(map, layer)[(size_t)y * map->width + x];
+        if (rays->opaque_types[tile_cell(tile)]) return 1;
+    }
+    return 0;
+}
+
+// --- DDA state of one ray. The kernels agree exactly because they set rays up with the same code, step
+// them with the same float operations, and per-axis step counts rather than t values decide where a
+// ray ends ---
+typedef struct {
+    int x, y;
+    int step_x, step_y;
+    int left_x, left_y;      // Steps still to take along each axis
+    float t_x, t_y;          // Ray parameter at the next vertical and horizontal tile edge
+    float delta_x, delta_y;
+} RayState;
+
+RAY_SETUP_INLINE void ray_setup(const Ray* ray, RayState* state) {
+    float dx = ray->x1 - ray->x0, dy = ray->y1 - ray->y0;
+    state->x = (int)floorf(ray->x0);
+    state->y = (int)floorf(ray->y0);
+    state->step_x = dx > 0.0f ? 1 : -1;
+    state->step_y = dy > 0.0f ? 1 : -1;
+    state->left_x = abs((int)floorf(ray->x1) - state->x);
+    state->left_y = abs((int)floorf(ray->y1) - state->y);
+    state->delta_x = 1.0f / fabsf(dx);
+    state->delta_y = 1.0f / fabsf(dy);
+    state->t_x = (dx > 0.0f ? ((float)state->x + 1.0f) - ray->x0 : ray->x0 - (float)state->x) * state->delta_x;
+    state->t_y = (dy > 0.0f ? ((float)state->y + 1.0f) - ray->y0 : ray->y0 - (float)state->y) * state->delta_y;
+}
+
+static int cast_one(const RayMap* rays, const Ray* ray, RayHit* hit) {
+    int width = rays->map->width, height = rays->map->height;
+    RayState s;
+    ray_setup(ray, &s);
+    hit->blocked = 0;
+    while (s.left_x + s.left_y > 0) {
+        if (s.left_x > 0 && (s.left_y == 0 || s.t_x < s.t_y)) {
+            s.x += s.step_x;
+            s.t_x += s.delta_x;
+            s.left_x--;
+        } else {
+            s.y += s.step_y;
+            s.t_y += s.delta_y;
+            s.left_y--;
+        }
+        if (s.x < 0 || s.y < 0 || s.x >= width || s.y >= height || rays->opaque[(size_t)s.y * width + s.x]) {
+            hit->blocked = 1;
+            break;
+        }
+    }
+    hit->x = s.x;    // The end tile when nothing blocked the ray
+    hit->y = s.y;
+    return !hit->blocked;
+}
+
+static void cast_scalar(const RayMap* rays, const Ray* batch, int count, RayHit* hits) {
+    for (int i = 0; i < count; i++) cast_one(rays, &batch[i], &hits[i]);
+}
+
+#ifdef RAY_X86
+// --- AVX2: 8 lanes step 8 rays at once; whenever some finish, their results are written and the lanes
+// take the next rays, so long rays never hold idle lanes for long ---
+typedef struct {
+    int x[8], y[8];
+    int step_x[8], step_y[8];
+    int left_x[8], left_y[8];
+    float t_x[8], t_y[8];
+    float delta_x[8], delta_y[8];
+    int hit_x[8], hit_y[8];  // Where each lane stopped
+    int ray[8];              // Ray in each lane, or -1 once the batch has run out
+} RayLanes;
+
+RAY_SETUP_INLINE void lane_load(RayLanes* lanes, int lane, const RayState* s, int ray) {
+    lanes->x[lane] = s->x;
+    lanes->y[lane] = s->y;
+    lanes->step_x[lane] = s->step_x;
+    lanes->step_y[lane] = s->step_y;
+    lanes->left_x[lane] = s->left_x;
+    lanes->left_y[lane] = s->left_y;
+    lanes->t_x[lane] = s->t_x;
+    lanes->t_y[lane] = s->t_y;
+    lanes->delta_x[lane] = s->delta_x;
+    lanes->delta_y[lane] = s->delta_y;
+    lanes->ray[lane] = ray;
+}
+
+// Next ray with at least one step; rays that stay in their tile are clear and answered here
+RAY_SETUP_INLINE int next_ray(const Ray* batch, int count, int* next, RayHit* hits, RayState* s) {
+    while (*next < count) {
+        int ray = (*next)++;
+        ray_setup(&batch[ray], s);
+        if (s->left_x + s->left_y > 0) return ray;
+        hits[ray].blocked = 0;
+        hits[ray].x = s->x;
+        hits[ray].y = s->y;
+    }
+    return -1;
+}
+
+// Lanes set in a movemask; the AVX2 target alone does not imply popcnt
+static const Uint8 popcount8[256] = {
+#define RAY_B2(n) n, n + 1, n + 1, n + 2
+#define RAY_B4(n) RAY_B2(n), RAY_B2(n + 1), RAY_B2(n + 1), RAY_B2(n + 2)
+#define RAY_B6(n) RAY_B4(n), RAY_B4(n + 1), RAY_B4(n + 1), RAY_B4(n + 2)
+    RAY_B6(0), RAY_B6(1), RAY_B6(1), RAY_B6(2)
+};
+
+__attribute__((target("avx2")))
+static void cast_avx2(const RayMap* rays, const Ray* batch, int count, RayHit* hits) {
+    const __m256i zero = _mm256_setzero_si256(), none = _mm256_set1_epi32(-1), byte = _mm256_set1_epi32(0xFF);
+    const __m256i width = _mm256_set1_epi32(rays->map->width);
+    const __m256i last_x = _mm256_set1_epi32(rays->map->width - 1), last_y = _mm256_set1_epi32(rays->map->height - 1);
+    RayLanes lanes;
+    RayState s;
+    int next = 0;
+    for (int lane = 0; lane < 8; lane++) {
+        int ray = next_ray(batch, count, &next, hits, &s);
+        if (ray < 0) memset(&s, 0, sizeof(s));
+        lane_load(&lanes, lane, &s, ray);
+    }
+
+    for (;;) {
+        __m256i active = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)lanes.ray), none);
+        if (_mm256_testz_si256(active, active)) break;
+        __m256i x = _mm256_loadu_si256((const __m256i*)lanes.x), y = _mm256_loadu_si256((const __m256i*)lanes.y);
+        __m256i step_x = _mm256_loadu_si256((const __m256i*)lanes.step_x);
+        __m256i step_y = _mm256_loadu_si256((const __m256i*)lanes.step_y);
+        __m256i left_x = _mm256_loadu_si256((const __m256i*)lanes.left_x);
+        __m256i left_y = _mm256_loadu_si256((const __m256i*)lanes.left_y);
+        __m256 t_x = _mm256_loadu_ps(lanes.t_x), t_y = _mm256_loadu_ps(lanes.t_y);
+        __m256 delta_x = _mm256_loadu_ps(lanes.delta_x), delta_y = _mm256_loadu_ps(lanes.delta_y);
+        __m256i blocked = zero, done = zero, hit_x = x, hit_y = y;
+
+        // Lanes keep stepping after they finish and only their first stop is kept, so no gather waits on
+        // the one before it; refilling waits until half of them are done, as it costs a few steps
+        do {
+            __m256i has_x = _mm256_cmpgt_epi32(left_x, zero), has_y = _mm256_cmpgt_epi32(left_y, zero);
+            __m256i x_first = _mm256_castps_si256(_mm256_cmp_ps(t_x, t_y, _CMP_LT_OQ));
+            __m256i go_x = _mm256_and_si256(has_x, _mm256_or_si256(_mm256_xor_si256(has_y, none), x_first));
+            __m256i go_y = _mm256_andnot_si256(go_x, has_y);
+
+            x = _mm256_add_epi32(x, _mm256_and_si256(go_x, step_x));
+            t_x = _mm256_add_ps(t_x, _mm256_and_ps(_mm256_castsi256_ps(go_x), delta_x));
+            left_x = _mm256_add_epi32(left_x, go_x);             // go_x is -1 where set
+            y = _mm256_add_epi32(y, _mm256_and_si256(go_y, step_y));
+            t_y = _mm256_add_ps(t_y, _mm256_and_ps(_mm256_castsi256_ps(go_y), delta_y));
+            left_y = _mm256_add_epi32(left_y, go_y);
+
+            // Unsigned compares catch negative coordinates as well
+            __m256i inside = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(x, last_x), last_x),
+                                              _mm256_cmpeq_epi32(_mm256_max_epu32(y, last_y), last_y));
+            __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, width), x);
+            __m256i cells = _mm256_mask_i32gather_epi32(zero, (const int*)rays->opaque, index, inside, 1);
+            __m256i wall = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_and_si256(cells, byte), zero), none);
+            __m256i stop = _mm256_andnot_si256(done, _mm256_or_si256(wall, _mm256_xor_si256(inside, none)));
+            __m256i arrived = _mm256_cmpeq_epi32(_mm256_add_epi32(left_x, left_y), zero);
+            __m256i finished = _mm256_and_si256(active, _mm256_andnot_si256(done, _mm256_or_si256(stop, arrived)));
+            blocked = _mm256_or_si256(blocked, _mm256_and_si256(finished, stop));
+            hit_x = _mm256_blendv_epi8(hit_x, x, finished);
+            hit_y = _mm256_blendv_epi8(hit_y, y, finished);
+            done = _mm256_or_si256(done, finished);
+        } while (!_mm256_testc_si256(done, active)
+                 && popcount8[_mm256_movemask_ps(_mm256_castsi256_ps(done))] < RAY_REFILL_LANES);
+
+        _mm256_storeu_si256((__m256i*)lanes.hit_x, hit_x);
+        _mm256_storeu_si256((__m256i*)lanes.hit_y, hit_y);
+        _mm256_storeu_si256((__m256i*)lanes.x, x);
+        _mm256_storeu_si256((__m256i*)lanes.y, y);
+        _mm256_storeu_si256((__m256i*)lanes.left_x, left_x);
+        _mm256_storeu_si256((__m256i*)lanes.left_y, left_y);
+        _mm256_storeu_ps(lanes.t_x, t_x);
+        _mm256_storeu_ps(lanes.t_y, t_y);
+        int done_bits = _mm256_movemask_ps(_mm256_castsi256_ps(done));
+        int blocked_bits = _mm256_movemask_ps(_mm256_castsi256_ps(blocked));
+        for (int lane = 0; lane < 8; lane++) {
+            if (!(done_bits & (1 << lane))) continue;
+            RayHit* hit = &hits[lanes.ray[lane]];
+            hit->blocked = (blocked_bits >> lane) & 1;
+            hit->x = lanes.hit_x[lane];
+            hit->y = lanes.hit_y[lane];
+            int ray = next_ray(batch, count, &next, hits, &s);
+            if (ray < 0) memset(&s, 0, sizeof(s));
+            lane_load(&lanes, lane, &s, ray);
+        }
+    }
+}
+
+static SDL_bool has_avx2(void) {
+    return SDL_HasAVX2();
+}
+#endif
+
+const RayKernel ray_kernels[] = {
+#ifdef RAY_X86
+    { "avx2", cast_avx2, has_avx2 },
+#endif
+    { "scalar", cast_scalar, NULL },
+};
+const int ray_kernel_count = sizeof(ray_kernels) / sizeof(ray_kernels[0]);
+
+const RayKernel* ray_select(void) {
+    for (int i = 0; i < ray_kernel_count; i++) {
+        if (!ray_kernels[i].supported || ray_kernels[i].supported()) return &ray_kernels[i];
+    }
+    return &ray_kernels[ray_kernel_count - 1];
+}
+
+void ray_default_opaque(Uint8* opaque_types, const Tileset* tileset) {
+    memset(opaque_types, 0, MAX_TILESET_CELLS * MAX_TILESET_CELLS);
+    for (int index = 0; index < tileset->cols * tileset->rows; index++) {
+        opaque_types[(index / tileset->cols) * MAX_TILESET_CELLS + index % tileset->cols] = index % 32 == 0;
+    }
+}
+
+int ray_map_create(RayMap* rays, const TileMap* map, const Uint8* opaque_types) {
+    memset(rays, 0, sizeof(*rays));
+    rays->map = map;
+    memcpy(rays->opaque_types, opaque_types, sizeof(rays->opaque_types));
+    rays->opaque = calloc((size_t)map->width * map->height + RAY_GATHER_PADDING, 1);
+    if (!rays->opaque) {
+        printf("Failed to allocate the opacity of %dx%d tiles\n", map->width, map->height);
+        return 0;
+    }
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < map->height; y++) {
+        for (int x = 0; x < map->width; x++) rays->opaque[(size_t)y * map->width + x] = (Uint8)cell_opaque(rays, x, y);
+    }
+    return 1;
+}
+
+void ray_map_free(RayMap* rays) {
+    free(rays->opaque);
+    rays->opaque = NULL;
+}
+
+void ray_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile) {
+    RayMap* rays = user;
+    (void)layer;
+    (void)old_tile;
+    (void)new_tile;
+    rays->opaque[(size_t)y * rays->map->width + x] = (Uint8)cell_opaque(rays, x, y);
+}
+
+int ray_cast(const RayMap* rays, const Ray* ray, RayHit* hit) {
+    return cast_one(rays, ray, hit);
+}
+
+void ray_cast_parallel(const RayMap* rays, const Ray* batch, int count, RayHit* hits) {
+    RayCastFunc cast = ray_select()->cast;
+    int blocks = (count + RAY_PARALLEL_BLOCK - 1) / RAY_PARALLEL_BLOCK;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int b = 0; b < blocks; b++) {
+        int first = b * RAY_PARALLEL_BLOCK;
+        int n = count - first < RAY_PARALLEL_BLOCK ? count - first : RAY_PARALLEL_BLOCK;
+        cast(rays, batch + first, n, hits + first);
+    }
+}
+
+// --- Benchmark: rays start anywhere on the map in any direction; long ones often leave it ---
+static void random_rays(Ray* batch, int count, const TileMap* map, float length, unsigned int* seed) {
+    for (int i = 0; i < count; i++) {
+        float r[4];
+        for (int k = 0; k < 4; k++) {
+            r[k] = (float)((next_random(seed) >> 8) & 0xFFFF) / 65536.0f;
+        }
+        float angle = r[2] * 6.2831853f, distance = 0.5f + r[3] * (length - 0.5f);
+        batch[i].x0 = r[0] * map->width;
+        batch[i].y0 = r[1] * map->height;
+        batch[i].x1 = batch[i].x0 + cosf(angle) * distance;
+        batch[i].y1 = batch[i].y0 + sinf(angle) * distance;
+    }
+}
+
+static double run_rays(const RayMap* rays, RayCastFunc cast, const Ray* batch, RayHit* hits) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (cast) cast(rays, batch, RAY_BENCH_RAYS, hits);
+    else ray_cast_parallel(rays, batch, RAY_BENCH_RAYS, hits);
+    double seconds = seconds_since(start);
+    return seconds > 0 ? RAY_BENCH_RAYS / seconds / 1e6 : 0.0;
+}
+
+void ray_benchmark(const Tileset* tileset, const TileMap* map) {
+    static Uint8 opaque_types[MAX_TILESET_CELLS * MAX_TILESET_CELLS];
+    ray_default_opaque(opaque_types, tileset);
+    size_t tile_count = (size_t)map->width * map->height;
+    Ray* batch[2] = { malloc(sizeof(Ray) * RAY_BENCH_RAYS), malloc(sizeof(Ray) * RAY_BENCH_RAYS) };
+    RayHit* reference[4];
+    for (int c = 0; c < 4; c++) reference[c] = malloc(sizeof(RayHit) * RAY_BENCH_RAYS);
+    RayHit* hits = malloc(sizeof(RayHit) * RAY_BENCH_RAYS);
+    Uint8* walls = malloc(tile_count);
+    RayMap rays = { NULL, {0}, NULL };
+    int ok = batch[0] && batch[1] && hits && walls;
+    for (int c = 0; c < 4; c++) ok = ok && reference[c];
+    if (!ok) printf("Failed to allocate %d benchmark rays\n", RAY_BENCH_RAYS);
+    if (!ok || !ray_map_create(&rays, map, opaque_types)) {
+        for (int c = 0; c < 4; c++) free(reference[c]);
+        free(batch[0]);
+        free(batch[1]);
+        free(hits);
+        free(walls);
+        return;
+    }
+    unsigned int seed = 3;
+    random_rays(batch[0], RAY_BENCH_RAYS, map, RAY_BENCH_SHORT, &seed);
+    random_rays(batch[1], RAY_BENCH_RAYS, map, RAY_BENCH_LONG, &seed);
+    // Columns: short and long rays, over the demo walls and then with nothing opaque
+    memcpy(walls, rays.opaque, tile_count);
+
+    printf("Line of sight on %dx%d tiles, %d rays per run up to %d and %d tiles long (selected kernel: %s, %d cores)\n",
+           map->width, map->height, RAY_BENCH_RAYS, RAY_BENCH_SHORT, RAY_BENCH_LONG, ray_select()->name, SDL_GetCPUCount());
+    printf("%-10s %12s %12s %12s %12s  Mrays/s\n", "kernel", "short walls", "long walls", "short open", "long open");
+
+    int order[8], order_count = 0;
+    order[order_count++] = ray_kernel_count - 1;                      // Scalar first: the reference
+    for (int k = 0; k < ray_kernel_count - 1; k++) {
+        if (!ray_kernels[k].supported || ray_kernels[k].supported()) order[order_count++] = k;
+    }
+    order[order_count++] = -1;                                        // The parallel batch
+
+    for (int o = 0; o < order_count; o++) {
+        RayCastFunc cast = order[o] >= 0 ? ray_kernels[order[o]].cast : NULL;
+        double rate[4];
+        int mismatches = 0;
+        for (int c = 0; c < 4; c++) {
+            if (c == 0) memcpy(rays.opaque, walls, tile_count);
+            if (c == 2) memset(rays.opaque, 0, tile_count);
+            RayHit* out = o == 0 ? reference[c] : hits;
+            rate[c] = run_rays(&rays, cast, batch[c & 1], out);
+            if (o > 0) mismatches += memcmp(out, reference[c], sizeof(RayHit) * RAY_BENCH_RAYS) != 0;
+        }
+        printf("%-10s %12.2f %12.2f %12.2f %12.2f%s\n", cast ? ray_kernels[order[o]].name : "parallel",
+               rate[0], rate[1], rate[2], rate[3], bench_mismatch(!mismatches));
+    }
+
+    free(walls);
+    for (int c = 0; c < 4; c++) free(reference[c]);
+    free(batch[0]);
+    free(batch[1]);
+    free(hits);
+    ray_map_free(&rays);
+}
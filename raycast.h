@@ -0,0 +1,81 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Line of sight over the tile grid. Rays run from one point to another in
+// tile units (tile (x, y) covers [x, x + 1) x [y, y + 1)) and walk the tiles
+// they pass through with a DDA (Amanatides & Woo), testing each one after the
+// start tile, up to and including the end tile, against a byte grid of
+// opacity: a tile is opaque when any of its layers holds an opaque tile type,
+// and everything outside the map is opaque. Batches walk 8 rays in lockstep
+// with AVX2 gathers when the CPU has it, refilling lanes as rays finish;
+// ray_cast_parallel also splits the batch over all cores. Every kernel
+// returns identical hits.
+
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include "tilemap.h"
+
+typedef struct {
+    const TileMap* map;
+    Uint8 opaque_types[MAX_TILESET_CELLS * MAX_TILESET_CELLS];   // By grid cell (sy * 256 + sx)
+    Uint8* opaque;           // One byte per tile plus 3 of padding for 32-bit gathers; kept by ray_on_edit
+} RayMap;
+
+typedef struct {
+    float x0, y0;
+    float x1, y1;
+} Ray;
+
+typedef struct {
+    int blocked;             // An opaque tile was found before the end of the ray
+    int x, y;                // That tile, or the end tile when the ray is clear
+} RayHit;
+
+typedef void (*RayCastFunc)(const RayMap* rays, const Ray* batch, int count, RayHit* hits);
+
+typedef struct {
+    const char* name;
+    RayCastFunc cast;
+    SDL_bool (*supported)(void);  // NULL when always available
+} RayKernel;
+
+extern const RayKernel ray_kernels[];
+extern const int ray_kernel_count;
+
+// Fastest kernel this CPU can run
+const RayKernel* ray_select(void);
+
+// Demo opacity: every 32nd tile type blocks sight, until tile types carry game data
+void ray_default_opaque(Uint8* opaque_types, const Tileset* tileset);
+// `opaque_types` as in RayMap, copied
+int ray_map_create(RayMap* rays, const TileMap* map, const Uint8* opaque_types);
+void ray_map_free(RayMap* rays);
+// TileEditFunc; `user` is the RayMap
+void ray_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile);
+
+// Returns whether the ray is clear
+int ray_cast(const RayMap* rays, const Ray* ray, RayHit* hit);
+// The selected kernel on blocks of the batch, on all cores
+void ray_cast_parallel(const RayMap* rays, const Ray* batch, int count, RayHit* hits);
+
+// Prints millions of rays per second of every kernel and of the parallel batch, for short and long rays
+void ray_benchmark(const Tileset* tileset, const TileMap* map);
+
+#endif
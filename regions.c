@@ -0,0 +1,377 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "regions.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REGION_BENCH_EDITS 4096
+#define REGION_BENCH_BLOCK 16        // Side of the uniform blocks of the "blocks" benchmark map
+
+// Mirrored and rotated copies of a tile belong to the same region
+static int same_tile(TileEntry a, TileEntry b) {
+    return a.sx == b.sx && tile_row(a) == tile_row(b);
+}
+
+// --- Union-find over cell indices. The root of a set is always its smallest cell, so every parent
+// precedes its children in memory; numbering then needs a single forward sweep ---
+static Uint32 find_root(Uint32* parent, Uint32 i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void unite(Uint32* parent, Uint32 a, Uint32 b) {
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+static void label_chunk(Uint32* parent, const TileEntry* cells, int width, int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            Uint32 i = (Uint32)y * width + x;
+            parent[i] = i;
+            if (tile_is_empty(cells[i])) continue;
+            if (x > x0 && same_tile(cells[i], cells[i - 1])) unite(parent, i, i - 1);
+            if (y > y0 && same_tile(cells[i], cells[i - width])) unite(parent, i, i - width);
+        }
+    }
+    // Point every cell straight at its chunk root, so the border pass walks short paths
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            Uint32 i = (Uint32)y * width + x;
+            parent[i] = parent[parent[i]];
+        }
+    }
+}
+
+static int grow_ids(RegionMap* regions) {
+    Uint32 capacity = regions->capacity ? regions->capacity * 2 : 1024;
+    Uint32* sizes = realloc(regions->sizes, sizeof(Uint32) * capacity);
+    if (sizes) regions->sizes = sizes;
+    TileEntry* tiles = realloc(regions->tiles, sizeof(TileEntry) * capacity);
+    if (tiles) regions->tiles = tiles;
+    Uint32* free_ids = realloc(regions->free_ids, sizeof(Uint32) * capacity);
+    if (free_ids) regions->free_ids = free_ids;
+    if (!sizes || !tiles || !free_ids) {
+        printf("Failed to allocate %u region ids\n", capacity);
+        return 0;
+    }
+    memset(regions->sizes + regions->capacity, 0, sizeof(Uint32) * (capacity - regions->capacity));
+    for (Uint32 id = capacity; id > regions->capacity; id--) regions->free_ids[regions->free_count++] = id - 1;
+    regions->capacity = capacity;
+    return 1;
+}
+
+static Uint32 new_region(RegionMap* regions, TileEntry tile) {
+    if (regions->free_count == 0 && !grow_ids(regions)) return REGION_NONE;
+    Uint32 id = regions->free_ids[--regions->free_count];
+    regions->tiles[id] = tile;
+    regions->count++;
+    return id;
+}
+
+static void drop_tile(RegionMap* regions, Uint32 id) {
+    if (--regions->sizes[id] > 0) return;
+    regions->free_ids[regions->free_count++] = id;
+    regions->count--;
+}
+
+static int label_all(RegionMap* regions, int parallel) {
+    const TileEntry* cells = tilemap_layer(regions->map, regions->layer);
+    Uint32* parent = regions->labels;
+    int w = regions->width, h = regions->height;
+    int chunks_x = (w + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    int chunks_y = (h + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+
+    #pragma omp parallel for schedule(dynamic, 16) if(parallel)
+    for (int c = 0; c < chunks_x * chunks_y; c++) {
+        int x0 = (c % chunks_x) * MAP_CHUNK_TILES, y0 = (c / chunks_x) * MAP_CHUNK_TILES;
+        int x1 = x0 + MAP_CHUNK_TILES < w ? x0 + MAP_CHUNK_TILES : w;
+        int y1 = y0 + MAP_CHUNK_TILES < h ? y0 + MAP_CHUNK_TILES : h;
+        label_chunk(parent, cells, w, x0, y0, x1, y1);
+    }
+
+    // Chunk borders: only touches chunk roots, a small fraction of the cells
+    for (int x = MAP_CHUNK_TILES; x < w; x += MAP_CHUNK_TILES) {
+        for (int y = 0; y < h; y++) {
+            Uint32 i = (Uint32)y * w + x;
+            if (!tile_is_empty(cells[i]) && same_tile(cells[i], cells[i - 1])) unite(parent, i, i - 1);
+        }
+    }
+    for (int y = MAP_CHUNK_TILES; y < h; y += MAP_CHUNK_TILES) {
+        for (int x = 0; x < w; x++) {
+            Uint32 i = (Uint32)y * w + x;
+            if (!tile_is_empty(cells[i]) && same_tile(cells[i], cells[i - w])) unite(parent, i, i - w);
+        }
+    }
+
+    // Parents precede their children, so by the time the sweep reaches a cell its parent already
+    // holds the region id
+    size_t count = (size_t)w * h;
+    for (size_t i = 0; i < count; i++) {
+        if (tile_is_empty(cells[i])) {
+            parent[i] = REGION_NONE;
+            continue;
+        }
+        Uint32 id;
+        if (parent[i] == i) {
+            id = new_region(regions, cells[i]);
+            if (id == REGION_NONE) return 0;
+        } else {
+            id = parent[parent[i]];
+        }
+        parent[i] = id;
+        regions->sizes[id]++;
+    }
+    return 1;
+}
+
+int regions_create(RegionMap* regions, const TileMap* map, int layer) {
+    memset(regions, 0, sizeof(*regions));
+    if (layer < 0 || layer >= map->layers) {
+        printf("Map has no layer %d\n", layer);
+        return 0;
+    }
+    regions->map = map;
+    regions->layer = layer;
+    regions->width = map->width;
+    regions->height = map->height;
+    regions->labels = malloc(sizeof(Uint32) * (size_t)map->width * map->height);
+    if (!regions->labels || !label_all(regions, 1)) {
+        if (!regions->labels) printf("Failed to allocate region labels for %dx%d tiles\n", map->width, map->height);
+        regions_free(regions);
+        return 0;
+    }
+    return 1;
+}
+
+void regions_free(RegionMap* regions) {
+    free(regions->labels);
+    free(regions->sizes);
+    free(regions->tiles);
+    free(regions->free_ids);
+    free(regions->stack);
+    memset(regions, 0, sizeof(*regions));
+}
+
+// --- Incremental updates ---
+static int push_cell(RegionMap* regions, size_t* top, Uint32 cell) {
+    if (*top == regions->stack_capacity) {
+        size_t capacity = regions->stack_capacity ? regions->stack_capacity * 2 : 4096;
+        Uint32* stack = realloc(regions->stack, sizeof(Uint32) * capacity);
+        if (!stack) {
+            printf("Failed to grow the region flood fill to %zu cells\n", capacity);
+            return 0;
+        }
+        regions->stack = stack;
+        regions->stack_capacity = capacity;
+    }
+    regions->stack[(*top)++] = cell;
+    return 1;
+}
+
+// Moves the 4-connected cells of the seed's tile into region `id`
+static void flood(RegionMap* regions, Uint32 seed, Uint32 id) {
+    const TileEntry* cells = tilemap_layer(regions->map, regions->layer);
+    int w = regions->width, h = regions->height;
+    TileEntry tile = cells[seed];
+    size_t top = 0;
+    if (regions->labels[seed] == id || !push_cell(regions, &top, seed)) return;
+    if (regions->labels[seed] != REGION_NONE) drop_tile(regions, regions->labels[seed]);
+    regions->labels[seed] = id;
+    regions->sizes[id]++;
+
+    while (top > 0) {
+        Uint32 i = regions->stack[--top];
+        int x = (int)(i % w), y = (int)(i / w);
+        Uint32 next[4];
+        int n = 0;
+        if (x > 0) next[n++] = i - 1;
+        if (x + 1 < w) next[n++] = i + 1;
+        if (y > 0) next[n++] = i - w;
+        if (y + 1 < h) next[n++] = i + w;
+        for (int k = 0; k < n; k++) {
+            Uint32 j = next[k];
+            if (regions->labels[j] == id || !same_tile(cells[j], tile)) continue;
+            if (!push_cell(regions, &top, j)) return;
+            if (regions->labels[j] != REGION_NONE) drop_tile(regions, regions->labels[j]);
+            regions->labels[j] = id;
+            regions->sizes[id]++;
+        }
+    }
+}
+
+void regions_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile) {
+    RegionMap* regions = user;
+    if (layer != regions->layer || same_tile(old_tile, new_tile)) return;
+    const TileEntry* cells = tilemap_layer(regions->map, regions->layer);
+    int w = regions->width;
+    Uint32 i = (Uint32)y * w + x;
+    Uint32 old_id = regions->labels[i];
+
+    Uint32 neighbours[4];
+    int n = 0;
+    if (x > 0) neighbours[n++] = i - 1;
+    if (x + 1 < w) neighbours[n++] = i + 1;
+    if (y > 0) neighbours[n++] = i - w;
+    if (y + 1 < regions->height) neighbours[n++] = i + w;
+
+    // Join: the cell takes the largest neighbouring region of its new tile, the others are renamed into it
+    if (tile_is_empty(new_tile)) {
+        if (old_id != REGION_NONE) drop_tile(regions, old_id);
+        regions->labels[i] = REGION_NONE;
+    } else {
+        Uint32 target = REGION_NONE;
+        for (int k = 0; k < n; k++) {
+            Uint32 id = regions->labels[neighbours[k]];
+            if (!same_tile(cells[neighbours[k]], new_tile)) continue;
+            if (target == REGION_NONE || regions->sizes[id] > regions->sizes[target]) target = id;
+        }
+        if (target == REGION_NONE) {
+            target = new_region(regions, new_tile);
+            if (target == REGION_NONE) return;
+        }
+        flood(regions, i, target);
+    }
+
+    // Split: every piece of the old region touches this cell, so while two or more neighbours still
+    // carry its id, move the piece around one of them to a new id; the last piece keeps the old id
+    if (tile_is_empty(old_tile) || old_id == REGION_NONE) return;
+    for (int k = 0; k < n; k++) {
+        Uint32 j = neighbours[k];
+        if (regions->labels[j] != old_id) continue;
+        int others = 0;
+        for (int m = k + 1; m < n; m++) others += regions->labels[neighbours[m]] == old_id;
+        if (others == 0) return;
+        Uint32 piece = new_region(regions, old_tile);
+        if (piece == REGION_NONE) return;
+        flood(regions, j, piece);
+    }
+}
+
+// --- Benchmark ---
+// Whether two labellings of the same layer describe the same partition
+static int same_partition(const RegionMap* a, const RegionMap* b) {
+    if (a->count != b->count) return 0;
+    Uint32* map_to = malloc(sizeof(Uint32) * a->capacity);
+    if (!map_to) return 0;
+    for (Uint32 id = 0; id < a->capacity; id++) map_to[id] = REGION_NONE;
+    size_t count = (size_t)a->width * a->height;
+    int same = 1;
+    for (size_t i = 0; i < count && same; i++) {
+        Uint32 la = a->labels[i], lb = b->labels[i];
+        if (la == REGION_NONE || lb == REGION_NONE) {
+            same = la == lb;
+            continue;
+        }
+        if (map_to[la] == REGION_NONE) map_to[la] = lb;
+        same = map_to[la] == lb && a->sizes[la] == b->sizes[lb];
+    }
+    free(map_to);
+    return same;
+}
+
+static void bench_map(const char* name, const Tileset* tileset, TileMap* map) {
+    RegionMap regions;
+    memset(&regions, 0, sizeof(regions));
+    regions.map = map;
+    regions.width = map->width;
+    regions.height = map->height;
+    regions.labels = malloc(sizeof(Uint32) * (size_t)map->width * map->height);
+    if (!regions.labels) {
+        printf("Failed to allocate region labels for %dx%d tiles\n", map->width, map->height);
+        return;
+    }
+
+    double megatiles = (double)map->width * map->height / 1e6;
+    double rate[2];
+    for (int parallel = 0; parallel <= 1; parallel++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (!label_all(&regions, parallel)) break;
+        rate[parallel] = megatiles / seconds_since(start);
+        if (!parallel) {
+            free(regions.sizes);
+            free(regions.tiles);
+            free(regions.free_ids);
+            regions.sizes = NULL;
+            regions.tiles = NULL;
+            regions.free_ids = NULL;
+            regions.capacity = regions.count = regions.free_count = 0;
+        }
+    }
+
+    Uint32 largest = 0;
+    for (Uint32 id = 0; id < regions.capacity; id++) {
+        if (regions.sizes[id] > largest) largest = regions.sizes[id];
+    }
+
+    // Edits cycle tiles at random cells, so they join and split regions of every size
+    tilemap_add_listener(map, regions_on_edit, &regions);
+    unsigned int seed = 7;
+    int type_count = tileset->cols * tileset->rows;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int e = 0; e < REGION_BENCH_EDITS; e++) {
+        int x = (int)((next_random(&seed) >> 8) % (Uint32)map->width);
+        int y = (int)((next_random(&seed) >> 8) % (Uint32)map->height);
+        TileEntry tile = tilemap_layer(map, 0)[(size_t)y * map->width + x];
+        int next = (tile_index_of(tileset, tile) + 1 + (int)(seed >> 28)) % type_count;
+        tile.sx = (Uint8)(next % tileset->cols);
+        tile.sy = (Uint8)(next / tileset->cols);
+        tilemap_set_tile(map, 0, x, y, tile);
+    }
+    double edit_us = seconds_since(start) * 1e6 / REGION_BENCH_EDITS;
+    tilemap_remove_listener(map, regions_on_edit, &regions);
+
+    RegionMap fresh;
+    int ok = regions_create(&fresh, map, 0) && same_partition(&regions, &fresh);
+    regions_free(&fresh);
+
+    printf("%-8s %10u %10u %10.1f %10.1f %10.2f%s\n", name, regions.count, largest, rate[0], rate[1], edit_us,
+           bench_mismatch(ok));
+    regions_free(&regions);
+}
+
+void regions_benchmark(const Tileset* tileset, const TileMap* map) {
+    TileMap copy;
+    if (!tilemap_create(&copy, map->width, map->height, 1)) return;
+    size_t count = (size_t)map->width * map->height;
+
+    printf("Connected regions of layer 0, %dx%d tiles, %d cores\n", map->width, map->height, SDL_GetCPUCount());
+    printf("%-8s %10s %10s %10s %10s %10s\n", "map", "regions", "largest", "Mt/s 1", "Mt/s all", "us/edit");
+
+    memcpy(copy.tiles, map->tiles, sizeof(TileEntry) * count);
+    bench_map("random", tileset, &copy);
+
+    // Uniform blocks make large regions, the expensive case for incremental joins and splits
+    for (int y = 0; y < copy.height; y++) {
+        for (int x = 0; x < copy.width; x++) {
+            int bx = x / REGION_BENCH_BLOCK * REGION_BENCH_BLOCK, by = y / REGION_BENCH_BLOCK * REGION_BENCH_BLOCK;
+            copy.tiles[(size_t)y * copy.width + x] = map->tiles[(size_t)by * map->width + bx];
+        }
+    }
+    bench_map("blocks", tileset, &copy);
+    tilemap_destroy(&copy);
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Connected regions of identical tiles in one layer (lakes, forests), with
+// 4-connectivity; empty cells belong to no region. The full pass labels each
+// map chunk on its own core with a union-find, joins the chunks along their
+// borders and numbers the regions in one sweep. Registered as a map listener
+// with regions_on_edit, an edit only floods the regions it touches: the
+// smaller regions it joins are renamed into the largest one, and when the
+// region it leaves may have split, all pieces but one are moved to new ids.
+
+#ifndef REGIONS_H
+#define REGIONS_H
+
+#include "tilemap.h"
+
+#define REGION_NONE 0xFFFFFFFFu      // Label of empty cells
+
+typedef struct {
+    const TileMap* map;
+    int layer;
+    int width, height;
+    Uint32* labels;          // Region id of every tile
+    Uint32* sizes;           // Tiles per region id, 0 for unused ids
+    TileEntry* tiles;        // Tile each region is made of
+    Uint32 capacity;         // Ids allocated
+    Uint32 count;            // Regions with at least one tile
+    Uint32* free_ids;        // Unused ids below capacity, reused first
+    Uint32 free_count;
+    Uint32* stack;           // Flood fill work list
+    size_t stack_capacity;
+} RegionMap;
+
+int regions_create(RegionMap* regions, const TileMap* map, int layer);
+void regions_free(RegionMap* regions);
+// TileEditFunc; `user` is the RegionMap
+void regions_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile);
+
+static inline Uint32 region_at(const RegionMap* regions, int x, int y) {
+    return regions->labels[(size_t)y * regions->width + x];
+}
+
+// Prints labelling throughput on one and all cores and the cost of incremental edits
+void regions_benchmark(const Tileset* tileset, const TileMap* map);
+
+#endif
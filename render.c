@@ -0,0 +1,75 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "render.h"
+#include <stdio.h>
+#include <string.h>
+
+const RendererBackend* const renderer_backends[] = { &gl_backend, &sdl_backend, &soft_backend };
+const int renderer_backend_count = sizeof(renderer_backends) / sizeof(renderer_backends[0]);
+
+const RendererBackend* find_backend(const char* name) {
+    for (int i = 0; i < renderer_backend_count; i++) {
+        if (strcmp(renderer_backends[i]->name, name) == 0) return renderer_backends[i];
+    }
+    return NULL;
+}
+
+int find_backend_path(const RendererBackend* backend, const char* name) {
+    for (int i = 0; i < backend->path_count; i++) {
+        if (strcmp(backend->path_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+int renderer_open(Renderer* renderer, const RendererBackend* backend, int path, Uint32 flags,
+                  const char* title, int width, int height, Uint32 extra_window_flags,
+                  const Tileset* tileset, const TileMap* map) {
+    renderer->backend = backend;
+    renderer->path = path;
+    renderer->window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height,
+                                        backend->window_flags | extra_window_flags);
+    if (!renderer->window) {
+        printf("SDL_CreateWindow failed: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    renderer->impl = backend->create(renderer->window, tileset, map, path, flags);
+    if (!renderer->impl) {
+        printf("Failed to create %s renderer (path %s)\n", backend->name, backend->path_names[path]);
+        SDL_DestroyWindow(renderer->window);
+        renderer->window = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+void renderer_close(Renderer* renderer) {
+    if (renderer->impl) renderer->backend->destroy(renderer->impl);
+    if (renderer->window) SDL_DestroyWindow(renderer->window);
+    renderer->impl = NULL;
+    renderer->window = NULL;
+}
+
+void renderer_capture(Renderer* renderer, FrameWriter* writer, int finish) {
+    if (!writer || !renderer->impl) return;
+    Uint64 start = SDL_GetPerformanceCounter();
+    renderer->backend->capture(renderer->impl, writer, finish);
+    writer->overhead_ticks += SDL_GetPerformanceCounter() - start;
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Pluggable render backends. Each backend owns its window surface or GL
+// context and draws a View computed by the shared core; "paths" are the
+// alternative drawing strategies a backend offers for benchmarking.
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "tilemap.h"
+#include "capture.h"
+
+// --- Flags passed to create() ---
+#define RENDER_DAMAGE_TRACKING 0x1        // Keep the last frame offscreen and honour View.damage
+#define RENDER_STREAM_ORPHAN 0x2          // GL: stream vertices by orphaning even if persistent mapping works
+#define RENDER_STREAM_CLIENT 0x4          // GL: stream vertices from client memory (GL 1.1 arrays)
+#define RENDER_GL_QUADS 0x8               // GL: draw batches with GL_QUADS instead of the shared index buffer
+
+typedef struct {
+    const char* name;
+    const char* const* path_names;    // First entry is the default path
+    int path_count;
+    Uint32 window_flags;              // Extra SDL_CreateWindow flags the backend needs
+
+    void* (*create)(SDL_Window* window, const Tileset* tileset, const TileMap* map, int path, Uint32 flags);
+    void (*destroy)(void* impl);
+    void (*resize)(void* impl, int width, int height);
+    void (*draw)(void* impl, const View* view, FrameStats* stats);
+    void (*present)(void* impl);
+    // Reads back the frame just drawn into `writer`; with `finish` only flushes frames still in flight
+    void (*capture)(void* impl, FrameWriter* writer, int finish);
+} RendererBackend;
+
+// --- A backend instance bound to its window ---
+typedef struct {
+    const RendererBackend* backend;
+    int path;
+    SDL_Window* window;
+    void* impl;
+} Renderer;
+
+extern const RendererBackend sdl_backend;
+extern const RendererBackend gl_backend;
+extern const RendererBackend soft_backend;
+
+extern const RendererBackend* const renderer_backends[];
+extern const int renderer_backend_count;
+
+const RendererBackend* find_backend(const char* name);
+int find_backend_path(const RendererBackend* backend, const char* name);
+
+int renderer_open(Renderer* renderer, const RendererBackend* backend, int path, Uint32 flags,
+                  const char* title, int width, int height, Uint32 extra_window_flags,
+                  const Tileset* tileset, const TileMap* map);
+void renderer_close(Renderer* renderer);
+
+// Calls the backend's capture hook between draw and present, timing it into the writer's overhead.
+// Call with `finish` before renderer_close so no captured frame is lost.
+void renderer_capture(Renderer* renderer, FrameWriter* writer, int finish);
+
+#endif
@@ -0,0 +1,634 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// OpenGL 1.1 backend. Paths:
+//   immediate - one glBegin/glEnd quad per visible tile
+//   batched   - all visible quads rebuilt into a vertex array every frame, one draw call
+//   visset    - like batched, but the persistent visible set only regenerates cells
+//               that scrolled into view
+//   chunks    - static per-chunk meshes in buffer objects with 16-bit vertices (gl_chunks.c)
+//   chunks-f32 - the same chunk meshes with float vertices, for comparison
+//   points    - one point-sprite vertex per tile with a GLSL atlas lookup (gl_points.c);
+//               falls back to the visset quads when sprites can't cover a tile
+// The batched and visset paths append the entities collected into View.entities to
+// their tile batch, y-sorted, so sprites cost no extra draw calls; the other paths
+// draw tiles only.
+// A FogMap in View.fog is kept in a luminance texture, one texel per tile, updated
+// with glTexSubImage2D for the blocks it recomputed and multiplied over the scene
+// with a single quad.
+// Batches and chunks are drawn as indexed triangles from one shared static index
+// buffer (gl_quads.c) unless RENDER_GL_QUADS asks for GL_QUADS.
+// The batched paths stream their vertices through gl_stream.c: a persistently mapped
+// triple-buffered region on GL 4.4, orphaned buffer objects on GL 1.5, client arrays
+// otherwise (or as forced by RENDER_STREAM_*).
+// With RENDER_DAMAGE_TRACKING (and framebuffer objects available) frames are drawn
+// into an offscreen texture that persists across swaps; hover-only frames redraw
+// just the old and new outline rectangles under glScissor before it is copied out.
+// Binds, enables and colour changes go through the shadow state in gl_state.c: each
+// draw declares the state it needs and redundant calls are dropped and counted.
+// Capture reads frames back asynchronously through pixel-pack buffers (gl_readback.c).
+
+#include "render.h"
+#include "visset.h"
+#include "entities.h"
+#include "fog.h"
+#include "tint.h"
+#include "gl_ext.h"
+#include "gl_state.h"
+#include "gl_stream.h"
+#include "gl_chunks.h"
+#include "gl_quads.h"
+#include "gl_points.h"
+#include "gl_readback.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+
+#define OUTLINE_PIXEL_WIDTH 8.0f          // Width of the outline in pixels
+#define LAYER_COUNT 1                     // Simulate multiple tile layers
+
+enum { GL_PATH_IMMEDIATE, GL_PATH_BATCHED, GL_PATH_VISSET, GL_PATH_CHUNKS, GL_PATH_CHUNKS_F32, GL_PATH_POINTS };
+static const char* const gl_path_names[] = { "immediate", "batched", "visset", "chunks", "chunks-f32", "points" };
+
+typedef struct {
+    int x, y;
+    TileEntry tile;
+    Uint32 colour;               // Tint, RGBA bytes
+} TileDrawCmd;
+
+typedef struct {
+    TileDrawCmd* data;
+    int capacity;
+} DrawBuffer;
+
+typedef struct {
+    SDL_Window* window;
+    SDL_GLContext context;
+    GlExtensions ext;
+    GlState state;
+    int width, height;
+    GLuint texture_id;
+    float step_u, step_v;        // Precomputed 1/cols and 1/rows
+    DrawBuffer draw_buf;
+    VisibleSet visset;
+    StreamBuffer stream;
+    ChunkCache chunks;
+    QuadIndexBuffer quads;
+    PointSprites points;
+    PixelReadback readback;
+    int indexed;                 // Draw batches as indexed triangles rather than GL_QUADS
+    const Tileset* tileset;
+    const TileMap* map;
+    int path;
+    int damage_tracking;
+    const FogMap* fog;           // Fog of war held in fog_texture; 0 fog_tex_w when it did not fit
+    GLuint fog_texture;
+    int fog_tex_w, fog_tex_h;    // Power of two sizes for GL 1.1
+    Uint8* fog_pixels;           // Luminance of one dirty run
+    size_t fog_pixels_size;
+    GLuint frame_fbo;            // Offscreen copy of the last frame for damage tracking
+    GLuint frame_texture;
+    int frame_w, frame_h;
+    int frame_valid;
+} GlRenderer;
+
+// --- Upload the tileset texture ---
+static void upload_tileset(GlRenderer* r) {
+    const SDL_Surface* surface = r->tileset->surface;
+
+    glGenTextures(1, &r->texture_id);
+    state_bind_texture(&r->state, r->texture_id);
+
+    // Use nearest filtering to prevent bleeding artifacts
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+    // The core hands us tightly packed RGBA rows unless the surface is padded
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, surface->pitch / 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    r->step_u = 1.0f / r->tileset->cols;
+    r->step_v = 1.0f / r->tileset->rows;
+}
+
+// --- Optimized draw_tile with precomputed UV steps ---
+static void draw_tile(
+    int tx, int ty, TileEntry tile,
+    int tw, int th,
+    float zoom, float offset_x, float offset_y,
+    int lod,
+    float step_u, float step_v) {
+
+    // Use precomputed texture step size; the corners come permuted by the tile's transform
+    float uv[8];
+    tile_quad_uvs(tile, step_u, step_v, uv);
+
+    // Convert to screen-space coordinates
+    float x = (tx * tw + offset_x) * zoom;
+    float y = (ty * th + offset_y) * zoom;
+    float w = tw * zoom * lod;
+    float h = th * zoom * lod;
+
+    glBegin(GL_QUADS);
+    glTexCoord2f(uv[0], uv[1]);  glVertex2f(x, y);
+    glTexCoord2f(uv[2], uv[3]);  glVertex2f(x + w, y);
+    glTexCoord2f(uv[4], uv[5]);  glVertex2f(x + w, y + h);
+    glTexCoord2f(uv[6], uv[7]);  glVertex2f(x, y + h);
+    glEnd();
+}
+
+// --- Draw a red outline box around hovered tile ---
+static void draw_tile_outline(GlRenderer* r, const View* view) {
+    const Camera* cam = &view->camera;
+    float x = (view->hover_x * view->tile_width + cam->offset_x) * cam->zoom;
+    float y = (view->hover_y * view->tile_height + cam->offset_y) * cam->zoom;
+    float w = view->tile_width * cam->zoom;
+    float h = view->tile_height * cam->zoom;
+    float px = OUTLINE_PIXEL_WIDTH;
+
+    state_use_program(&r->state, 0);
+    state_disable(&r->state, STATE_TEXTURE_2D);
+    state_disable(&r->state, STATE_BLEND);
+    state_colour(&r->state, 1.0f, 0.0f, 0.0f, 1.0f); // Red
+
+    // Four edges of the box
+    glBegin(GL_QUADS); // Top
+    glVertex2f(x, y); glVertex2f(x + w, y); glVertex2f(x + w, y + px); glVertex2f(x, y + px);
+    glEnd();
+
+    glBegin(GL_QUADS); // Bottom
+    glVertex2f(x, y + h - px); glVertex2f(x + w, y + h - px); glVertex2f(x + w, y + h); glVertex2f(x, y + h);
+    glEnd();
+
+    glBegin(GL_QUADS); // Left
+    glVertex2f(x, y); glVertex2f(x + px, y); glVertex2f(x + px, y + h); glVertex2f(x, y + h);
+    glEnd();
+
+    glBegin(GL_QUADS); // Right
+    glVertex2f(x + w - px, y); glVertex2f(x + w, y); glVertex2f(x + w, y + h); glVertex2f(x + w - px, y + h);
+    glEnd();
+}
+
+// --- Fixed-function texturing from `texture`, unmodulated ---
+static void use_texture_state(GlRenderer* r, GLuint texture) {
+    state_use_program(&r->state, 0);
+    state_enable(&r->state, STATE_TEXTURE_2D);
+    state_disable(&r->state, STATE_BLEND);
+    state_colour(&r->state, 1.0f, 1.0f, 1.0f, 1.0f);
+    state_bind_texture(&r->state, texture);
+}
+
+static void ensure_draw_buffer(DrawBuffer* buf, int needed) {
+    if (needed > buf->capacity) {
+        buf->data = realloc(buf->data, sizeof(TileDrawCmd) * needed);
+        buf->capacity = needed;
+    }
+}
+
+// --- Gather visible tiles into the draw buffer ---
+static int gather_visible_tiles(GlRenderer* r, const View* view) {
+    int lod = view->lod;
+    int start_x = view->start_x, start_y = view->start_y;
+    int max_x = view->max_x, max_y = view->max_y;
+    const TileMap* map = r->map;
+
+    // Open MP parallelisation
+    int tiles_x = ((max_x - start_x) + lod - 1) / lod;
+    int tiles_y = ((max_y - start_y) + lod - 1) / lod;
+    if (tiles_x <= 0 || tiles_y <= 0) return 0;
+    int estimated_tiles = tiles_x * tiles_y * LAYER_COUNT;
+
+    ensure_draw_buffer(&r->draw_buf, estimated_tiles);
+    TileDrawCmd* data = r->draw_buf.data;
+
+    int draw_count = 0;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int y = start_y; y < max_y; y += lod) {
+        for (int x = start_x; x < max_x; x += lod) {
+            TileEntry tile = map->tiles[(size_t)y * map->width + x];
+
+            int local_index;
+            #pragma omp atomic capture
+            local_index = draw_count++;
+
+            data[local_index].x = x;
+            data[local_index].y = y;
+            data[local_index].tile = tile;
+            data[local_index].colour = tint_colour(view->tints, x, y);
+        }
+    }
+    return draw_count;
+}
+
+static void gl_set_projection(int width, int height) {
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, width, height, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+static void gl_destroy(void* impl) {
+    GlRenderer* r = impl;
+    if (r->context) {
+        state_delete_texture(&r->state, r->texture_id);
+        state_delete_texture(&r->state, r->frame_texture);
+        state_delete_texture(&r->state, r->fog_texture);
+        if (r->frame_fbo) r->ext.DeleteFramebuffers(1, &r->frame_fbo);
+        stream_free(&r->stream);
+        chunks_free(&r->chunks);
+        quad_indices_free(&r->quads);
+        points_free(&r->points);
+        readback_free(&r->readback);
+        SDL_GL_DeleteContext(r->context);
+    }
+    free(r->draw_buf.data);
+    free(r->fog_pixels);
+    visset_free(&r->visset);
+    free(r);
+}
+
+static void* gl_create(SDL_Window* window, const Tileset* tileset, const TileMap* map, int path, Uint32 flags) {
+    GlRenderer* r = calloc(1, sizeof(GlRenderer));
+    if (!r) return NULL;
+    r->window = window;
+    r->tileset = tileset;
+    r->map = map;
+    r->path = path;
+    visset_init(&r->visset);
+
+    r->context = SDL_GL_CreateContext(window);
+    if (!r->context) {
+        printf("SDL_GL_CreateContext failed: %s\n", SDL_GetError());
+        gl_destroy(r);
+        return NULL;
+    }
+
+    gl_ext_load(&r->ext);
+    state_init(&r->state, &r->ext);
+    readback_init(&r->readback, &r->state);
+
+    StreamMode max_mode = (flags & RENDER_STREAM_CLIENT) ? STREAM_CLIENT :
+                          (flags & RENDER_STREAM_ORPHAN) ? STREAM_ORPHAN : STREAM_PERSISTENT;
+    stream_init(&r->stream, &r->state, max_mode);
+    chunks_init(&r->chunks, &r->state, path == GL_PATH_CHUNKS_F32 ? CHUNK_FORMAT_FLOAT : CHUNK_FORMAT_SHORT);
+    r->indexed = !(flags & RENDER_GL_QUADS) && quad_indices_init(&r->quads, &r->state);
+    printf("OpenGL %s, vertex streaming: %s\n", (const char*)glGetString(GL_VERSION),
+           stream_mode_names[r->stream.mode]);
+
+    if (path == GL_PATH_POINTS) {
+        if (points_init(&r->points, &r->state, tileset)) {
+            printf("Point sprites up to %.0f pixels\n", r->points.max_point_size);
+        } else {
+            printf("Point sprites unavailable, drawing quads\n");
+        }
+    }
+
+    r->damage_tracking = (flags & RENDER_DAMAGE_TRACKING) != 0;
+    if (r->damage_tracking && !r->ext.has_fbo) {
+        printf("Framebuffer objects unsupported, damage tracking disabled\n");
+        r->damage_tracking = 0;
+    }
+
+    SDL_GetWindowSize(window, &r->width, &r->height);
+    gl_set_projection(r->width, r->height);
+
+    upload_tileset(r);
+    return r;
+}
+
+static void gl_resize(void* impl, int width, int height) {
+    GlRenderer* r = impl;
+    r->width = width;
+    r->height = height;
+    gl_set_projection(width, height);
+}
+
+// --- `count` quads of TileVertex starting at `base`, indexed or as GL_QUADS ---
+static void draw_vertex_quads(GlRenderer* r, const unsigned char* base, int count, int colour_offset,
+                              FrameStats* stats) {
+    if (count == 0) return;
+    state_enable(&r->state, STATE_VERTEX_ARRAY | STATE_TEXCOORD_ARRAY);
+    if (r->indexed) {
+        QuadArrays arrays = { base, sizeof(TileVertex), GL_FLOAT, offsetof(TileVertex, u), colour_offset };
+        draw_indexed_quads(&r->quads, &arrays, count, stats);
+        return;
+    }
+
+    glVertexPointer(2, GL_FLOAT, sizeof(TileVertex), base + offsetof(TileVertex, x));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(TileVertex), base + offsetof(TileVertex, u));
+    if (colour_offset >= 0) {
+        state_enable(&r->state, STATE_COLOR_ARRAY);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TileVertex), base + colour_offset);
+    } else {
+        state_disable(&r->state, STATE_COLOR_ARRAY);
+    }
+    glDrawArrays(GL_QUADS, 0, count * 4);
+    if (colour_offset >= 0) state_forget_colour(&r->state);
+    stats->draw_calls++;
+}
+
+// --- Draw the visible set, and any entities after it, from one vertex array; the camera lives in the
+// modelview matrix ---
+static void draw_visible_set(GlRenderer* r, const View* view, FrameStats* stats) {
+    const Camera* cam = &view->camera;
+
+    // The batched path throws the set away every frame to measure a full rebuild
+    if (r->path == GL_PATH_BATCHED) visset_invalidate(&r->visset);
+    stats->tiles_built += visset_update(&r->visset, view, r->map, r->tileset);
+
+    int tile_vertices = visset_vertex_count(&r->visset);
+    int entity_count = view->entities ? view->entities->visible_count : 0;
+    int vertex_count = tile_vertices + entity_count * 4;
+    if (vertex_count == 0) return;
+
+    // Client arrays can point straight at a set without entities; otherwise the set is copied into this
+    // frame's region and the entity quads are written after it
+    const unsigned char* base = (const unsigned char*)r->visset.vertices;
+    size_t tile_bytes = sizeof(TileVertex) * (size_t)tile_vertices;
+    size_t bytes = sizeof(TileVertex) * (size_t)vertex_count;
+    if (r->stream.mode != STREAM_CLIENT || entity_count > 0) {
+        unsigned char* dst = stream_begin(&r->stream, bytes, stats);
+        if (!dst) return;
+        memcpy(dst, r->visset.vertices, tile_bytes);
+        if (entity_count > 0) entities_emit(view->entities, r->tileset, (TileVertex*)(dst + tile_bytes));
+        base = stream_end(&r->stream);
+    } else {
+        state_bind_buffer(&r->state, GL_ARRAY_BUFFER, 0);
+        stats->bytes_streamed += bytes;
+    }
+
+    glPushMatrix();
+    glScalef(cam->zoom, cam->zoom, 1.0f);
+    glTranslatef(cam->offset_x, cam->offset_y, 0.0f);
+
+    // Tints ride along as a colour array that GL_MODULATE multiplies in; untinted views leave it off
+    int colour_offset = view->tints ? (int)offsetof(TileVertex, colour) : -1;
+    draw_vertex_quads(r, base, tile_vertices / 4, colour_offset, stats);
+
+    // Sprites are cut out of tileset cells, so their transparent texels must show the tiles below:
+    // one more draw over the same region, blended, in the y-sorted order they were emitted
+    if (entity_count > 0) {
+        state_enable(&r->state, STATE_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        draw_vertex_quads(r, base + tile_bytes, entity_count, colour_offset, stats);
+    }
+
+    glPopMatrix();
+
+    if (r->stream.mode != STREAM_CLIENT) stream_fence(&r->stream);
+
+    stats->tiles_drawn += tile_vertices / 4;
+    stats->entities_drawn += entity_count;
+    stats->vertex_bytes += bytes;
+    stats->vertex_memory += sizeof(TileVertex) * 4 * (Uint64)r->visset.capacity +
+                            r->stream.region_size * (r->stream.mode == STREAM_PERSISTENT ? STREAM_REGIONS : 1);
+}
+
+// --- One glBegin/glEnd quad per visible tile ---
+static void draw_immediate(GlRenderer* r, const View* view, FrameStats* stats) {
+    const Camera* cam = &view->camera;
+    int draw_count = gather_visible_tiles(r, view);
+
+    // One glColor per tile here, so tinted hover redraws match the batched paths
+    for (int i = 0; i < draw_count; ++i) {
+        TileDrawCmd* cmd = &r->draw_buf.data[i];
+        if (view->tints) glColor4ubv((const GLubyte*)&cmd->colour);
+        draw_tile(cmd->x, cmd->y, cmd->tile, view->tile_width, view->tile_height,
+                  cam->zoom, cam->offset_x, cam->offset_y, view->lod, r->step_u, r->step_v);
+    }
+    if (view->tints) state_forget_colour(&r->state);
+    stats->draw_calls += draw_count;
+    stats->tiles_drawn += draw_count;
+    stats->tiles_built += draw_count;
+    stats->vertex_bytes += (Uint64)draw_count * 4 * sizeof(TileVertex);
+}
+
+// --- Fog of war: upload what changed, then darken the map with one quad (dst * luminance) ---
+static void upload_fog_rect(GlRenderer* r, const FogMap* fog, const SDL_Rect* rect) {
+    size_t bytes = (size_t)rect->w * rect->h;
+    if (bytes > r->fog_pixels_size) {
+        Uint8* pixels = realloc(r->fog_pixels, bytes);
+        if (!pixels) return;
+        r->fog_pixels = pixels;
+        r->fog_pixels_size = bytes;
+    }
+    fog_luminance(fog, rect, r->fog_pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect->x, rect->y, rect->w, rect->h, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                    r->fog_pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+static void draw_fog(GlRenderer* r, const View* view, FrameStats* stats) {
+    const FogMap* fog = view->fog;
+    if (fog != r->fog) {
+        r->fog = fog;
+        r->fog_tex_w = r->fog_tex_h = 1;
+        while (r->fog_tex_w < fog->width) r->fog_tex_w *= 2;
+        while (r->fog_tex_h < fog->height) r->fog_tex_h *= 2;
+        GLint max_size = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+        if (r->fog_tex_w > max_size || r->fog_tex_h > max_size) {
+            printf("Fog of war needs a %dx%d texture, the limit is %d; not drawn\n", r->fog_tex_w, r->fog_tex_h, max_size);
+            r->fog_tex_w = 0;
+            return;
+        }
+        if (!r->fog_texture) glGenTextures(1, &r->fog_texture);
+        state_bind_texture(&r->state, r->fog_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, r->fog_tex_w, r->fog_tex_h, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
+        SDL_Rect all = { 0, 0, fog->width, fog->height };
+        upload_fog_rect(r, fog, &all);
+    } else if (r->fog_tex_w) {
+        state_bind_texture(&r->state, r->fog_texture);
+        for (int i = 0; i < fog->dirty_count; i++) upload_fog_rect(r, fog, &fog->dirty[i]);
+    }
+    if (!r->fog_tex_w) return;
+
+    const Camera* cam = &view->camera;
+    float x = cam->offset_x * cam->zoom, y = cam->offset_y * cam->zoom;
+    float x2 = (fog->width * view->tile_width + cam->offset_x) * cam->zoom;
+    float y2 = (fog->height * view->tile_height + cam->offset_y) * cam->zoom;
+    float u2 = (float)fog->width / r->fog_tex_w, v2 = (float)fog->height / r->fog_tex_h;
+
+    use_texture_state(r, r->fog_texture);
+    state_enable(&r->state, STATE_BLEND);
+    glBlendFunc(GL_ZERO, GL_SRC_COLOR);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f); glVertex2f(x, y);
+    glTexCoord2f(u2, 0.0f);   glVertex2f(x2, y);
+    glTexCoord2f(u2, v2);     glVertex2f(x2, y2);
+    glTexCoord2f(0.0f, v2);   glVertex2f(x, y2);
+    glEnd();
+    stats->draw_calls++;
+}
+
+// --- Clear, tiles and outline for the tile range of `view` using the selected path ---
+static void draw_scene(GlRenderer* r, const View* view, FrameStats* stats) {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT); // Clear the screen before rendering
+
+    use_texture_state(r, r->texture_id); // Tileset texture for drawing
+
+    // --- DRAW TILES ---
+    if (r->path == GL_PATH_IMMEDIATE) {
+        draw_immediate(r, view, stats);
+    } else if (r->path == GL_PATH_CHUNKS || r->path == GL_PATH_CHUNKS_F32) {
+        chunks_draw(&r->chunks, r->indexed ? &r->quads : NULL, view, r->map, r->tileset, stats);
+    } else if (r->path == GL_PATH_POINTS &&
+               points_draw(&r->points, &r->stream, view, r->map, r->width, r->height, stats)) {
+        // Drawn as sprites
+    } else {
+        draw_visible_set(r, view, stats);
+    }
+
+    if (view->fog) draw_fog(r, view, stats);
+
+    // --- MOUSE HOVER TILE OUTLINE ---
+    if (view->hover_x >= 0) {
+        draw_tile_outline(r, view);
+        stats->draw_calls += 4;
+    }
+}
+
+// --- Redraw one tile's rectangle under glScissor; a handful of immediate quads ---
+static void redraw_tile_rect(GlRenderer* r, const View* view, int tile_x, int tile_y, FrameStats* stats) {
+    if (tile_x < 0) return;
+
+    SDL_Rect rect;
+    View sub;
+    view_tile_rect(view, tile_x, tile_y, &rect);
+    view_restrict(view, r->map, &rect, &sub);
+
+    // glScissor counts rows from the bottom of the framebuffer
+    glScissor(rect.x, r->height - (rect.y + rect.h), rect.w, rect.h);
+    glClear(GL_COLOR_BUFFER_BIT);
+    use_texture_state(r, r->texture_id);
+    draw_immediate(r, &sub, stats);
+    if (view->fog) draw_fog(r, view, stats);
+    if (view->hover_x >= 0) {
+        draw_tile_outline(r, view);
+        stats->draw_calls += 4;
+    }
+}
+
+static int ensure_frame_target(GlRenderer* r) {
+    if (r->frame_fbo && r->frame_w == r->width && r->frame_h == r->height) return 1;
+
+    if (!r->frame_fbo) r->ext.GenFramebuffers(1, &r->frame_fbo);
+    if (!r->frame_texture) glGenTextures(1, &r->frame_texture);
+
+    state_bind_texture(&r->state, r->frame_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, r->width, r->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    r->ext.BindFramebuffer(GL_FRAMEBUFFER, r->frame_fbo);
+    r->ext.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, r->frame_texture, 0);
+    int complete = r->ext.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    r->ext.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    r->frame_w = r->width;
+    r->frame_h = r->height;
+    r->frame_valid = 0;
+    if (!complete) {
+        printf("Offscreen frame incomplete, damage tracking disabled\n");
+        r->damage_tracking = 0;
+    }
+    return complete;
+}
+
+// --- Damage-tracked frame: update the offscreen frame, then copy it to the back buffer ---
+static int draw_tracked(GlRenderer* r, const View* view, FrameStats* stats) {
+    if (!ensure_frame_target(r)) return 0;
+
+    r->ext.BindFramebuffer(GL_FRAMEBUFFER, r->frame_fbo);
+    if (!r->frame_valid || view->damage == DAMAGE_FULL) {
+        draw_scene(r, view, stats);
+        r->frame_valid = 1;
+    } else if (view->damage == DAMAGE_HOVER) {
+        state_enable(&r->state, STATE_SCISSOR_TEST);
+        redraw_tile_rect(r, view, view->prev_hover_x, view->prev_hover_y, stats);
+        redraw_tile_rect(r, view, view->hover_x, view->hover_y, stats);
+        state_disable(&r->state, STATE_SCISSOR_TEST);
+    }
+    r->ext.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // The texture's origin is the bottom-left corner, the projection's is the top-left
+    float w = (float)r->width, h = (float)r->height;
+    use_texture_state(r, r->frame_texture);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 1.0f); glVertex2f(0.0f, 0.0f);
+    glTexCoord2f(1.0f, 1.0f); glVertex2f(w, 0.0f);
+    glTexCoord2f(1.0f, 0.0f); glVertex2f(w, h);
+    glTexCoord2f(0.0f, 0.0f); glVertex2f(0.0f, h);
+    glEnd();
+    stats->draw_calls++;
+    return 1;
+}
+
+static void gl_draw(void* impl, const View* view, FrameStats* stats) {
+    GlRenderer* r = impl;
+    stats->lod = view->lod;
+    Uint64 issued = r->state.issued, skipped = r->state.skipped;
+
+    if (!r->damage_tracking || !draw_tracked(r, view, stats)) draw_scene(r, view, stats);
+
+    stats->state_changes += (int)(r->state.issued - issued);
+    stats->state_skipped += (int)(r->state.skipped - skipped);
+}
+
+static void gl_present(void* impl) {
+    GlRenderer* r = impl;
+    SDL_GL_SwapWindow(r->window); // Present the rendered frame
+}
+
+static void gl_capture(void* impl, FrameWriter* writer, int finish) {
+    GlRenderer* r = impl;
+    if (finish) {
+        readback_finish(&r->readback, writer);
+    } else {
+        readback_frame(&r->readback, writer, r->width, r->height);
+    }
+}
+
+const RendererBackend gl_backend = {
+    "gl",
+    gl_path_names,
+    sizeof(gl_path_names) / sizeof(gl_path_names[0]),
+    SDL_WINDOW_OPENGL,
+    gl_create,
+    gl_destroy,
+    gl_resize,
+    gl_draw,
+    gl_present,
+    gl_capture
+};
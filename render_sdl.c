@@ -0,0 +1,495 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SDL_Renderer backend. Paths:
+//   pyramid - per-tile copies, switching to the overview pyramid below LOD_PIXEL_THRESHOLD
+//   tiles   - per-tile copies at every zoom, using the core's LOD skipping when zoomed out
+// With RENDER_DAMAGE_TRACKING the frame is kept in a target texture and hover-only
+// frames redraw just the old and new highlight rectangles under a clip rect.
+// Capture reads the back buffer synchronously with SDL_RenderReadPixels.
+
+#include "render.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define OVERVIEW_MAX_LEVELS 16
+#define OVERVIEW_DEFAULT_MAX_TEXTURE 4096
+
+enum { SDL_PATH_PYRAMID, SDL_PATH_TILES };
+static const char* const sdl_path_names[] = { "pyramid", "tiles" };
+
+// One level of the overview pyramid. Level 0 holds one texel per map tile,
+// each further level halves the resolution. Levels wider than the renderer's
+// maximum texture size are split into a grid of pieces. The texels stay on the
+// CPU too, so a map edit only re-filters and re-uploads the texels above it.
+typedef struct {
+    int width, height;     // Size of the level in texels
+    int span;              // Map tiles covered by one texel along each axis
+    int piece_w, piece_h;
+    int pieces_x, pieces_y;
+    SDL_Texture** pieces;
+    Uint32* pixels;        // width * height texels, as uploaded
+} OverviewLevel;
+
+typedef struct {
+    int level_count;
+    OverviewLevel levels[OVERVIEW_MAX_LEVELS];
+    Uint32 revision;       // Map revision the levels were built from
+} Overview;
+
+typedef struct {
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    Overview overview;
+    int damage_tracking;
+    SDL_Texture* frame;          // Persistent copy of the last frame for damage tracking
+    int frame_w, frame_h;
+    int frame_valid;
+    const Tileset* tileset;
+    const TileMap* map;
+    int path;
+} SdlRenderer;
+
+// --- Upload one pyramid level, split into pieces no larger than max_size ---
+static int upload_overview_level(SDL_Renderer* renderer, OverviewLevel* level, const Uint32* pixels, int max_size) {
+    level->piece_w = level->width < max_size ? level->width : max_size;
+    level->piece_h = level->height < max_size ? level->height : max_size;
+    level->pieces_x = (level->width + level->piece_w - 1) / level->piece_w;
+    level->pieces_y = (level->height + level->piece_h - 1) / level->piece_h;
+    level->pieces = calloc(level->pieces_x * level->pieces_y, sizeof(SDL_Texture*));
+    if (!level->pieces) return 0;
+
+    for (int py = 0; py < level->pieces_y; py++) {
+        for (int px = 0; px < level->pieces_x; px++) {
+            int x0 = px * level->piece_w;
+            int y0 = py * level->piece_h;
+            int w = level->width - x0 < level->piece_w ? level->width - x0 : level->piece_w;
+            int h = level->height - y0 < level->piece_h ? level->height - y0 : level->piece_h;
+
+            SDL_Texture* piece = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, w, h);
+            if (!piece) {
+                printf("SDL_CreateTexture failed: %s\n", SDL_GetError());
+                return 0;
+            }
+            SDL_SetTextureBlendMode(piece, SDL_BLENDMODE_BLEND);
+            SDL_UpdateTexture(piece, NULL, pixels + (size_t)y0 * level->width + x0, level->width * (int)sizeof(Uint32));
+            level->pieces[py * level->pieces_x + px] = piece;
+        }
+    }
+    return 1;
+}
+
+// --- Level 0 texels [x0, x1) x [y0, y1) from the map's base layer ---
+static void average_tiles(OverviewLevel* level, const TileMap* map, const Tileset* tileset,
+                          int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+        const TileEntry* row = map->tiles + (size_t)y * map->width;
+        for (int x = x0; x < x1; x++) {
+            level->pixels[(size_t)y * level->width + x] = tileset->average_colours[tile_index_of(tileset, row[x])];
+        }
+    }
+}
+
+// --- 2x2 box filter of `child` into texels [x0, x1) x [y0, y1) of `parent`; odd edges repeat
+// their last row/column ---
+static void filter_texels(OverviewLevel* parent, const OverviewLevel* child, int x0, int y0, int x1, int y1) {
+    int w = child->width, h = child->height;
+    const Uint32* pixels = child->pixels;
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            int cx0 = x * 2, cy0 = y * 2;
+            int cx1 = cx0 + 1 < w ? cx0 + 1 : cx0;
+            int cy1 = cy0 + 1 < h ? cy0 + 1 : cy0;
+            const Uint8* p[4] = {
+                (const Uint8*)&pixels[cy0 * w + cx0], (const Uint8*)&pixels[cy0 * w + cx1],
+                (const Uint8*)&pixels[cy1 * w + cx0], (const Uint8*)&pixels[cy1 * w + cx1]
+            };
+            Uint32 out;
+            Uint8* o = (Uint8*)&out;
+            for (int c = 0; c < 4; c++) {
+                o[c] = (Uint8)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+            }
+            parent->pixels[y * parent->width + x] = out;
+        }
+    }
+}
+
+// --- Re-upload texels [x0, x1) x [y0, y1) of a level to the pieces they fall in ---
+static void upload_texels(OverviewLevel* level, int x0, int y0, int x1, int y1) {
+    for (int py = y0 / level->piece_h; py <= (y1 - 1) / level->piece_h; py++) {
+        for (int px = x0 / level->piece_w; px <= (x1 - 1) / level->piece_w; px++) {
+            int left = px * level->piece_w, top = py * level->piece_h;
+            int rx0 = x0 > left ? x0 : left, ry0 = y0 > top ? y0 : top;
+            int rx1 = x1 < left + level->piece_w ? x1 : left + level->piece_w;
+            int ry1 = y1 < top + level->piece_h ? y1 : top + level->piece_h;
+            SDL_Rect rect = { rx0 - left, ry0 - top, rx1 - rx0, ry1 - ry0 };
+            SDL_UpdateTexture(level->pieces[py * level->pieces_x + px], &rect,
+                              level->pixels + (size_t)ry0 * level->width + rx0, level->width * (int)sizeof(Uint32));
+        }
+    }
+}
+
+// --- Build the overview pyramid: one texel per tile, then 2x2 box filtered levels ---
+static int build_overview(SDL_Renderer* renderer, Overview* overview, const TileMap* map, const Tileset* tileset) {
+    SDL_RendererInfo info;
+    int max_size = OVERVIEW_DEFAULT_MAX_TEXTURE;
+    if (SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0) {
+        max_size = info.max_texture_width < info.max_texture_height ? info.max_texture_width : info.max_texture_height;
+    }
+
+    int w = map->width, h = map->height;
+    overview->level_count = 0;
+    overview->revision = map->revision;
+    for (;;) {
+        OverviewLevel* level = &overview->levels[overview->level_count++];
+        level->width = w;
+        level->height = h;
+        level->span = 1 << (overview->level_count - 1);
+        level->pixels = malloc(sizeof(Uint32) * (size_t)w * h);
+        if (!level->pixels) return 0;
+        if (overview->level_count == 1) average_tiles(level, map, tileset, 0, 0, w, h);
+        else filter_texels(level, level - 1, 0, 0, w, h);
+        if (!upload_overview_level(renderer, level, level->pixels, max_size)) return 0;
+        if ((w == 1 && h == 1) || overview->level_count == OVERVIEW_MAX_LEVELS) break;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+    return 1;
+}
+
+// --- Re-average map tiles [x0, x1) x [y0, y1), then re-filter the texels above them level by level ---
+static void refresh_overview(Overview* overview, const TileMap* map, const Tileset* tileset,
+                             int x0, int y0, int x1, int y1) {
+    average_tiles(&overview->levels[0], map, tileset, x0, y0, x1, y1);
+    upload_texels(&overview->levels[0], x0, y0, x1, y1);
+    for (int i = 1; i < overview->level_count; i++) {
+        x0 /= 2;
+        y0 /= 2;
+        x1 = (x1 + 1) / 2;
+        y1 = (y1 + 1) / 2;
+        filter_texels(&overview->levels[i], &overview->levels[i - 1], x0, y0, x1, y1);
+        upload_texels(&overview->levels[i], x0, y0, x1, y1);
+    }
+}
+
+static int chunk_edited(const TileMap* map, int cx, int cy, Uint32 since) {
+    // Revisions wrap, so compare by signed distance
+    return (Sint32)(map->chunk_versions[(size_t)cy * map->chunks_x + cx] - since) > 0;
+}
+
+// --- Bring the pyramid up to the map: refresh every chunk edited since it was built, or the
+// whole map in one pass when most of it changed (a reload or a full autotile) ---
+static void update_overview(Overview* overview, const TileMap* map, const Tileset* tileset) {
+    if (overview->level_count == 0 || overview->revision == map->revision) return;
+    Uint32 since = overview->revision;
+    overview->revision = map->revision;
+
+    int edited = 0;
+    for (int cy = 0; cy < map->chunks_y; cy++) {
+        for (int cx = 0; cx < map->chunks_x; cx++) edited += chunk_edited(map, cx, cy, since);
+    }
+    if (edited * 4 > map->chunks_x * map->chunks_y) {
+        refresh_overview(overview, map, tileset, 0, 0, map->width, map->height);
+        return;
+    }
+
+    for (int cy = 0; cy < map->chunks_y; cy++) {
+        for (int cx = 0; cx < map->chunks_x; cx++) {
+            if (!chunk_edited(map, cx, cy, since)) continue;
+            int x0 = cx * MAP_CHUNK_TILES, y0 = cy * MAP_CHUNK_TILES;
+            int x1 = x0 + MAP_CHUNK_TILES < map->width ? x0 + MAP_CHUNK_TILES : map->width;
+            int y1 = y0 + MAP_CHUNK_TILES < map->height ? y0 + MAP_CHUNK_TILES : map->height;
+            refresh_overview(overview, map, tileset, x0, y0, x1, y1);
+        }
+    }
+}
+
+static void destroy_overview(Overview* overview) {
+    for (int i = 0; i < overview->level_count; i++) {
+        OverviewLevel* level = &overview->levels[i];
+        if (level->pieces) {
+            for (int p = 0; p < level->pieces_x * level->pieces_y; p++) {
+                if (level->pieces[p]) SDL_DestroyTexture(level->pieces[p]);
+            }
+        }
+        free(level->pieces);
+        free(level->pixels);
+    }
+    overview->level_count = 0;
+}
+
+// --- Draw the visible part of the overview with one copy per visible piece ---
+static void draw_overview(SDL_Renderer* renderer, const Overview* overview, const View* view, FrameStats* stats) {
+    const Camera* cam = &view->camera;
+
+    // Pick the finest level whose texels are at least one screen pixel wide
+    float tsz = view->tile_width * cam->zoom;
+    int level_index = 0;
+    while (level_index + 1 < overview->level_count &&
+           overview->levels[level_index].span * tsz < 1.0f) {
+        level_index++;
+    }
+    const OverviewLevel* level = &overview->levels[level_index];
+    stats->lod = level->span;
+
+    float texel_w = (float)view->tile_width * level->span;
+    float texel_h = (float)view->tile_height * level->span;
+    int min_x = (int)floorf(-cam->offset_x / texel_w);
+    int min_y = (int)floorf(-cam->offset_y / texel_h);
+    int max_x = (int)ceilf((cam->screen_w / cam->zoom - cam->offset_x) / texel_w);
+    int max_y = (int)ceilf((cam->screen_h / cam->zoom - cam->offset_y) / texel_h);
+    if (min_x < 0) min_x = 0;
+    if (min_y < 0) min_y = 0;
+    if (max_x > level->width) max_x = level->width;
+    if (max_y > level->height) max_y = level->height;
+
+    for (int py = 0; py < level->pieces_y; py++) {
+        for (int px = 0; px < level->pieces_x; px++) {
+            int x0 = px * level->piece_w, y0 = py * level->piece_h;
+            int x1 = x0 + level->piece_w, y1 = y0 + level->piece_h;
+            if (x0 < min_x) x0 = min_x;
+            if (y0 < min_y) y0 = min_y;
+            if (x1 > max_x) x1 = max_x;
+            if (y1 > max_y) y1 = max_y;
+            if (x0 >= x1 || y0 >= y1) continue;
+
+            SDL_Rect src = {x0 - px * level->piece_w, y0 - py * level->piece_h, x1 - x0, y1 - y0};
+            SDL_FRect dst = {
+                (x0 * texel_w + cam->offset_x) * cam->zoom,
+                (y0 * texel_h + cam->offset_y) * cam->zoom,
+                (x1 - x0) * texel_w * cam->zoom,
+                (y1 - y0) * texel_h * cam->zoom
+            };
+            SDL_RenderCopyF(renderer, level->pieces[py * level->pieces_x + px], &src, &dst);
+            stats->draw_calls++;
+            stats->tiles_drawn += (x1 - x0) * (y1 - y0);
+        }
+    }
+}
+
+// --- Tile transforms as SDL_RenderCopyEx arguments: SDL flips the source first, then rotates it
+// clockwise about the destination centre ---
+static const double transform_angle[TILE_TRANSFORMS] = { 0.0, 0.0, 0.0, 0.0, 90.0, 90.0, 90.0, 90.0 };
+static const int transform_flip[TILE_TRANSFORMS] = {
+    SDL_FLIP_NONE, SDL_FLIP_HORIZONTAL, SDL_FLIP_VERTICAL, SDL_FLIP_HORIZONTAL | SDL_FLIP_VERTICAL,
+    SDL_FLIP_VERTICAL, SDL_FLIP_NONE, SDL_FLIP_HORIZONTAL | SDL_FLIP_VERTICAL, SDL_FLIP_HORIZONTAL
+};
+
+// --- Per-tile copies. Edges are floored from their exact screen position so
+// neighbours share an edge and fractional zoom leaves no gaps or overlaps. ---
+static void draw_tiles(SdlRenderer* r, const View* view, FrameStats* stats) {
+    const Camera* cam = &view->camera;
+    int tw = view->tile_width, th = view->tile_height;
+    int lod = view->lod;
+    stats->lod = lod;
+
+    for (int y = view->start_y; y < view->max_y; y += lod) {
+        int dy = (int)floorf((y * th + cam->offset_y) * cam->zoom);
+        int dy2 = (int)floorf(((y + lod) * th + cam->offset_y) * cam->zoom);
+        for (int x = view->start_x; x < view->max_x; x += lod) {
+            TileEntry tile = r->map->tiles[(size_t)y * r->map->width + x];
+            SDL_Rect src = {tile.sx * tw, tile_row(tile) * th, tw, th};
+
+            int dx = (int)floorf((x * tw + cam->offset_x) * cam->zoom);
+            int dx2 = (int)floorf(((x + lod) * tw + cam->offset_x) * cam->zoom);
+            SDL_Rect dst = {dx, dy, dx2 - dx, dy2 - dy};
+
+            // A quarter turn swaps the rectangle's sides, so it starts out transposed about the same centre
+            int transform = tile_transform(tile), turn = transform >> 2;
+            int skew = turn * (dst.w - dst.h) / 2;
+            SDL_Rect turned = {dst.x + skew, dst.y - skew, dst.w - 2 * skew, dst.h + 2 * skew};
+            SDL_RenderCopyEx(r->renderer, r->texture, &src, &turned, transform_angle[transform], NULL,
+                             (SDL_RendererFlip)transform_flip[transform]);
+            stats->draw_calls++;
+            stats->tiles_drawn++;
+            stats->tiles_built++;
+        }
+    }
+}
+
+static void draw_highlight(SdlRenderer* r, const View* view) {
+    if (view->hover_x < 0) return;
+
+    const Camera* cam = &view->camera;
+    int hx = (int)floorf((view->hover_x * view->tile_width + cam->offset_x) * cam->zoom);
+    int hy = (int)floorf((view->hover_y * view->tile_height + cam->offset_y) * cam->zoom);
+    int hx2 = (int)floorf(((view->hover_x + 1) * view->tile_width + cam->offset_x) * cam->zoom);
+    int hy2 = (int)floorf(((view->hover_y + 1) * view->tile_height + cam->offset_y) * cam->zoom);
+    SDL_Rect highlight = {hx, hy, hx2 - hx > 0 ? hx2 - hx : 1, hy2 - hy > 0 ? hy2 - hy : 1};
+    SDL_SetRenderDrawBlendMode(r->renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(r->renderer, 255, 255, 0, 100);
+    SDL_RenderFillRect(r->renderer, &highlight);
+}
+
+static void sdl_destroy(void* impl) {
+    SdlRenderer* r = impl;
+    destroy_overview(&r->overview);
+    if (r->frame) SDL_DestroyTexture(r->frame);
+    if (r->texture) SDL_DestroyTexture(r->texture);
+    if (r->renderer) SDL_DestroyRenderer(r->renderer);
+    free(r);
+}
+
+static void* sdl_create(SDL_Window* window, const Tileset* tileset, const TileMap* map, int path, Uint32 flags) {
+    SdlRenderer* r = calloc(1, sizeof(SdlRenderer));
+    if (!r) return NULL;
+    r->tileset = tileset;
+    r->map = map;
+    r->path = path;
+
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+    r->renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    if (!r->renderer) {
+        printf("SDL_CreateRenderer failed: %s\n", SDL_GetError());
+        sdl_destroy(r);
+        return NULL;
+    }
+
+    r->damage_tracking = (flags & RENDER_DAMAGE_TRACKING) != 0;
+    if (r->damage_tracking && !SDL_RenderTargetSupported(r->renderer)) {
+        printf("Render targets unsupported, damage tracking disabled\n");
+        r->damage_tracking = 0;
+    }
+
+    r->texture = SDL_CreateTextureFromSurface(r->renderer, tileset->surface);
+    if (!r->texture) {
+        printf("SDL_CreateTextureFromSurface failed: %s\n", SDL_GetError());
+        sdl_destroy(r);
+        return NULL;
+    }
+
+    if (path == SDL_PATH_PYRAMID && !build_overview(r->renderer, &r->overview, map, tileset)) {
+        printf("Failed to build overview pyramid\n");
+        sdl_destroy(r);
+        return NULL;
+    }
+    return r;
+}
+
+static void sdl_resize(void* impl, int width, int height) {
+    // SDL_Renderer tracks the window size itself
+    (void)impl; (void)width; (void)height;
+}
+
+// --- Background, tiles and highlight for the tile range of `view` ---
+static void draw_scene(SdlRenderer* r, const View* view, FrameStats* stats) {
+    float tsz = view->tile_width * view->camera.zoom;
+    if (r->path == SDL_PATH_PYRAMID && tsz < LOD_PIXEL_THRESHOLD) {
+        // Zoomed out: the pyramid keeps the copy count at a handful per frame
+        draw_overview(r->renderer, &r->overview, view, stats);
+    } else {
+        draw_tiles(r, view, stats);
+    }
+
+    draw_highlight(r, view);
+}
+
+// --- Restore one highlight rectangle from the map and redraw the current highlight over it ---
+static void redraw_tile_rect(SdlRenderer* r, const View* view, int tile_x, int tile_y, FrameStats* stats) {
+    if (tile_x < 0) return;
+
+    SDL_Rect rect;
+    View sub;
+    view_tile_rect(view, tile_x, tile_y, &rect);
+    view_restrict(view, r->map, &rect, &sub);
+
+    // SDL_RenderClear ignores the clip rect, so clear with an opaque fill instead
+    SDL_RenderSetClipRect(r->renderer, &rect);
+    SDL_SetRenderDrawBlendMode(r->renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(r->renderer, 0, 0, 0, 255);
+    SDL_RenderFillRect(r->renderer, &rect);
+    draw_scene(r, &sub, stats);
+    SDL_RenderSetClipRect(r->renderer, NULL);
+}
+
+// --- Damage-tracked frame: update the persistent frame texture, then copy it out ---
+static int draw_tracked(SdlRenderer* r, const View* view, FrameStats* stats) {
+    int w, h;
+    SDL_GetRendererOutputSize(r->renderer, &w, &h);
+    if (!r->frame || w != r->frame_w || h != r->frame_h) {
+        if (r->frame) SDL_DestroyTexture(r->frame);
+        r->frame = SDL_CreateTexture(r->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h);
+        r->frame_w = w;
+        r->frame_h = h;
+        r->frame_valid = 0;
+        if (!r->frame) return 0;
+        SDL_SetTextureBlendMode(r->frame, SDL_BLENDMODE_NONE);
+    }
+
+    SDL_SetRenderTarget(r->renderer, r->frame);
+    if (!r->frame_valid || view->damage == DAMAGE_FULL) {
+        SDL_SetRenderDrawColor(r->renderer, 0, 0, 0, 255);
+        SDL_RenderClear(r->renderer);
+        draw_scene(r, view, stats);
+        r->frame_valid = 1;
+    } else if (view->damage == DAMAGE_HOVER) {
+        redraw_tile_rect(r, view, view->prev_hover_x, view->prev_hover_y, stats);
+        redraw_tile_rect(r, view, view->hover_x, view->hover_y, stats);
+    }
+    SDL_SetRenderTarget(r->renderer, NULL);
+
+    SDL_RenderCopy(r->renderer, r->frame, NULL, NULL);
+    stats->draw_calls++;
+    return 1;
+}
+
+static void sdl_draw(void* impl, const View* view, FrameStats* stats) {
+    SdlRenderer* r = impl;
+    stats->lod = view->lod;
+    if (r->path == SDL_PATH_PYRAMID) update_overview(&r->overview, r->map, r->tileset);
+
+    if (r->damage_tracking && draw_tracked(r, view, stats)) return;
+
+    SDL_SetRenderDrawColor(r->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(r->renderer);
+    draw_scene(r, view, stats);
+}
+
+static void sdl_present(void* impl) {
+    SdlRenderer* r = impl;
+    SDL_RenderPresent(r->renderer);
+}
+
+static void sdl_capture(void* impl, FrameWriter* writer, int finish) {
+    SdlRenderer* r = impl;
+    if (finish) return;
+
+    int w, h;
+    SDL_GetRendererOutputSize(r->renderer, &w, &h);
+    if (w != writer->width || h != writer->height) return;
+
+    unsigned char* pixels = capture_acquire(writer);
+    if (SDL_RenderReadPixels(r->renderer, NULL, SDL_PIXELFORMAT_RGBA32, pixels, w * 4) == 0) {
+        capture_submit(writer, 0);
+    }
+}
+
+const RendererBackend sdl_backend = {
+    "sdl",
+    sdl_path_names,
+    sizeof(sdl_path_names) / sizeof(sdl_path_names[0]),
+    0,
+    sdl_create,
+    sdl_destroy,
+    sdl_resize,
+    sdl_draw,
+    sdl_present,
+    sdl_capture
+};
@@ -0,0 +1,146 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Software backend for machines without a GPU. Paths:
+//   strips - soft_raster.c drawing horizontal strips on all cores
+//   single - the same rasteriser on one thread, for comparison
+// Frames are drawn straight into the window surface, which keeps its contents
+// between frames, so with RENDER_DAMAGE_TRACKING hover-only frames redraw just
+// the old and new outline rectangles and idle frames draw nothing.
+
+#include "render.h"
+#include "soft_raster.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+enum { SOFT_PATH_STRIPS, SOFT_PATH_SINGLE };
+static const char* const soft_path_names[] = { "strips", "single" };
+
+typedef struct {
+    SDL_Window* window;
+    SoftRaster raster;
+    Uint32 format;               // Pixel format the raster's atlas was converted to
+    const Tileset* tileset;
+    const TileMap* map;
+    int path;
+    int damage_tracking;
+    int frame_valid;
+} SoftRenderer;
+
+static void soft_destroy(void* impl) {
+    SoftRenderer* r = impl;
+    soft_free(&r->raster);
+    free(r);
+}
+
+// --- (Re)convert the tileset when the window surface format changes ---
+static int match_surface(SoftRenderer* r, const SDL_Surface* surface) {
+    if (r->raster.atlas && r->format == surface->format->format) return 1;
+    soft_free(&r->raster);
+    r->format = surface->format->format;
+    r->frame_valid = 0;
+    return soft_init(&r->raster, r->tileset, r->format, r->path == SOFT_PATH_STRIPS);
+}
+
+static void* soft_create(SDL_Window* window, const Tileset* tileset, const TileMap* map, int path, Uint32 flags) {
+    SoftRenderer* r = calloc(1, sizeof(SoftRenderer));
+    if (!r) return NULL;
+    r->window = window;
+    r->tileset = tileset;
+    r->map = map;
+    r->path = path;
+    r->damage_tracking = (flags & RENDER_DAMAGE_TRACKING) != 0;
+
+    SDL_Surface* surface = SDL_GetWindowSurface(window);
+    if (!surface) {
+        printf("SDL_GetWindowSurface failed: %s\n", SDL_GetError());
+        soft_destroy(r);
+        return NULL;
+    }
+    if (!match_surface(r, surface)) {
+        soft_destroy(r);
+        return NULL;
+    }
+    printf("Software rendering into %s, %s blending\n", SDL_GetPixelFormatName(r->format), r->raster.blend_name);
+    return r;
+}
+
+static void soft_resize(void* impl, int width, int height) {
+    SoftRenderer* r = impl;
+    (void)width; (void)height;
+    r->frame_valid = 0;          // The window surface is recreated on the next SDL_GetWindowSurface
+}
+
+static void redraw_tile_rect(SoftRenderer* r, const SoftTarget* target, const View* view,
+                             int tile_x, int tile_y, FrameStats* stats) {
+    if (tile_x < 0) return;
+    SDL_Rect rect;
+    view_tile_rect(view, tile_x, tile_y, &rect);
+    soft_draw(&r->raster, target, view, r->map, &rect, stats);
+}
+
+static void soft_draw_frame(void* impl, const View* view, FrameStats* stats) {
+    SoftRenderer* r = impl;
+    stats->lod = view->lod;
+
+    SDL_Surface* surface = SDL_GetWindowSurface(r->window);
+    if (!surface || !match_surface(r, surface)) return;
+    if (SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0) return;
+
+    SoftTarget target = { surface->pixels, surface->w, surface->h, surface->pitch / 4, 0, 0 };
+    if (!r->damage_tracking || !r->frame_valid || view->damage == DAMAGE_FULL) {
+        soft_draw(&r->raster, &target, view, r->map, NULL, stats);
+        r->frame_valid = 1;
+    } else if (view->damage == DAMAGE_HOVER) {
+        redraw_tile_rect(r, &target, view, view->prev_hover_x, view->prev_hover_y, stats);
+        redraw_tile_rect(r, &target, view, view->hover_x, view->hover_y, stats);
+    }
+
+    if (SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+}
+
+static void soft_present(void* impl) {
+    SoftRenderer* r = impl;
+    SDL_UpdateWindowSurface(r->window);
+}
+
+static void soft_capture(void* impl, FrameWriter* writer, int finish) {
+    SoftRenderer* r = impl;
+    SDL_Surface* surface = SDL_GetWindowSurface(r->window);
+    if (finish || !surface || surface->w != writer->width || surface->h != writer->height) return;
+
+    unsigned char* pixels = capture_acquire(writer);
+    if (SDL_ConvertPixels(surface->w, surface->h, surface->format->format, surface->pixels, surface->pitch,
+                          SDL_PIXELFORMAT_RGBA32, pixels, surface->w * 4) == 0) {
+        capture_submit(writer, 0);
+    }
+}
+
+const RendererBackend soft_backend = {
+    "soft",
+    soft_path_names,
+    sizeof(soft_path_names) / sizeof(soft_path_names[0]),
+    0,
+    soft_create,
+    soft_destroy,
+    soft_resize,
+    soft_draw_frame,
+    soft_present,
+    soft_capture
+};
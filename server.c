@@ -0,0 +1,452 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L      // sigaction, poll and Unix sockets under -std=c99
+
+#include "server.h"
+#include "soft_raster.h"
+#include "blend.h"
+#include "export.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int run_server(const char* socket_path, const Tileset* tileset, const TileMap* map) {
+    (void)socket_path;
+    (void)tileset;
+    (void)map;
+    printf("The render server needs Unix domain sockets\n");
+    return 0;
+}
+
+int run_load(const LoadOptions* options, int world_width, int world_height) {
+    (void)options;
+    (void)world_width;
+    (void)world_height;
+    printf("The load generator needs Unix domain sockets\n");
+    return 0;
+}
+
+#else
+
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// --- One request in flight; the buffers persist across batches and only grow ---
+typedef struct {
+    SoftRaster raster;
+    Uint32* pixels;
+    size_t pixel_capacity;
+    PngBuffer png;
+    ServerResponse response;
+    const void* payload;
+} ServerWorker;
+
+typedef struct {
+    int client;                  // Index into the poll set
+    ServerRequest request;
+} PendingRequest;
+
+static volatile sig_atomic_t server_stop;
+
+static void on_stop_signal(int signal_number) {
+    (void)signal_number;
+    server_stop = 1;
+}
+
+static double ticks_ms(Uint64 ticks) {
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// --- Blocking transfers of a whole message; 0 on error, timeout or when the peer closed ---
+static int read_full(int fd, void* data, size_t size) {
+    unsigned char* p = data;
+    while (size) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        p += n;
+        size -= (size_t)n;
+    }
+    return 1;
+}
+
+static int write_full(int fd, const void* data, size_t size) {
+    const unsigned char* p = data;
+    while (size) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        p += n;
+        size -= (size_t)n;
+    }
+    return 1;
+}
+
+static int socket_address(struct sockaddr_un* address, const char* path) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        printf("Socket path too long: %s\n", path);
+        return 0;
+    }
+    strcpy(address->sun_path, path);
+    return 1;
+}
+
+// --- Server ---
+static void render_request(ServerWorker* worker, const ServerRequest* request, const Tileset* tileset,
+                           const TileMap* map) {
+    ServerResponse* response = &worker->response;
+    response->magic = SERVER_MAGIC;
+    response->status = SERVER_OK;
+    response->width = request->width;
+    response->height = request->height;
+    response->format = request->format;
+    response->size = 0;
+    worker->payload = NULL;
+
+    if (request->magic != SERVER_MAGIC || request->width < 1 || request->height < 1 ||
+        request->width > SERVER_MAX_SIDE || request->height > SERVER_MAX_SIDE ||
+        !(request->zoom >= MIN_ZOOM && request->zoom <= MAX_ZOOM) ||
+        request->format > SERVER_FORMAT_RGBA) {
+        response->status = SERVER_BAD_REQUEST;
+        return;
+    }
+
+    size_t pixels = (size_t)request->width * request->height;
+    if (pixels > worker->pixel_capacity) {
+        Uint32* grown = realloc(worker->pixels, sizeof(Uint32) * pixels);
+        if (!grown) {
+            response->status = SERVER_FAILED;
+            return;
+        }
+        worker->pixels = grown;
+        worker->pixel_capacity = pixels;
+    }
+
+    int width = (int)request->width, height = (int)request->height;
+    Camera camera = { request->offset_x, request->offset_y, request->zoom, width, height };
+    View view;
+    view_compute(&view, &camera, map, tileset, -1, -1);
+    FrameStats stats = {0};
+    SoftTarget target = { worker->pixels, width, height, width, 0, 0 };
+    soft_draw(&worker->raster, &target, &view, map, NULL, &stats);
+    blend_unpremultiply_rgba32(worker->pixels, (int)pixels);
+
+    if (request->format == SERVER_FORMAT_RGBA) {
+        worker->payload = worker->pixels;
+        response->size = (Uint32)(pixels * 4);
+    } else if (png_encode_rgba(&worker->png, worker->pixels, width, height, width)) {
+        worker->payload = worker->png.data;
+        response->size = (Uint32)worker->png.size;
+    } else {
+        response->status = SERVER_FAILED;
+    }
+}
+
+// --- Bounds every blocking transfer on a client, so one that sends half a request or stops
+// reading its image is dropped instead of stalling the poll loop for everyone else ---
+static int set_client_timeouts(int fd) {
+    struct timeval timeout;
+    timeout.tv_sec = SERVER_CLIENT_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (SERVER_CLIENT_TIMEOUT_MS % 1000) * 1000;
+    return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 &&
+           setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+static int open_listener(const char* path) {
+    struct sockaddr_un address;
+    if (!socket_address(&address, path)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SERVER_MAX_CLIENTS) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_server(const char* socket_path, const Tileset* tileset, const TileMap* map) {
+    int listener = open_listener(socket_path);
+    if (listener < 0) return 0;
+
+    int worker_count = SDL_GetCPUCount();
+    if (worker_count < 1) worker_count = 1;
+    ServerWorker* workers = calloc(worker_count, sizeof(ServerWorker));
+    int ok = workers != NULL;
+    for (int w = 0; w < worker_count && ok; w++) ok = soft_init(&workers[w].raster, tileset, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!ok) {
+        printf("Could not set up %d render workers\n", worker_count);
+        worker_count = workers ? worker_count : 0;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // Slot 0 is the listener, the rest are clients
+    struct pollfd fds[1 + SERVER_MAX_CLIENTS];
+    int clients = 0;
+    fds[0].fd = listener;
+    fds[0].events = POLLIN;
+    PendingRequest batch[SERVER_MAX_CLIENTS];
+    Uint64 served = 0, rejected = 0, batches = 0, render_ticks = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (ok) {
+        printf("Serving %dx%d map on %s with %d render workers (Ctrl+C stops)\n", map->width, map->height,
+               socket_path, worker_count);
+        fflush(stdout);
+    }
+
+    while (ok && !server_stop) {
+        if (poll(fds, 1 + clients, 500) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+
+        // Every client waits for its answer before asking again, so one request each per round
+        int count = 0;
+        for (int c = 1; c <= clients; c++) {
+            if (!(fds[c].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            PendingRequest* pending = &batch[count];
+            if (read_full(fds[c].fd, &pending->request, sizeof(pending->request))) {
+                pending->client = c;
+                count++;
+            } else {
+                close(fds[c].fd);
+                fds[c].fd = -1;
+            }
+        }
+
+        // Render the batch a worker-sized group at a time, then answer in arrival order
+        for (int first = 0; first < count; first += worker_count) {
+            int group = count - first < worker_count ? count - first : worker_count;
+            Uint64 render_start = SDL_GetPerformanceCounter();
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int k = 0; k < group; k++) render_request(&workers[k], &batch[first + k].request, tileset, map);
+            render_ticks += SDL_GetPerformanceCounter() - render_start;
+
+            for (int k = 0; k < group; k++) {
+                const ServerWorker* worker = &workers[k];
+                int fd = fds[batch[first + k].client].fd;
+                if (worker->response.status == SERVER_OK) served++;
+                else rejected++;
+                if (!write_full(fd, &worker->response, sizeof(worker->response)) ||
+                    (worker->response.size && !write_full(fd, worker->payload, worker->response.size))) {
+                    close(fd);
+                    fds[batch[first + k].client].fd = -1;
+                }
+            }
+        }
+        if (count) batches++;
+
+        int kept = 0;
+        for (int c = 1; c <= clients; c++) {
+            if (fds[c].fd >= 0) fds[++kept] = fds[c];
+        }
+        clients = kept;
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0 && clients < SERVER_MAX_CLIENTS && set_client_timeouts(fd)) {
+                clients++;
+                fds[clients].fd = fd;
+                fds[clients].events = POLLIN;
+                fds[clients].revents = 0;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    double seconds = ticks_ms(SDL_GetPerformanceCounter() - start) / 1000.0;
+    if (ok) {
+        printf("Served %llu requests (%llu rejected) in %llu batches, %.1f per batch; %.1f req/s over %.1f s, "
+               "%.2f ms rendering per batch\n",
+               (unsigned long long)served, (unsigned long long)rejected, (unsigned long long)batches,
+               batches ? (double)(served + rejected) / batches : 0.0, served / seconds, seconds,
+               batches ? ticks_ms(render_ticks) / batches : 0.0);
+    }
+    for (int c = 1; c <= clients; c++) close(fds[c].fd);
+    close(listener);
+    unlink(socket_path);
+    for (int w = 0; w < worker_count; w++) {
+        soft_free(&workers[w].raster);
+        free(workers[w].pixels);
+        png_buffer_free(&workers[w].png);
+    }
+    free(workers);
+    return ok;
+}
+
+// --- Load generator ---
+typedef struct {
+    const LoadOptions* options;
+    int world_width, world_height;
+    unsigned int seed;
+    double* latencies;           // Milliseconds, one per completed request
+    int completed;
+    int failed;
+    Uint64 bytes;
+} LoadClient;
+
+// --- Uniform in [0, 1) ---
+static double random_unit(unsigned int* seed) {
+    return ((next_random(seed) >> 16) & 0x7FFF) / 32768.0;
+}
+
+static int load_thread(void* data) {
+    LoadClient* client = data;
+    const LoadOptions* options = client->options;
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || !socket_address(&address, options->socket_path) ||
+        connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        if (fd >= 0) close(fd);
+        client->failed = options->requests;
+        return 0;
+    }
+
+    static const float zooms[] = { 0.25f, 0.5f, 1.0f, 2.0f };
+    unsigned char* image = NULL;
+    size_t capacity = 0;
+    for (int i = 0; i < options->requests; i++) {
+        // A random viewport that starts inside the map
+        ServerRequest request;
+        request.magic = SERVER_MAGIC;
+        request.zoom = zooms[(int)(random_unit(&client->seed) * 4)];
+        request.offset_x = -(float)(random_unit(&client->seed) * client->world_width);
+        request.offset_y = -(float)(random_unit(&client->seed) * client->world_height);
+        request.width = (Uint32)options->width;
+        request.height = (Uint32)options->height;
+        request.format = (Uint32)options->format;
+
+        Uint64 sent = SDL_GetPerformanceCounter();
+        ServerResponse response;
+        if (!write_full(fd, &request, sizeof(request)) || !read_full(fd, &response, sizeof(response)) ||
+            response.magic != SERVER_MAGIC) {
+            client->failed += options->requests - i;
+            break;
+        }
+        if (response.size > capacity) {
+            unsigned char* grown = realloc(image, response.size);
+            if (!grown) {
+                client->failed += options->requests - i;
+                break;
+            }
+            image = grown;
+            capacity = response.size;
+        }
+        if (response.size && !read_full(fd, image, response.size)) {
+            client->failed += options->requests - i;
+            break;
+        }
+        if (response.status != SERVER_OK) {
+            client->failed++;
+            continue;
+        }
+        client->latencies[client->completed++] = ticks_ms(SDL_GetPerformanceCounter() - sent);
+        client->bytes += response.size;
+    }
+    free(image);
+    close(fd);
+    return 0;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int count, double fraction) {
+    int index = (int)(fraction * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+int run_load(const LoadOptions* options, int world_width, int world_height) {
+    int count = options->clients;
+    LoadClient* clients = calloc(count, sizeof(LoadClient));
+    SDL_Thread** threads = calloc(count, sizeof(SDL_Thread*));
+    double* latencies = malloc(sizeof(double) * (size_t)count * options->requests);
+    if (!clients || !threads || !latencies) {
+        free(clients);
+        free(threads);
+        free(latencies);
+        return 0;
+    }
+
+    printf("Load: %d clients x %d requests of %dx%d %s to %s\n", count, options->requests, options->width,
+           options->height, options->format == SERVER_FORMAT_PNG ? "PNG" : "RGBA", options->socket_path);
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int c = 0; c < count; c++) {
+        clients[c].options = options;
+        clients[c].world_width = world_width;
+        clients[c].world_height = world_height;
+        clients[c].seed = 7919u * (unsigned int)c + 1u;
+        clients[c].latencies = latencies + (size_t)c * options->requests;
+        threads[c] = SDL_CreateThread(load_thread, "load", &clients[c]);
+        if (!threads[c]) clients[c].failed = options->requests;
+    }
+    for (int c = 0; c < count; c++) {
+        if (threads[c]) SDL_WaitThread(threads[c], NULL);
+    }
+    double seconds = ticks_ms(SDL_GetPerformanceCounter() - start) / 1000.0;
+
+    // Gather every client's latencies in front of the array and sort them together
+    int completed = 0, failed = 0;
+    Uint64 bytes = 0;
+    for (int c = 0; c < count; c++) {
+        memmove(latencies + completed, clients[c].latencies, sizeof(double) * clients[c].completed);
+        completed += clients[c].completed;
+        failed += clients[c].failed;
+        bytes += clients[c].bytes;
+    }
+    if (completed) {
+        qsort(latencies, completed, sizeof(double), compare_doubles);
+        printf("%d requests in %.2f s: %.1f req/s, %.1f MB/s received\n", completed, seconds, completed / seconds,
+               bytes / 1048576.0 / seconds);
+        printf("Latency ms: p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n", percentile(latencies, completed, 0.5),
+               percentile(latencies, completed, 0.9), percentile(latencies, completed, 0.99),
+               latencies[completed - 1]);
+    }
+    if (failed) printf("%d requests failed\n", failed);
+
+    free(clients);
+    free(threads);
+    free(latencies);
+    return completed > 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+// Headless render server: keeps the map and tileset resident and answers
+// viewport requests over a Unix domain socket with PNG or raw RGBA images,
+// drawn by soft_raster after the same view_compute culling the viewer uses.
+// Requests that arrive together are rendered as one batch across the cores,
+// each into a worker whose pixel and PNG buffers persist between batches.
+// The load generator drives it from several connections at once and prints
+// requests/second and latency percentiles.
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "tilemap.h"
+
+#define SERVER_MAGIC 0x454C4954u          // "TILE" in the first four bytes of every message
+#define SERVER_MAX_CLIENTS 64             // Connections served at once
+#define SERVER_MAX_SIDE 4096              // Largest image side a request may ask for
+#define SERVER_CLIENT_TIMEOUT_MS 2000     // A client stalling one read or write this long is dropped
+
+typedef enum {
+    SERVER_FORMAT_PNG,
+    SERVER_FORMAT_RGBA           // Straight-alpha RGBA32, top-down rows
+} ServerFormat;
+
+typedef enum {
+    SERVER_OK,
+    SERVER_BAD_REQUEST,          // Size, zoom or format out of range
+    SERVER_FAILED                // Out of memory or encoding failed
+} ServerStatus;
+
+// --- Wire format, native byte order: both ends run on the same host ---
+typedef struct {
+    Uint32 magic;
+    float offset_x, offset_y;    // As in Camera: screen = (world + offset) * zoom
+    float zoom;
+    Uint32 width, height;
+    Uint32 format;               // ServerFormat
+} ServerRequest;
+
+typedef struct {
+    Uint32 magic;
+    Uint32 status;               // ServerStatus
+    Uint32 width, height;
+    Uint32 format;
+    Uint32 size;                 // Image bytes following the header
+} ServerResponse;
+
+typedef struct {
+    const char* socket_path;
+    int clients;                 // Concurrent connections
+    int requests;                // Requests per connection
+    int width, height;           // Requested image size
+    ServerFormat format;
+} LoadOptions;
+
+// Serves until SIGINT/SIGTERM; returns 0 if the socket couldn't be set up
+int run_server(const char* socket_path, const Tileset* tileset, const TileMap* map);
+
+// Sends random viewports of a world_width x world_height pixel map; returns 0 on failure
+int run_load(const LoadOptions* options, int world_width, int world_height);
+
+#endif
@@ -0,0 +1,327 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "soft_raster.h"
+#include "blend.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// --- The same layout as `format` with the spare byte used for alpha, so translucent texels survive ---
+static Uint32 alpha_format(Uint32 format) {
+    int bpp;
+    Uint32 r, g, b, a;
+    if (!SDL_PixelFormatEnumToMasks(format, &bpp, &r, &g, &b, &a) || a) return format;
+    Uint32 with_alpha = SDL_MasksToPixelFormatEnum(32, r, g, b, ~(r | g | b));
+    return with_alpha != SDL_PIXELFORMAT_UNKNOWN ? with_alpha : format;
+}
+
+// --- The atlas once per tile transform, stacked top to bottom, so transformed tiles are still copied
+// row by row. Tiles that aren't square stretch when transposed, as quads do in the GL backend ---
+static SDL_Surface* stack_transforms(SDL_Surface* atlas, const Tileset* tileset) {
+    int tw = tileset->tile_width, th = tileset->tile_height;
+    SDL_Surface* stacked = SDL_CreateRGBSurfaceWithFormat(0, atlas->w, atlas->h * TILE_TRANSFORMS, 32,
+                                                          atlas->format->format);
+    if (!stacked) return NULL;
+    int src_pitch = atlas->pitch / 4, dst_pitch = stacked->pitch / 4;
+    const Uint32* src = atlas->pixels;
+
+    for (int t = 0; t < TILE_TRANSFORMS; t++) {
+        int flip_x = t & TILE_FLIP_X, flip_y = t & TILE_FLIP_Y, diagonal = t & TILE_FLIP_DIAGONAL;
+        for (int y = 0; y < tileset->rows * th; y++) {
+            Uint32* dst = (Uint32*)stacked->pixels + (size_t)(t * atlas->h + y) * dst_pitch;
+            int cell_y = y - y % th, py = flip_y ? th - 1 - y % th : y % th;
+            for (int x = 0; x < tileset->cols * tw; x++) {
+                int cell_x = x - x % tw, px = flip_x ? tw - 1 - x % tw : x % tw;
+                int sx = diagonal ? py * tw / th : px;
+                int sy = diagonal ? px * th / tw : py;
+                dst[x] = src[(size_t)(cell_y + sy) * src_pitch + cell_x + sx];
+            }
+        }
+    }
+    return stacked;
+}
+
+int soft_init(SoftRaster* raster, const Tileset* tileset, Uint32 pixel_format, int parallel) {
+    memset(raster, 0, sizeof(*raster));
+    if (SDL_BYTESPERPIXEL(pixel_format) != 4) {
+        printf("Software rasteriser needs a 32-bit format, got %s\n", SDL_GetPixelFormatName(pixel_format));
+        return 0;
+    }
+
+    // Premultiply once in RGBA32, then convert; the conversion is a plain copy and keeps alpha as is
+    SDL_Surface* premultiplied = SDL_ConvertSurfaceFormat(tileset->surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (premultiplied) {
+        for (int y = 0; y < premultiplied->h; y++) {
+            blend_premultiply_rgba32((Uint32*)((Uint8*)premultiplied->pixels + (size_t)y * premultiplied->pitch),
+                                     premultiplied->w);
+        }
+        SDL_Surface* atlas = SDL_ConvertSurfaceFormat(premultiplied, alpha_format(pixel_format), 0);
+        SDL_FreeSurface(premultiplied);
+        if (atlas) {
+            raster->atlas = stack_transforms(atlas, tileset);
+            raster->transform_stride = (size_t)atlas->h * (raster->atlas ? raster->atlas->pitch / 4 : 0);
+            SDL_FreeSurface(atlas);
+        }
+    }
+    int tile_count = tileset->cols * tileset->rows;
+    raster->coverage = malloc(tile_count);
+    if (!raster->atlas || !raster->coverage) {
+        printf("SDL_ConvertSurfaceFormat failed: %s\n", SDL_GetError());
+        soft_free(raster);
+        return 0;
+    }
+    memcpy(raster->coverage, tileset->coverage, tile_count);
+    raster->tileset_cols = tileset->cols;
+    raster->tile_width = tileset->tile_width;
+    raster->tile_height = tileset->tile_height;
+    raster->outline = SDL_MapRGBA(raster->atlas->format, 255, 0, 0, 255);
+    raster->parallel = parallel;
+
+    const BlendKernel* kernel = blend_select();
+    raster->blend_name = kernel->name;
+    raster->blend_over = kernel->over;
+    raster->alpha_shift = raster->atlas->format->Ashift;
+    return 1;
+}
+
+void soft_free(SoftRaster* raster) {
+    if (raster->atlas) SDL_FreeSurface(raster->atlas);
+    free(raster->coverage);
+    free(raster->col_tile);
+    free(raster->col_texel);
+    free(raster->row_tile);
+    free(raster->row_texel);
+    free(raster->spans);
+    memset(raster, 0, sizeof(*raster));
+}
+
+static int ensure_tables(SoftRaster* raster, int width, int height) {
+    if (width > raster->columns) {
+        int* col_tile = realloc(raster->col_tile, sizeof(int) * width);
+        int* col_texel = realloc(raster->col_texel, sizeof(int) * width);
+        SoftSpan* spans = realloc(raster->spans, sizeof(SoftSpan) * width);
+        if (col_tile) raster->col_tile = col_tile;
+        if (col_texel) raster->col_texel = col_texel;
+        if (spans) raster->spans = spans;
+        if (!col_tile || !col_texel || !spans) return 0;
+        raster->columns = width;
+    }
+    if (height > raster->rows) {
+        int* row_tile = realloc(raster->row_tile, sizeof(int) * height);
+        int* row_texel = realloc(raster->row_texel, sizeof(int) * height);
+        if (row_tile) raster->row_tile = row_tile;
+        if (row_texel) raster->row_texel = row_texel;
+        if (!row_tile || !row_texel) return 0;
+        raster->rows = height;
+    }
+    return 1;
+}
+
+// --- Map screen pixel centres along one axis to (tile, texel); tiles are LOD-cell aligned ---
+static void axis_lookup(int first, int count, float zoom, float offset, int tile_size, int lod, int map_size,
+                        int* tile_out, int* texel_out) {
+    double cell_size = (double)tile_size * lod;
+    for (int i = 0; i < count; i++) {
+        double world = (first + i + 0.5) / zoom - offset;
+        double cell = floor(world / cell_size);
+        int tile = (int)cell * lod;
+        int texel = (int)((world - cell * cell_size) / lod);
+        if (texel >= tile_size) texel = tile_size - 1;
+        if (texel < 0) texel = 0;
+        tile_out[i] = (world < 0.0 || tile >= map_size) ? -1 : tile;
+        texel_out[i] = texel;
+    }
+}
+
+// --- Group the columns into runs of the same map column ---
+static void build_spans(SoftRaster* raster, int width) {
+    int count = 0;
+    for (int x = 0; x < width;) {
+        int x1 = x + 1;
+        while (x1 < width && raster->col_tile[x1] == raster->col_tile[x]) x1++;
+        raster->spans[count++] = (SoftSpan){ x, x1, raster->col_tile[x] };
+        x = x1;
+    }
+    raster->span_count = count;
+}
+
+// --- Repeat each texel `scale` times; the first texel covers `first` pixels ---
+static void replicate_texels(Uint32* dst, const Uint32* src, int n, int scale, int first) {
+    if (first > n) first = n;
+    for (int i = 0; i < first; i++) dst[i] = src[0];
+    dst += first;
+    n -= first;
+    src++;
+
+#ifdef __SSE2__
+    if (scale == 2) {
+        for (; n >= 8; n -= 8, dst += 8, src += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i*)src);
+            _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(v, v));
+        }
+    } else if (scale >= 4) {
+        for (; n >= scale; n -= scale, dst += scale, src++) {
+            __m128i v = _mm_set1_epi32((int)*src);
+            int j = 0;
+            for (; j + 4 <= scale; j += 4) _mm_storeu_si128((__m128i*)(dst + j), v);
+            for (; j < scale; j++) dst[j] = *src;
+        }
+    }
+#endif
+
+    while (n > 0) {
+        int m = n < scale ? n : scale;
+        for (int i = 0; i < m; i++) dst[i] = *src;
+        dst += m;
+        n -= m;
+        src++;
+    }
+}
+
+static void fill_row(Uint32* dst, int n, Uint32 colour) {
+    if (colour == 0) {
+        memset(dst, 0, sizeof(Uint32) * (size_t)n);
+    } else {
+        for (int i = 0; i < n; i++) dst[i] = colour;
+    }
+}
+
+// --- Copy screen columns [a, b) of one tile row starting at `src` into dst[a..b) ---
+static void copy_span(Uint32* dst, const Uint32* src, const int* col_texel, int a, int b, int scale) {
+    if (scale == 1) {
+        memcpy(dst + a, src + col_texel[a], sizeof(Uint32) * (size_t)(b - a));
+    } else if (scale > 1) {
+        int first = 1;
+        while (a + first < b && col_texel[a + first] == col_texel[a]) first++;
+        replicate_texels(dst + a, src + col_texel[a], b - a, scale, first);
+    } else {
+        for (int x = a; x < b; x++) dst[x] = src[col_texel[x]];
+    }
+}
+
+// --- Draw one screen row: the base layer is copied, the layers above are composited over it.
+// `scratch` holds a row of scaled texels for blending and is only used when the map has layers ---
+static void draw_row(const SoftRaster* raster, const SoftTarget* target, const TileMap* map,
+                     int y, int x0, int x1, int scale, Uint32* scratch) {
+    Uint32* dst = target->pixels + (size_t)y * target->pitch;
+    int ty = raster->row_tile[y];
+    if (ty < 0) {
+        fill_row(dst + x0, x1 - x0, 0);
+        return;
+    }
+
+    const SDL_Surface* atlas = raster->atlas;
+    int atlas_pitch = atlas->pitch / 4;
+    int tw = raster->tile_width, th = raster->tile_height;
+    const Uint32* texel_row = (const Uint32*)atlas->pixels + (size_t)raster->row_texel[y] * atlas_pitch;
+    const int* col_texel = raster->col_texel;
+
+    for (int layer = 0; layer < map->layers; layer++) {
+        const TileEntry* tiles = tilemap_layer(map, layer) + (size_t)ty * map->width;
+        for (int s = 0; s < raster->span_count; s++) {
+            const SoftSpan* span = &raster->spans[s];
+            int a = span->x0 > x0 ? span->x0 : x0;
+            int b = span->x1 < x1 ? span->x1 : x1;
+            if (a >= b) continue;
+
+            TileEntry tile = span->tile_x < 0 ? (TileEntry){ TILE_EMPTY_CELL, TILE_EMPTY_CELL } : tiles[span->tile_x];
+            if (tile_is_empty(tile)) {
+                if (layer == 0) fill_row(dst + a, b - a, 0);
+                continue;
+            }
+
+            const Uint32* src = texel_row + tile_transform(tile) * raster->transform_stride +
+                                (size_t)tile_row(tile) * th * atlas_pitch + tile.sx * tw;
+            int coverage = layer == 0 ? TILE_OPAQUE : raster->coverage[tile_row(tile) * raster->tileset_cols + tile.sx];
+            if (coverage == TILE_OPAQUE) {
+                copy_span(dst, src, col_texel, a, b, scale);
+            } else if (coverage == TILE_TRANSLUCENT) {
+                // At 1:1 the atlas row is already laid out like the screen row
+                const Uint32* over = src + col_texel[a];
+                if (scale != 1) {
+                    copy_span(scratch, src, col_texel, a, b, scale);
+                    over = scratch + a;
+                }
+                raster->blend_over(dst + a, over, b - a, raster->alpha_shift);
+            }
+        }
+    }
+}
+
+static void fill_rect(const SoftTarget* target, const SDL_Rect* clip, int x, int y, int w, int h, Uint32 colour) {
+    SDL_Rect rect = { x, y, w, h }, visible;
+    if (!SDL_IntersectRect(&rect, clip, &visible)) return;
+    for (int row = visible.y; row < visible.y + visible.h; row++) {
+        fill_row(target->pixels + (size_t)row * target->pitch + visible.x, visible.w, colour);
+    }
+}
+
+static void draw_outline(const SoftRaster* raster, const SoftTarget* target, const View* view, const SDL_Rect* clip) {
+    SDL_Rect tile;
+    view_tile_rect(view, view->hover_x, view->hover_y, &tile);
+    tile.x -= target->origin_x;
+    tile.y -= target->origin_y;
+    int px = SOFT_OUTLINE_WIDTH;
+    fill_rect(target, clip, tile.x, tile.y, tile.w, px, raster->outline);
+    fill_rect(target, clip, tile.x, tile.y + tile.h - px, tile.w, px, raster->outline);
+    fill_rect(target, clip, tile.x, tile.y, px, tile.h, raster->outline);
+    fill_rect(target, clip, tile.x + tile.w - px, tile.y, px, tile.h, raster->outline);
+}
+
+void soft_draw(SoftRaster* raster, const SoftTarget* target, const View* view, const TileMap* map,
+               const SDL_Rect* clip, FrameStats* stats) {
+    const Camera* cam = &view->camera;
+    SDL_Rect full = { 0, 0, target->width, target->height }, area;
+    if (!SDL_IntersectRect(&full, clip ? clip : &full, &area)) return;
+    if (!ensure_tables(raster, target->width, target->height)) return;
+
+    axis_lookup(target->origin_x, target->width, cam->zoom, cam->offset_x, view->tile_width, view->lod, map->width,
+                raster->col_tile, raster->col_texel);
+    axis_lookup(target->origin_y, target->height, cam->zoom, cam->offset_y, view->tile_height, view->lod, map->height,
+                raster->row_tile, raster->row_texel);
+    build_spans(raster, target->width);
+
+    // Screen pixels per texel; replication needs it to be a whole number
+    float texel_px = cam->zoom * view->lod;
+    int scale = fabsf(texel_px - roundf(texel_px)) < 1e-4f ? (int)roundf(texel_px) : 0;
+
+    int y_end = area.y + area.h;
+    int strips = (area.h + SOFT_STRIP_ROWS - 1) / SOFT_STRIP_ROWS;
+    #pragma omp parallel for schedule(dynamic, 1) if(raster->parallel)
+    for (int strip = 0; strip < strips; strip++) {
+        int y0 = area.y + strip * SOFT_STRIP_ROWS;
+        int y1 = y0 + SOFT_STRIP_ROWS < y_end ? y0 + SOFT_STRIP_ROWS : y_end;
+        Uint32* scratch = map->layers > 1 ? malloc(sizeof(Uint32) * target->width) : NULL;
+        if (map->layers > 1 && !scratch) continue;
+        for (int y = y0; y < y1; y++) draw_row(raster, target, map, y, area.x, area.x + area.w, scale, scratch);
+        free(scratch);
+    }
+
+    if (view->hover_x >= 0) draw_outline(raster, target, view, &area);
+
+    stats->draw_calls += strips;
+    stats->tiles_drawn += (view->max_x - view->start_x + view->lod - 1) / view->lod *
+                          ((view->max_y - view->start_y + view->lod - 1) / view->lod) * map->layers;
+}
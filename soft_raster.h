@@ -0,0 +1,88 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// CPU tile rasteriser shared by the software backend and offline renderers.
+// Tiles are copied straight from the tileset, pre-converted to the target's
+// 32-bit pixel format and pre-transformed into one copy per flip/rotation,
+// into a plain pixel buffer. Each frame builds lookup
+// tables mapping every screen column and row to a map tile and a texel, so
+// the inner loops never divide: rows are drawn as runs of one tile each,
+// with memcpy at 1:1, SSE2 texel replication at other integer scales and a
+// table-driven nearest-neighbour gather at fractional zoom. Horizontal strips
+// of SOFT_STRIP_ROWS rows are independent and drawn in parallel with OpenMP.
+// Layers above the base are composited with the premultiplied "over" kernel
+// from blend.h; cells whose tile is fully opaque are copied and fully
+// transparent or empty cells are skipped without touching their pixels.
+
+#ifndef SOFT_RASTER_H
+#define SOFT_RASTER_H
+
+#include "tilemap.h"
+#include "blend.h"
+
+#define SOFT_STRIP_ROWS 32                // Rows per parallel work item
+#define SOFT_OUTLINE_WIDTH 8              // Hover outline width in pixels, as in the GL backend
+
+// --- A 32-bit pixel buffer to draw into ---
+typedef struct {
+    Uint32* pixels;
+    int width, height;
+    int pitch;                   // Row stride in pixels
+    int origin_x, origin_y;      // Screen position of pixels[0], to draw one window of a larger view
+} SoftTarget;
+
+// --- One run of screen columns covered by the same map column ---
+typedef struct {
+    int x0, x1;                  // Screen columns, x1 exclusive
+    int tile_x;                  // Map column, or -1 outside the map
+} SoftSpan;
+
+typedef struct {
+    SDL_Surface* atlas;          // Premultiplied tileset pixels in the target format, with alpha, once per transform
+    size_t transform_stride;     // Pixels from one transform's copy of the tileset to the next
+    int tile_width, tile_height;
+    Uint8* coverage;             // Copy of the tileset's TileCoverage per tile index
+    int tileset_cols;
+    const char* blend_name;
+    BlendOverFunc blend_over;    // Best kernel for this CPU
+    int alpha_shift;             // Bit position of alpha in the atlas format
+    Uint32 outline;              // Hover outline colour in the target format
+    int parallel;                // Draw strips on all cores
+
+    // --- Per-frame lookup tables, grown on demand ---
+    int* col_tile;               // Map column for each screen column, or -1
+    int* col_texel;              // Texel column within the tile for each screen column
+    int* row_tile;               // Map row for each screen row, or -1
+    int* row_texel;
+    SoftSpan* spans;
+    int span_count;
+    int columns, rows;           // Table capacities
+} SoftRaster;
+
+// Converts the tileset to `pixel_format` (any 32-bit SDL_PIXELFORMAT_*), premultiplied; formats
+// without alpha get their spare byte used as alpha so the atlas keeps the tileset's coverage
+int soft_init(SoftRaster* raster, const Tileset* tileset, Uint32 pixel_format, int parallel);
+void soft_free(SoftRaster* raster);
+
+// Draws the map and hover outline of `view` into `target`, touching only pixels inside
+// `clip` (the whole target when NULL). Pixels outside the map are cleared to 0.
+void soft_draw(SoftRaster* raster, const SoftTarget* target, const View* view, const TileMap* map,
+               const SDL_Rect* clip, FrameStats* stats);
+
+#endif
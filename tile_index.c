@@ -0,0 +1,297 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tile_index.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_BENCH_TYPES 4
+#define INDEX_BENCH_QUERIES (1 << 20)
+#define INDEX_BENCH_SCANS 64
+#define INDEX_BENCH_UPDATES (1 << 18)
+#define INDEX_BENCH_REBUILDS 4
+
+static Uint32* index_table(const TileIndex* index, int slot) {
+    return index->tables + (size_t)slot * index->table_size;
+}
+
+// --- Summed-area: sat[(y + 1) * (w + 1) + x + 1] counts [0, x] x [0, y]. Row prefix sums are
+// independent, then each row adds the one above it, which vectorises across the row ---
+static void build_summed_area(TileIndex* index) {
+    const TileEntry* cells = tilemap_layer(index->map, index->layer);
+    int w = index->width, h = index->height;
+    size_t pitch = (size_t)w + 1;
+
+    for (int t = 0; t < index->type_count; t++) {
+        Uint32* sat = index_table(index, t);
+        memset(sat, 0, sizeof(Uint32) * pitch);
+
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < h; y++) {
+            const TileEntry* row = cells + (size_t)y * w;
+            Uint32* out = sat + (y + 1) * pitch;
+            Uint32 sum = 0;
+            out[0] = 0;
+            for (int x = 0; x < w; x++) {
+                sum += index->slot_of_cell[tile_cell(row[x])] == t;
+                out[x + 1] = sum;
+            }
+        }
+        for (int y = 1; y < h; y++) {
+            const Uint32* above = sat + y * pitch;
+            Uint32* out = sat + (y + 1) * pitch;
+            for (size_t x = 1; x < pitch; x++) out[x] += above[x];
+        }
+    }
+    index->stale = 0;
+}
+
+// --- Fenwick: built in O(w * h) by pushing every node into its parent, first along rows, then
+// whole rows into their parent row ---
+static void build_fenwick(TileIndex* index) {
+    const TileEntry* cells = tilemap_layer(index->map, index->layer);
+    int w = index->width, h = index->height;
+
+    for (int t = 0; t < index->type_count; t++) {
+        Uint32* tree = index_table(index, t);
+
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < h; y++) {
+            const TileEntry* row = cells + (size_t)y * w;
+            Uint32* out = tree + (size_t)y * w;
+            for (int x = 0; x < w; x++) out[x] = index->slot_of_cell[tile_cell(row[x])] == t;
+            for (int i = 1; i <= w; i++) {
+                int parent = i + (i & -i);
+                if (parent <= w) out[parent - 1] += out[i - 1];
+            }
+        }
+        for (int j = 1; j <= h; j++) {
+            int parent = j + (j & -j);
+            if (parent > h) continue;
+            const Uint32* src = tree + (size_t)(j - 1) * w;
+            Uint32* dst = tree + (size_t)(parent - 1) * w;
+            for (int x = 0; x < w; x++) dst[x] += src[x];
+        }
+    }
+}
+
+// Tiles of the table in [0, x) x [0, y)
+static Uint32 fenwick_prefix(const TileIndex* index, const Uint32* tree, int x, int y) {
+    Uint32 sum = 0;
+    for (int j = y; j > 0; j -= j & -j) {
+        const Uint32* row = tree + (size_t)(j - 1) * index->width;
+        for (int i = x; i > 0; i -= i & -i) sum += row[i - 1];
+    }
+    return sum;
+}
+
+static void fenwick_add(TileIndex* index, Uint32* tree, int x, int y, Uint32 delta) {
+    for (int j = y + 1; j <= index->height; j += j & -j) {
+        Uint32* row = tree + (size_t)(j - 1) * index->width;
+        for (int i = x + 1; i <= index->width; i += i & -i) row[i - 1] += delta;
+    }
+}
+
+int tile_index_create(TileIndex* index, const TileMap* map, const Tileset* tileset, int layer,
+                      TileIndexKind kind, const int* types, int type_count) {
+    memset(index, 0, sizeof(*index));
+    if (layer < 0 || layer >= map->layers || type_count <= 0) {
+        printf("Tile index needs a map layer and at least one tile type\n");
+        return 0;
+    }
+    index->kind = kind;
+    index->map = map;
+    index->layer = layer;
+    index->tileset_cols = tileset->cols;
+    index->width = map->width;
+    index->height = map->height;
+    index->type_count = type_count;
+    index->table_size = kind == TILE_INDEX_SUMMED_AREA ? ((size_t)map->width + 1) * ((size_t)map->height + 1)
+                                                       : (size_t)map->width * map->height;
+    index->types = malloc(sizeof(int) * type_count);
+    index->slot_of_cell = malloc(sizeof(int) * MAX_TILESET_CELLS * MAX_TILESET_CELLS);
+    index->tables = malloc(sizeof(Uint32) * index->table_size * type_count);
+    if (!index->types || !index->slot_of_cell || !index->tables) {
+        printf("Failed to allocate a tile index of %d types over %dx%d tiles\n", type_count, map->width, map->height);
+        tile_index_free(index);
+        return 0;
+    }
+
+    for (int i = 0; i < MAX_TILESET_CELLS * MAX_TILESET_CELLS; i++) index->slot_of_cell[i] = -1;
+    for (int t = 0; t < type_count; t++) {
+        index->types[t] = types[t];
+        TileEntry tile = { (Uint8)(types[t] % tileset->cols), (Uint8)(types[t] / tileset->cols) };
+        index->slot_of_cell[tile_cell(tile)] = t;
+    }
+
+    if (kind == TILE_INDEX_SUMMED_AREA) build_summed_area(index);
+    else build_fenwick(index);
+    return 1;
+}
+
+void tile_index_free(TileIndex* index) {
+    free(index->types);
+    free(index->slot_of_cell);
+    free(index->tables);
+    index->types = NULL;
+    index->slot_of_cell = NULL;
+    index->tables = NULL;
+}
+
+static int type_slot(const TileIndex* index, int type) {
+    for (int t = 0; t < index->type_count; t++) {
+        if (index->types[t] == type) return t;
+    }
+    return -1;
+}
+
+Uint32 tile_count_scan(const TileMap* map, int layer, int tileset_cols, int type, int x0, int y0, int x1, int y1) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > map->width) x1 = map->width;
+    if (y1 > map->height) y1 = map->height;
+    const TileEntry* cells = tilemap_layer(map, layer);
+    Uint32 count = 0;
+    for (int y = y0; y < y1; y++) {
+        const TileEntry* row = cells + (size_t)y * map->width;
+        for (int x = x0; x < x1; x++) count += tile_row(row[x]) * tileset_cols + row[x].sx == type;
+    }
+    return count;
+}
+
+Uint32 tile_index_count(TileIndex* index, int type, int x0, int y0, int x1, int y1) {
+    int slot = type_slot(index, type);
+    if (slot < 0) return tile_count_scan(index->map, index->layer, index->tileset_cols, type, x0, y0, x1, y1);
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > index->width) x1 = index->width;
+    if (y1 > index->height) y1 = index->height;
+    if (x0 >= x1 || y0 >= y1) return 0;
+
+    const Uint32* table = index_table(index, slot);
+    if (index->kind == TILE_INDEX_FENWICK) {
+        return fenwick_prefix(index, table, x1, y1) - fenwick_prefix(index, table, x0, y1)
+             - fenwick_prefix(index, table, x1, y0) + fenwick_prefix(index, table, x0, y0);
+    }
+
+    if (index->stale) {
+        build_summed_area(index);
+        table = index_table(index, slot);
+    }
+    size_t pitch = (size_t)index->width + 1;
+    return table[y1 * pitch + x1] - table[y0 * pitch + x1] - table[y1 * pitch + x0] + table[y0 * pitch + x0];
+}
+
+void tile_index_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile) {
+    TileIndex* index = user;
+    if (layer != index->layer) return;
+    int old_slot = index->slot_of_cell[tile_cell(old_tile)];
+    int new_slot = index->slot_of_cell[tile_cell(new_tile)];
+    if (old_slot == new_slot) return;
+
+    if (index->kind == TILE_INDEX_SUMMED_AREA) {
+        index->stale = 1;
+        return;
+    }
+    if (old_slot >= 0) fenwick_add(index, index_table(index, old_slot), x, y, (Uint32)-1);
+    if (new_slot >= 0) fenwick_add(index, index_table(index, new_slot), x, y, 1);
+}
+
+// --- Benchmark: random rectangles of every size on a private copy of the layer, edited through
+// tilemap_set_tile so both kinds stay current through the listener ---
+static void random_rect(unsigned int* seed, int w, int h, int* r) {
+    for (int i = 0; i < 4; i++) {
+        r[i] = (int)((next_random(seed) >> 8) % (Uint32)((i & 1 ? h : w) + 1));
+    }
+    if (r[0] > r[2]) { int t = r[0]; r[0] = r[2]; r[2] = t; }
+    if (r[1] > r[3]) { int t = r[1]; r[1] = r[3]; r[3] = t; }
+}
+
+void tile_index_benchmark(const Tileset* tileset, const TileMap* map) {
+    int type_limit = tileset->cols * tileset->rows;
+    int types[INDEX_BENCH_TYPES];
+    int type_count = type_limit < INDEX_BENCH_TYPES ? type_limit : INDEX_BENCH_TYPES;
+    for (int t = 0; t < type_count; t++) types[t] = t;
+
+    TileMap copy;
+    if (!tilemap_create(&copy, map->width, map->height, 1)) return;
+    memcpy(copy.tiles, map->tiles, sizeof(TileEntry) * (size_t)map->width * map->height);
+
+    printf("Tile index over %dx%d tiles, %d types, layer 0\n", map->width, map->height, type_count);
+
+    // Baseline
+    unsigned int seed = 1;
+    int r[4];
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint32 checksum = 0;
+    for (int q = 0; q < INDEX_BENCH_SCANS; q++) {
+        random_rect(&seed, copy.width, copy.height, r);
+        checksum += tile_count_scan(&copy, 0, tileset->cols, types[q % type_count], r[0], r[1], r[2], r[3]);
+    }
+    double scan_ns = seconds_since(start) * 1e9 / INDEX_BENCH_SCANS;
+    printf("%-12s %10s %10s %12.0f ns/query %14s\n", "scan", "-", "-", scan_ns, "-");
+
+    static const char* const names[] = { "summed-area", "fenwick" };
+    for (int kind = TILE_INDEX_SUMMED_AREA; kind <= TILE_INDEX_FENWICK; kind++) {
+        TileIndex index;
+        start = SDL_GetPerformanceCounter();
+        if (!tile_index_create(&index, &copy, tileset, 0, (TileIndexKind)kind, types, type_count)) break;
+        double build_ms = seconds_since(start) * 1e3;
+        tilemap_add_listener(&copy, tile_index_on_edit, &index);
+
+        seed = 2;
+        start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < INDEX_BENCH_QUERIES; q++) {
+            random_rect(&seed, copy.width, copy.height, r);
+            checksum += tile_index_count(&index, types[q % type_count], r[0], r[1], r[2], r[3]);
+        }
+        double query_ns = seconds_since(start) * 1e9 / INDEX_BENCH_QUERIES;
+
+        // Summed-area pays a rebuild at the first query after an edit, so time edit + query pairs
+        int updates = kind == TILE_INDEX_FENWICK ? INDEX_BENCH_UPDATES : INDEX_BENCH_REBUILDS;
+        start = SDL_GetPerformanceCounter();
+        for (int u = 0; u < updates; u++) {
+            random_rect(&seed, copy.width - 1, copy.height - 1, r);
+            int type = types[u % type_count] + (u & 1);
+            TileEntry tile = { (Uint8)(type % tileset->cols), (Uint8)(type / tileset->cols) };
+            tilemap_set_tile(&copy, 0, r[0], r[1], tile);
+            if (kind == TILE_INDEX_SUMMED_AREA) checksum += tile_index_count(&index, types[0], 0, 0, 1, 1);
+        }
+        double update_ns = seconds_since(start) * 1e9 / updates;
+
+        int mismatches = 0;
+        for (int q = 0; q < INDEX_BENCH_SCANS; q++) {
+            random_rect(&seed, copy.width, copy.height, r);
+            int type = types[q % type_count];
+            mismatches += tile_index_count(&index, type, r[0], r[1], r[2], r[3])
+                       != tile_count_scan(&copy, 0, tileset->cols, type, r[0], r[1], r[2], r[3]);
+        }
+
+        printf("%-12s %7.1f ms %7.1f MB %12.1f ns/query %12.0f ns/edit%s\n", names[kind], build_ms,
+               (double)sizeof(Uint32) * index.table_size * type_count / (1 << 20), query_ns, update_ns,
+               bench_mismatch(!mismatches));
+        tilemap_remove_listener(&copy, tile_index_on_edit, &index);
+        tile_index_free(&index);
+    }
+    printf("(checksum %u)\n", checksum);
+    tilemap_destroy(&copy);
+}
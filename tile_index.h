@@ -0,0 +1,66 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Rectangle counts of tile types in O(1) or O(log^2) instead of a scan.
+// An index covers one layer and a chosen set of tile types (tileset cell
+// indices), one table of 32-bit counts per type:
+//   - summed-area: (width + 1) * (height + 1) prefix sums, four reads per
+//     query; an edit marks the tables stale and the next query rebuilds them
+//   - Fenwick: a 2D binary indexed tree, O(log w * log h) queries and point
+//     updates, for maps that are edited while being queried
+// Register tile_index_on_edit as a map listener to keep an index current.
+
+#ifndef TILE_INDEX_H
+#define TILE_INDEX_H
+
+#include "tilemap.h"
+
+typedef enum {
+    TILE_INDEX_SUMMED_AREA,
+    TILE_INDEX_FENWICK
+} TileIndexKind;
+
+typedef struct {
+    TileIndexKind kind;
+    const TileMap* map;
+    int layer;
+    int tileset_cols;
+    int width, height;
+    int type_count;
+    int* types;              // Indexed tile types
+    int* slot_of_cell;       // Table of each grid cell (sy * 256 + sx), or -1
+    size_t table_size;       // Counts per type table
+    Uint32* tables;          // type_count tables back to back
+    int stale;               // Summed-area only: edited since the last build
+} TileIndex;
+
+int tile_index_create(TileIndex* index, const TileMap* map, const Tileset* tileset, int layer,
+                      TileIndexKind kind, const int* types, int type_count);
+void tile_index_free(TileIndex* index);
+// Tiles of `type` in [x0, x1) x [y0, y1), clamped to the map; unindexed types are counted by a scan
+Uint32 tile_index_count(TileIndex* index, int type, int x0, int y0, int x1, int y1);
+// Reference scan over the same rectangle
+Uint32 tile_count_scan(const TileMap* map, int layer, int tileset_cols, int type, int x0, int y0, int x1, int y1);
+// TileEditFunc; `user` is the TileIndex
+void tile_index_on_edit(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile);
+
+// Prints build time, memory, query and update cost of both kinds against a scan
+void tile_index_benchmark(const Tileset* tileset, const TileMap* map);
+
+#endif
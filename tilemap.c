@@ -0,0 +1,341 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tilemap.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+int is_power_of_two(int x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+// Each quad corner undoes the x and y flips, then the transpose: identity is 0xB4, FLIP_X toggles
+// every u bit (^0x55), FLIP_Y every v bit (^0xAA), and DIAGONAL then swaps each corner's u and v bits
+const Uint8 tile_corner_bits[TILE_TRANSFORMS] = { 0xB4, 0xE1, 0x1E, 0x4B, 0x78, 0xD2, 0x2D, 0x87 };
+
+// --- Load tileset pixels and calculate tile grid ---
+int load_tileset(Tileset* tileset) {
+    SDL_Surface* loaded = IMG_Load(tileset->filepath);
+    if (!loaded) {
+        printf("IMG_Load failed: %s\n", IMG_GetError());
+        return 0;
+    }
+
+    // Normalise to RGBA byte order so every backend can upload without swizzling
+    tileset->surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (!tileset->surface) {
+        printf("SDL_ConvertSurfaceFormat failed: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    SDL_Surface* surface = tileset->surface;
+    tileset->cols = surface->w / tileset->tile_width;
+    tileset->rows = surface->h / tileset->tile_height;
+    if (tileset->cols < 1 || tileset->rows < 1 ||
+        tileset->cols > MAX_TILESET_CELLS || tileset->rows > TILE_MAX_ROWS ||
+        (tileset->cols == MAX_TILESET_CELLS && tileset->rows == TILE_MAX_ROWS)) {
+        printf("Tileset grid %dx%d is outside 1..%dx1..%d (and can't be exactly %dx%d)\n", tileset->cols, tileset->rows,
+               MAX_TILESET_CELLS, TILE_MAX_ROWS, MAX_TILESET_CELLS, TILE_MAX_ROWS);
+        return 0;
+    }
+
+    // Average colour of every tile, premultiplied so transparent pixels don't tint the result
+    int tile_count = tileset->cols * tileset->rows;
+    tileset->average_colours = malloc(sizeof(Uint32) * tile_count);
+    tileset->coverage = malloc(tile_count);
+    if (!tileset->average_colours || !tileset->coverage) return 0;
+
+    int pixels_per_tile = tileset->tile_width * tileset->tile_height;
+    for (int t = 0; t < tile_count; t++) {
+        int ox = (t % tileset->cols) * tileset->tile_width;
+        int oy = (t / tileset->cols) * tileset->tile_height;
+        Uint64 r = 0, g = 0, b = 0, a = 0;
+        int opaque = 0, transparent = 0;
+        for (int y = 0; y < tileset->tile_height; y++) {
+            const Uint8* p = (const Uint8*)surface->pixels + (oy + y) * surface->pitch + ox * 4;
+            for (int x = 0; x < tileset->tile_width; x++, p += 4) {
+                r += p[0] * p[3];
+                g += p[1] * p[3];
+                b += p[2] * p[3];
+                a += p[3];
+                opaque += p[3] == 255;
+                transparent += p[3] == 0;
+            }
+        }
+        tileset->coverage[t] = opaque == pixels_per_tile ? TILE_OPAQUE :
+                               transparent == pixels_per_tile ? TILE_TRANSPARENT : TILE_TRANSLUCENT;
+        Uint8* out = (Uint8*)&tileset->average_colours[t];
+        out[0] = a ? (Uint8)(r / a) : 0;
+        out[1] = a ? (Uint8)(g / a) : 0;
+        out[2] = a ? (Uint8)(b / a) : 0;
+        out[3] = (Uint8)(a / pixels_per_tile);
+    }
+
+    return 1;
+}
+
+void free_tileset(Tileset* tileset) {
+    if (tileset->surface) SDL_FreeSurface(tileset->surface);
+    free(tileset->average_colours);
+    free(tileset->coverage);
+    tileset->surface = NULL;
+    tileset->average_colours = NULL;
+    tileset->coverage = NULL;
+}
+
+int tilemap_create(TileMap* map, int width, int height, int layers) {
+    map->width = width;
+    map->height = height;
+    map->layers = layers;
+    map->revision = 0;
+    map->listener_count = 0;
+    map->chunks_x = (width + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    map->chunks_y = (height + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    map->tiles = malloc(sizeof(TileEntry) * (size_t)width * height * layers);
+    map->chunk_versions = calloc((size_t)map->chunks_x * map->chunks_y, sizeof(Uint32));
+    if (!map->tiles || !map->chunk_versions) {
+        fprintf(stderr, "Failed to allocate memory for %dx%dx%d tilemap\n", width, height, layers);
+        tilemap_destroy(map);
+        return 0;
+    }
+    return 1;
+}
+
+void tilemap_destroy(TileMap* map) {
+    free(map->tiles);
+    free(map->chunk_versions);
+    map->tiles = NULL;
+    map->chunk_versions = NULL;
+}
+
+void tilemap_set_tile(TileMap* map, int layer, int x, int y, TileEntry tile) {
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height || layer < 0 || layer >= map->layers) return;
+    TileEntry* cell = &tilemap_layer(map, layer)[(size_t)y * map->width + x];
+    TileEntry old_tile = *cell;
+    if (old_tile.sx == tile.sx && old_tile.sy == tile.sy) return;
+    *cell = tile;
+
+    // Tile first, then its chunk version, then the revision: whoever sees the new revision
+    // (possibly another process, see map_store.h) also sees the version and the tile
+    Uint32 revision = map->revision + 1;
+    SDL_MemoryBarrierRelease();
+    map->chunk_versions[(y / MAP_CHUNK_TILES) * map->chunks_x + x / MAP_CHUNK_TILES] = revision;
+    SDL_MemoryBarrierRelease();
+    map->revision = revision;
+
+    for (int i = 0; i < map->listener_count; i++) {
+        map->listeners[i].func(map->listeners[i].user, layer, x, y, old_tile, tile);
+    }
+}
+
+int tilemap_add_listener(TileMap* map, TileEditFunc func, void* user) {
+    if (map->listener_count >= MAP_MAX_LISTENERS) {
+        printf("Tile map already has %d edit listeners\n", MAP_MAX_LISTENERS);
+        return 0;
+    }
+    map->listeners[map->listener_count].func = func;
+    map->listeners[map->listener_count].user = user;
+    map->listener_count++;
+    return 1;
+}
+
+void tilemap_remove_listener(TileMap* map, TileEditFunc func, void* user) {
+    for (int i = 0; i < map->listener_count; i++) {
+        if (map->listeners[i].func == func && map->listeners[i].user == user) {
+            map->listeners[i] = map->listeners[--map->listener_count];
+            return;
+        }
+    }
+}
+
+int tilemap_region_changed(const TileMap* map, int x0, int y0, int x1, int y1, Uint32 since) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > map->width) x1 = map->width;
+    if (y1 > map->height) y1 = map->height;
+    if (x0 >= x1 || y0 >= y1) return 0;
+
+    // Revisions wrap, so compare by signed distance
+    for (int cy = y0 / MAP_CHUNK_TILES; cy <= (y1 - 1) / MAP_CHUNK_TILES; cy++) {
+        const Uint32* row = map->chunk_versions + (size_t)cy * map->chunks_x;
+        for (int cx = x0 / MAP_CHUNK_TILES; cx <= (x1 - 1) / MAP_CHUNK_TILES; cx++) {
+            if ((Sint32)(row[cx] - since) > 0) return 1;
+        }
+    }
+    return 0;
+}
+
+// --- Fill tilemap with random tile indices; upper layers cover one cell in four ---
+void fill_random_tilemap(TileMap* map, int max_tile_index, const Tileset* tileset) {
+    for (int layer = 0; layer < map->layers; layer++) {
+        TileEntry* tiles = tilemap_layer(map, layer);
+        for (int y = 0; y < map->height; y++) {
+            for (int x = 0; x < map->width; x++) {
+                TileEntry* tile = &tiles[(size_t)y * map->width + x];
+                if (layer > 0 && rand() % 4 != 0) {
+                    tile->sx = tile->sy = TILE_EMPTY_CELL;
+                    continue;
+                }
+
+                int tile_index = rand() % max_tile_index;
+                tile->sx = (Uint8)(tile_index % tileset->cols);
+                tile->sy = (Uint8)(tile_index / tileset->cols);
+            }
+        }
+    }
+}
+
+void fill_random_transforms(TileMap* map) {
+    size_t count = (size_t)map->width * map->height * map->layers;
+    for (size_t i = 0; i < count; i++) {
+        TileEntry* tile = &map->tiles[i];
+        if (!tile_is_empty(*tile)) *tile = tile_make(tile->sx, tile_row(*tile), rand() % TILE_TRANSFORMS);
+    }
+}
+
+// --- Camera ---
+void camera_center(Camera* camera, const TileMap* map, const Tileset* tileset) {
+    camera->offset_x = (map->width * tileset->tile_width - camera->screen_w / camera->zoom) / -2.0f;
+    camera->offset_y = (map->height * tileset->tile_height - camera->screen_h / camera->zoom) / -2.0f;
+}
+
+void camera_pan(Camera* camera, int dx, int dy) {
+    camera->offset_x += dx / camera->zoom;
+    camera->offset_y += dy / camera->zoom;
+}
+
+// --- Zoom keeping the world point under (mx, my) fixed ---
+void camera_zoom_at(Camera* camera, int mx, int my, float factor) {
+    float world_x = mx / camera->zoom - camera->offset_x;
+    float world_y = my / camera->zoom - camera->offset_y;
+    camera->zoom *= factor;
+    if (camera->zoom < MIN_ZOOM) camera->zoom = MIN_ZOOM;
+    if (camera->zoom > MAX_ZOOM) camera->zoom = MAX_ZOOM;
+    camera->offset_x = mx / camera->zoom - world_x;
+    camera->offset_y = my / camera->zoom - world_y;
+}
+
+// --- Tile under a screen position; floorf so tiles left of the origin don't pick tile 0 ---
+int pick_tile(const Camera* camera, const TileMap* map, const Tileset* tileset,
+              int mx, int my, int* tile_x, int* tile_y) {
+    *tile_x = (int)floorf((mx / camera->zoom - camera->offset_x) / tileset->tile_width);
+    *tile_y = (int)floorf((my / camera->zoom - camera->offset_y) / tileset->tile_height);
+    return *tile_x >= 0 && *tile_x < map->width && *tile_y >= 0 && *tile_y < map->height;
+}
+
+// --- Tile bounds covering the screen rectangle [x0, x1) x [y0, y1) ---
+static void compute_range(View* view, const TileMap* map, float x0, float y0, float x1, float y1) {
+    const Camera* camera = &view->camera;
+    int tw = view->tile_width;
+    int th = view->tile_height;
+    float zoom = camera->zoom;
+
+    view->min_x = (int)floorf((x0 / zoom - camera->offset_x) / tw);
+    view->min_y = (int)floorf((y0 / zoom - camera->offset_y) / th);
+    view->max_x = (int)ceilf((x1 / zoom - camera->offset_x) / tw);
+    view->max_y = (int)ceilf((y1 / zoom - camera->offset_y) / th);
+
+    // Clamp bounds to valid map size
+    if (view->min_x < 0) view->min_x = 0;
+    if (view->min_y < 0) view->min_y = 0;
+    if (view->max_x > map->width) view->max_x = map->width;
+    if (view->max_y > map->height) view->max_y = map->height;
+
+    // Align LOD grouping so same tiles are chosen as we pan
+    view->start_x = (view->min_x / view->lod) * view->lod;
+    view->start_y = (view->min_y / view->lod) * view->lod;
+}
+
+void view_compute(View* view, const Camera* camera, const TileMap* map, const Tileset* tileset,
+                  int mouse_x, int mouse_y) {
+    int tw = tileset->tile_width;
+    float zoom = camera->zoom;
+
+    view->camera = *camera;
+    view->tile_width = tw;
+    view->tile_height = tileset->tile_height;
+
+    // --- PERFORMANCE OPTIMISATION: Level of Detail (LOD) ---
+    // If the size of a tile on screen is smaller than LOD_PIXEL_THRESHOLD,
+    // we increase LOD (skip tiles) to reduce draw calls and speed up rendering.
+    float tsz = tw * zoom;
+    view->lod = (tsz < LOD_PIXEL_THRESHOLD) ? (int)ceilf(LOD_PIXEL_THRESHOLD / tsz) : 1;
+
+    // --- PERFORMANCE OPTIMISATION: View Clipping ---
+    // Compute only the visible tile bounds to avoid drawing offscreen tiles.
+    compute_range(view, map, 0.0f, 0.0f, (float)camera->screen_w, (float)camera->screen_h);
+
+    if (!pick_tile(camera, map, tileset, mouse_x, mouse_y, &view->hover_x, &view->hover_y)) {
+        view->hover_x = -1;
+        view->hover_y = -1;
+    }
+
+    view->damage = DAMAGE_FULL;
+    view->prev_hover_x = -1;
+    view->prev_hover_y = -1;
+    view->entities = NULL;
+    view->fog = NULL;
+    view->tints = NULL;
+}
+
+// --- Copy of the view whose tile bounds only cover a screen rectangle ---
+void view_restrict(const View* view, const TileMap* map, const SDL_Rect* rect, View* out) {
+    *out = *view;
+    compute_range(out, map, (float)rect->x, (float)rect->y,
+                  (float)(rect->x + rect->w), (float)(rect->y + rect->h));
+}
+
+// --- Screen rectangle of a tile, edges floored like the tile drawing itself ---
+void view_tile_rect(const View* view, int tile_x, int tile_y, SDL_Rect* rect) {
+    const Camera* cam = &view->camera;
+    int x = (int)floorf((tile_x * view->tile_width + cam->offset_x) * cam->zoom);
+    int y = (int)floorf((tile_y * view->tile_height + cam->offset_y) * cam->zoom);
+    int x2 = (int)floorf(((tile_x + 1) * view->tile_width + cam->offset_x) * cam->zoom);
+    int y2 = (int)floorf(((tile_y + 1) * view->tile_height + cam->offset_y) * cam->zoom);
+    rect->x = x;
+    rect->y = y;
+    rect->w = x2 - x > 0 ? x2 - x : 1;
+    rect->h = y2 - y > 0 ? y2 - y : 1;
+}
+
+// --- Classify the frame against the previous one and record it ---
+void damage_update(DamageTracker* tracker, View* view, const TileMap* map) {
+    const View* last = &tracker->last;
+    const Camera* a = &view->camera;
+    const Camera* b = &last->camera;
+
+    if (!tracker->valid || tracker->map_revision != map->revision ||
+        a->offset_x != b->offset_x || a->offset_y != b->offset_y || a->zoom != b->zoom ||
+        a->screen_w != b->screen_w || a->screen_h != b->screen_h) {
+        view->damage = DAMAGE_FULL;
+    } else if (view->hover_x != last->hover_x || view->hover_y != last->hover_y) {
+        view->damage = DAMAGE_HOVER;
+    } else {
+        view->damage = DAMAGE_NONE;
+    }
+    view->prev_hover_x = last->hover_x;
+    view->prev_hover_y = last->hover_y;
+
+    tracker->last = *view;
+    tracker->map_revision = map->revision;
+    tracker->valid = 1;
+}
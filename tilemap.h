@@ -0,0 +1,243 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Shared core: tileset, map storage, camera, culling, picking and frame stats.
+// Everything here is backend independent; renderers only ever see a View.
+
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <SDL2/SDL.h>
+
+// --- Configuration constants ---
+#define SCREEN_WIDTH 800                  // Initial window width
+#define SCREEN_HEIGHT 600                 // Initial window height
+#define MAP_WIDTH 1000                    // Default tile map width in tiles
+#define MAP_HEIGHT 1000                   // Default tile map height in tiles
+#define TILE_WIDTH 32                     // Width of each tile in pixels
+#define TILE_HEIGHT 32                    // Height of each tile in pixels
+#define LOD_PIXEL_THRESHOLD 8.0f          // Threshold below which LOD kicks in
+#define MAX_ZOOM 16.0f                    // Maximum zoom level
+#define MIN_ZOOM 0.001f                   // Minimum zoom level
+#define ZOOM_STEP 1.1f                    // Zoom in/out factor
+#define MAX_TILESET_CELLS 256             // TileEntry stores grid coordinates in a byte each
+#define TILE_ROW_BITS 5                   // Low bits of TileEntry.sy holding the row; the top 3 hold the transform
+#define TILE_MAX_ROWS (1 << TILE_ROW_BITS)
+#define MAX_LAYERS 8                      // Tile layers per map, drawn bottom to top
+#define MAP_CHUNK_TILES 32                // Side of the map chunks that carry their own edit version
+#define MAP_MAX_LISTENERS 4               // Edit listeners per map (indexes, region labels, ...)
+
+// --- Tile asset metadata; pixels stay on the CPU so each backend can upload its own copy ---
+typedef struct {
+    char* filepath;
+    int tile_width;
+    int tile_height;
+    int rows;
+    int cols;
+    SDL_Surface* surface;        // Decoded pixels in SDL_PIXELFORMAT_RGBA32
+    Uint32* average_colours;     // One RGBA32 colour per tile index, for overview/LOD drawing
+    Uint8* coverage;             // One TileCoverage per tile index
+} Tileset;
+
+// --- Alpha classification of a tileset cell, so compositing can copy or skip whole tiles ---
+typedef enum {
+    TILE_OPAQUE,         // Every pixel has alpha 255
+    TILE_TRANSLUCENT,    // Needs blending
+    TILE_TRANSPARENT     // Every pixel has alpha 0
+} TileCoverage;
+
+typedef struct {
+    Uint8 sx, sy;    // Tileset column, and row | transform << TILE_ROW_BITS (16 bits per map cell)
+} TileEntry;
+
+// Marks an unused cell in the layers above the base; column 255 of row 31 is never loaded
+#define TILE_EMPTY_CELL 255
+
+// --- Draw-time transform bits, applied like Tiled's: diagonal flip (transpose) first, then x, then y.
+// Rotations are combinations: 90 degrees clockwise is DIAGONAL | X, 180 is X | Y, 270 is DIAGONAL | Y ---
+enum {
+    TILE_FLIP_X = 1,
+    TILE_FLIP_Y = 2,
+    TILE_FLIP_DIAGONAL = 4
+};
+#define TILE_TRANSFORMS 8
+
+// Per transform, which tileset cell corner each quad corner samples: quad corners are top-left,
+// top-right, bottom-right, bottom-left, and corner k takes the right edge when bit 2k is set and
+// the bottom edge when bit 2k + 1 is
+extern const Uint8 tile_corner_bits[TILE_TRANSFORMS];
+
+// --- Called by tilemap_set_tile after a tile changed, for structures derived from the map ---
+typedef void (*TileEditFunc)(void* user, int layer, int x, int y, TileEntry old_tile, TileEntry new_tile);
+
+typedef struct {
+    TileEditFunc func;
+    void* user;
+} TileEditListener;
+
+// --- Map storage using a flat array for performance ---
+typedef struct {
+    int width, height;
+    int layers;          // Layer planes stored back to back; layer 0 is the opaque base
+    TileEntry* tiles;    // width * height * layers entries, layer 0 first
+    Uint32 revision;     // Bumped on every edit so cached renderings can tell they are stale
+    int chunks_x, chunks_y;
+    Uint32* chunk_versions;  // Revision of each chunk's last edit, so caches can rebuild only what changed
+    TileEditListener listeners[MAP_MAX_LISTENERS];   // Only see edits made in this process
+    int listener_count;
+} TileMap;
+
+// --- Camera: screen = (world + offset) * zoom ---
+typedef struct {
+    float offset_x, offset_y;
+    float zoom;
+    int screen_w, screen_h;
+} Camera;
+
+// --- What changed since the previous frame (see damage_update) ---
+typedef enum {
+    DAMAGE_FULL,     // Camera, window or map changed: redraw everything
+    DAMAGE_HOVER,    // Only the hovered tile moved: redraw the old and new highlight
+    DAMAGE_NONE      // Nothing changed: the previous frame can be presented again
+} DamageKind;
+
+// --- Everything a backend needs to draw one frame ---
+typedef struct {
+    Camera camera;
+    int tile_width, tile_height;
+    int min_x, min_y, max_x, max_y;   // Visible tile bounds clamped to the map, max exclusive
+    int start_x, start_y;             // min_x/min_y aligned down to the LOD grid
+    int lod;                          // Every lod-th tile is drawn, scaled up lod times
+    int hover_x, hover_y;             // Tile under the cursor, or -1 when outside the map
+    DamageKind damage;                // Always DAMAGE_FULL unless damage tracking is on
+    int prev_hover_x, prev_hover_y;   // Hovered tile of the previous frame for DAMAGE_HOVER
+    const struct EntityLayer* entities;   // Collected sprites the batched GL paths draw over the tiles, or NULL
+    const struct FogMap* fog;             // Fog of war the GL backend draws over the scene, or NULL
+    const struct TintMap* tints;          // Per-tile colours for the GL batched and visset paths, or NULL
+} View;
+
+// --- Remembers the last frame to classify the next one ---
+typedef struct {
+    int valid;
+    View last;
+    Uint32 map_revision;
+} DamageTracker;
+
+// --- Per-frame counters filled in by the backends ---
+typedef struct {
+    int draw_calls;      // API submissions (glBegin/glDrawArrays, SDL_RenderCopy, ...)
+    int tiles_drawn;
+    int entities_drawn;
+    int tiles_built;     // Tiles whose draw data was regenerated this frame
+    int lod;
+    Uint64 bytes_streamed;   // Vertex data handed to the GPU this frame
+    Uint64 vertex_bytes;     // Vertex data read by this frame's draw calls
+    Uint64 vertex_memory;    // Vertex data kept resident between frames (caches, stream buffers)
+    int fence_waits;         // Times the CPU had to wait for the GPU to release a buffer region
+    int state_changes;       // Binds/enables/colour changes passed to the API
+    int state_skipped;       // Redundant ones suppressed by the state cache
+} FrameStats;
+
+// --- Helper: check if integer is power of two ---
+int is_power_of_two(int x);
+
+int load_tileset(Tileset* tileset);
+void free_tileset(Tileset* tileset);
+
+int tilemap_create(TileMap* map, int width, int height, int layers);
+void tilemap_destroy(TileMap* map);
+// The only way to edit a map after filling it: bumps the revision and the chunk's version
+void tilemap_set_tile(TileMap* map, int layer, int x, int y, TileEntry tile);
+int tilemap_add_listener(TileMap* map, TileEditFunc func, void* user);
+void tilemap_remove_listener(TileMap* map, TileEditFunc func, void* user);
+// Whether any chunk overlapping tiles [x0, x1) x [y0, y1) was edited after revision `since`
+int tilemap_region_changed(const TileMap* map, int x0, int y0, int x1, int y1, Uint32 since);
+// Fills the base layer completely and the layers above it sparsely
+void fill_random_tilemap(TileMap* map, int max_tile_index, const Tileset* tileset);
+// Gives every non-empty tile a random flip/rotation
+void fill_random_transforms(TileMap* map);
+
+// --- Deterministic LCG for demo content and benchmarks: steps *seed and returns it; the low bits
+// are weak, so callers take theirs from bit 4 up ---
+static inline unsigned int next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed;
+}
+
+// --- Stateless hash of a grid cell, for random fields that must not depend on visiting order ---
+static inline unsigned int hash_cell(int x, int y, unsigned int seed) {
+    unsigned int h = (unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u ^ seed * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return h ^ (h >> 15);
+}
+
+static inline TileEntry* tilemap_layer(const TileMap* map, int layer) {
+    return map->tiles + (size_t)layer * map->width * map->height;
+}
+
+static inline int tile_is_empty(TileEntry tile) {
+    return tile.sx == TILE_EMPTY_CELL && tile.sy == TILE_EMPTY_CELL;
+}
+
+static inline int tile_row(TileEntry tile) {
+    return tile.sy & (TILE_MAX_ROWS - 1);
+}
+
+static inline int tile_transform(TileEntry tile) {
+    return tile.sy >> TILE_ROW_BITS;
+}
+
+static inline TileEntry tile_make(int col, int row, int transform) {
+    TileEntry tile = { (Uint8)col, (Uint8)(row | transform << TILE_ROW_BITS) };
+    return tile;
+}
+
+// Grid cell without the transform, for tables indexed by tile type (row * MAX_TILESET_CELLS + column)
+static inline int tile_cell(TileEntry tile) {
+    return tile_row(tile) * MAX_TILESET_CELLS + tile.sx;
+}
+
+static inline int tile_index_of(const Tileset* tileset, TileEntry tile) {
+    return tile_row(tile) * tileset->cols + tile.sx;
+}
+
+// Texture coordinates of the four quad corners, transform applied: uv[2k], uv[2k + 1] for corner k
+static inline void tile_quad_uvs(TileEntry tile, float step_u, float step_v, float uv[8]) {
+    unsigned int bits = tile_corner_bits[tile_transform(tile)];
+    float u = tile.sx * step_u, v = tile_row(tile) * step_v;
+    for (int k = 0; k < 4; k++) {
+        uv[2 * k] = u + (float)((bits >> (2 * k)) & 1) * step_u;
+        uv[2 * k + 1] = v + (float)((bits >> (2 * k + 1)) & 1) * step_v;
+    }
+}
+
+void camera_center(Camera* camera, const TileMap* map, const Tileset* tileset);
+void camera_pan(Camera* camera, int dx, int dy);
+void camera_zoom_at(Camera* camera, int mx, int my, float factor);
+
+void view_compute(View* view, const Camera* camera, const TileMap* map, const Tileset* tileset,
+                  int mouse_x, int mouse_y);
+void view_restrict(const View* view, const TileMap* map, const SDL_Rect* rect, View* out);
+void view_tile_rect(const View* view, int tile_x, int tile_y, SDL_Rect* rect);
+void damage_update(DamageTracker* tracker, View* view, const TileMap* map);
+int pick_tile(const Camera* camera, const TileMap* map, const Tileset* tileset,
+              int mx, int my, int* tile_x, int* tile_y);
+
+#endif
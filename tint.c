@@ -0,0 +1,192 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tint.h"
+#include "bench.h"
+#include "visset.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TINT_BENCH_REBUILDS 20
+#define TINT_BENCH_EDITS 10000
+#define TINT_HEAT_CELL 16                // Tiles between the random samples of the heat map
+
+int tint_create(TintMap* tints, int width, int height) {
+    memset(tints, 0, sizeof(*tints));
+    tints->width = width;
+    tints->height = height;
+    tints->chunks_x = (width + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    tints->chunks_y = (height + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+    tints->index = calloc((size_t)width * height, 1);
+    tints->chunk_versions = calloc((size_t)tints->chunks_x * tints->chunks_y, sizeof(Uint32));
+    if (!tints->index || !tints->chunk_versions) {
+        printf("Failed to allocate %dx%d tints\n", width, height);
+        tint_free(tints);
+        return 0;
+    }
+    for (int i = 0; i < TINT_PALETTE_SIZE; i++) tints->palette[i] = TINT_WHITE;
+    return 1;
+}
+
+void tint_free(TintMap* tints) {
+    free(tints->index);
+    free(tints->chunk_versions);
+    tints->index = NULL;
+    tints->chunk_versions = NULL;
+}
+
+void tint_set(TintMap* tints, int x, int y, int index) {
+    if (x < 0 || y < 0 || x >= tints->width || y >= tints->height) return;
+    Uint8* cell = &tints->index[(size_t)y * tints->width + x];
+    if (*cell == (Uint8)index) return;
+    *cell = (Uint8)index;
+    tints->revision++;
+    tints->chunk_versions[(y / MAP_CHUNK_TILES) * tints->chunks_x + x / MAP_CHUNK_TILES] = tints->revision;
+}
+
+void tint_set_palette(TintMap* tints, int index, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    if (index < 0 || index >= TINT_PALETTE_SIZE) return;
+    Uint8* p = (Uint8*)&tints->palette[index];
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+    p[3] = a;
+    tints->revision++;
+    for (int i = 0; i < tints->chunks_x * tints->chunks_y; i++) tints->chunk_versions[i] = tints->revision;
+}
+
+int tint_region_changed(const TintMap* tints, int x0, int y0, int x1, int y1, Uint32 since) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > tints->width) x1 = tints->width;
+    if (y1 > tints->height) y1 = tints->height;
+    if (x0 >= x1 || y0 >= y1) return 0;
+
+    // Revisions wrap, so compare by signed distance
+    for (int cy = y0 / MAP_CHUNK_TILES; cy <= (y1 - 1) / MAP_CHUNK_TILES; cy++) {
+        const Uint32* row = tints->chunk_versions + (size_t)cy * tints->chunks_x;
+        for (int cx = x0 / MAP_CHUNK_TILES; cx <= (x1 - 1) / MAP_CHUNK_TILES; cx++) {
+            if ((Sint32)(row[cx] - since) > 0) return 1;
+        }
+    }
+    return 0;
+}
+
+// --- Heat map: random samples every TINT_HEAT_CELL tiles, bilinearly blended ---
+static unsigned int heat_sample(int x, int y, unsigned int seed) {
+    return hash_cell(x, y, seed) & 0xFFFF;
+}
+
+void tint_fill_heat(TintMap* tints, int levels, unsigned int seed) {
+    if (levels < 1) levels = 1;
+    if (levels > TINT_PALETTE_SIZE - 1) levels = TINT_PALETTE_SIZE - 1;
+
+    // Light colours, since the tint multiplies the tile: cool blue through white to hot red
+    static const int stops[3][3] = { { 128, 160, 255 }, { 255, 255, 255 }, { 255, 128, 96 } };
+    for (int i = 0; i < levels; i++) {
+        int t = levels > 1 ? i * 511 / (levels - 1) : 511;
+        int s = t >> 8, f = t & 255;
+        Uint8 rgb[3];
+        for (int k = 0; k < 3; k++) rgb[k] = (Uint8)(stops[s][k] + (stops[s + 1][k] - stops[s][k]) * f / 255);
+        tint_set_palette(tints, 1 + i, rgb[0], rgb[1], rgb[2], 255);
+    }
+
+    for (int y = 0; y < tints->height; y++) {
+        int gy = y / TINT_HEAT_CELL, fy = y % TINT_HEAT_CELL;
+        for (int x = 0; x < tints->width; x++) {
+            int gx = x / TINT_HEAT_CELL, fx = x % TINT_HEAT_CELL;
+            unsigned int top = heat_sample(gx, gy, seed) * (TINT_HEAT_CELL - fx) + heat_sample(gx + 1, gy, seed) * fx;
+            unsigned int bottom = heat_sample(gx, gy + 1, seed) * (TINT_HEAT_CELL - fx) +
+                                  heat_sample(gx + 1, gy + 1, seed) * fx;
+            unsigned int heat = (top * (TINT_HEAT_CELL - fy) + bottom * fy) / (TINT_HEAT_CELL * TINT_HEAT_CELL);
+            tint_set(tints, x, y, 1 + (int)(heat * (unsigned int)levels >> 16));
+        }
+    }
+}
+
+// --- Benchmark: full visible-set rebuilds of a zoomed-out screen, plain and tinted ---
+// Every in-map cell of the set must carry its tile's palette colour on all four vertices
+static int colours_match(const VisibleSet* set, const TileMap* map, const TintMap* tints) {
+    for (int cy = set->origin_y; cy < set->origin_y + set->rows; cy++) {
+        for (int cx = set->origin_x; cx < set->origin_x + set->cols; cx++) {
+            int tx = cx * set->lod, ty = cy * set->lod;
+            if (tx < 0 || ty < 0 || tx >= map->width || ty >= map->height) continue;
+            int slot = (cy % set->rows + set->rows) % set->rows * set->cols + (cx % set->cols + set->cols) % set->cols;
+            Uint32 want = tint_colour(tints, tx, ty);
+            for (int k = 0; k < 4; k++) {
+                if (set->vertices[slot * 4 + k].colour != want) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+void tint_benchmark(const Tileset* tileset, const TileMap* map) {
+    TintMap tints;
+    if (!tint_create(&tints, map->width, map->height)) return;
+    tint_fill_heat(&tints, 16, 11);
+
+    Camera camera = { 0.0f, 0.0f, 0.25f, SCREEN_WIDTH, SCREEN_HEIGHT };
+    camera_center(&camera, map, tileset);
+    View view;
+    view_compute(&view, &camera, map, tileset, -1, -1);
+
+    printf("Tinted visible set on %dx%d tiles, view of %dx%d tiles, %d-byte vertices, %d rebuilds per run\n",
+           map->width, map->height, view.max_x - view.min_x, view.max_y - view.min_y, (int)sizeof(TileVertex),
+           TINT_BENCH_REBUILDS);
+    printf("%8s %10s %12s %12s\n", "tints", "cells", "rebuild ms", "MB/rebuild");
+    for (int tinted = 0; tinted < 2; tinted++) {
+        VisibleSet set;
+        visset_init(&set);
+        view.tints = tinted ? &tints : NULL;
+        int cells = 0;
+        double rebuild_ms = 0.0;
+        for (int i = 0; i < TINT_BENCH_REBUILDS; i++) {
+            visset_invalidate(&set);
+            Uint64 start = SDL_GetPerformanceCounter();
+            cells = visset_update(&set, &view, map, tileset);
+            rebuild_ms += seconds_since(start) * 1e3;
+        }
+        printf("%8s %10d %12.3f %12.2f%s\n", tinted ? "heat" : "none", cells, rebuild_ms / TINT_BENCH_REBUILDS,
+               (double)cells * 4 * sizeof(TileVertex) / (1024.0 * 1024.0),
+               bench_mismatch(colours_match(&set, map, view.tints)));
+        visset_free(&set);
+    }
+
+    // Edits only mark their chunk; the set notices the ones under the view on its next update
+    unsigned int seed = 13;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < TINT_BENCH_EDITS; i++) {
+        int x = (int)((next_random(&seed) >> 8) % (unsigned int)map->width);
+        int y = (int)((next_random(&seed) >> 8) % (unsigned int)map->height);
+        tint_set(&tints, x, y, 1 + (int)((seed >> 4) % 16));
+    }
+    double edit_ms = seconds_since(start) * 1e3;
+    VisibleSet set;
+    visset_init(&set);
+    view.tints = &tints;
+    visset_update(&set, &view, map, tileset);
+    tint_set(&tints, view.min_x, view.min_y, 1 + (tints.index[(size_t)view.min_y * map->width + view.min_x] % 16));
+    int rebuilt = visset_update(&set, &view, map, tileset);
+    printf("%.3f us per tint edit; an edit under the view rebuilds %d cells%s\n", edit_ms * 1000.0 / TINT_BENCH_EDITS,
+           rebuilt, bench_mismatch(colours_match(&set, map, &tints)));
+    visset_free(&set);
+    tint_free(&tints);
+}
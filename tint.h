@@ -0,0 +1,67 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Per-tile tints for ownership and heat maps. Every tile holds a byte that
+// picks one of 256 palette colours; entry 0 is white and leaves the tile as
+// it is. The batched GL paths resolve the palette while building vertices
+// and carry the colour in the vertex stream, where fixed-function texturing
+// multiplies it with the texel, so any number of tints still goes out in the
+// same draw calls. Edits are versioned per map chunk like the map itself,
+// and a cached visible set only rebuilds the cells of chunks whose tints changed.
+
+#ifndef TINT_H
+#define TINT_H
+
+#include "tilemap.h"
+
+#define TINT_PALETTE_SIZE 256
+#define TINT_NONE 0                      // Palette entry that stays white
+#define TINT_WHITE 0xFFFFFFFFu
+
+typedef struct TintMap {
+    int width, height;
+    Uint8* index;                        // Palette entry of each tile
+    Uint32 palette[TINT_PALETTE_SIZE];   // RGBA bytes in memory order, as glColorPointer reads them
+    Uint32 revision;                     // Bumped on every change
+    int chunks_x, chunks_y;
+    Uint32* chunk_versions;              // Revision of each chunk's last change
+} TintMap;
+
+// Every tile starts at TINT_NONE and every palette entry white
+int tint_create(TintMap* tints, int width, int height);
+void tint_free(TintMap* tints);
+
+void tint_set(TintMap* tints, int x, int y, int index);
+// Changes one palette entry; every chunk counts as changed
+void tint_set_palette(TintMap* tints, int index, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+// Whether any chunk overlapping tiles [x0, x1) x [y0, y1) changed after revision `since`
+int tint_region_changed(const TintMap* tints, int x0, int y0, int x1, int y1, Uint32 since);
+
+// Colour of a tile, white without a tint map
+static inline Uint32 tint_colour(const TintMap* tints, int x, int y) {
+    return tints ? tints->palette[tints->index[(size_t)y * tints->width + x]] : TINT_WHITE;
+}
+
+// A smooth heat map over `levels` (up to 255) palette entries from cool blue to hot red
+void tint_fill_heat(TintMap* tints, int levels, unsigned int seed);
+
+// Prints visible-set rebuild times and vertex bytes with and without tints, and the cost of a tint edit
+void tint_benchmark(const Tileset* tileset, const TileMap* map);
+
+#endif
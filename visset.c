@@ -0,0 +1,197 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "visset.h"
+#include "tint.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+void visset_init(VisibleSet* set) {
+    memset(set, 0, sizeof(*set));
+}
+
+void visset_free(VisibleSet* set) {
+    free(set->vertices);
+    visset_init(set);
+}
+
+void visset_invalidate(VisibleSet* set) {
+    set->valid = 0;
+}
+
+static inline int wrap(int value, int size) {
+    int m = value % size;
+    return m < 0 ? m + size : m;
+}
+
+// --- Write the quad for LOD cell (cx, cy) into its ring slot ---
+static void build_cell(VisibleSet* set, int cx, int cy, const TileMap* map, const Tileset* tileset) {
+    int slot = wrap(cy, set->rows) * set->cols + wrap(cx, set->cols);
+    TileVertex* q = &set->vertices[slot * 4];
+    int tx = cx * set->lod;
+    int ty = cy * set->lod;
+
+    if (tx < 0 || ty < 0 || tx >= map->width || ty >= map->height) {
+        // Outside the map: a degenerate quad rasterises nothing
+        memset(q, 0, sizeof(TileVertex) * 4);
+        return;
+    }
+
+    TileEntry tile = map->tiles[(size_t)ty * map->width + tx];
+    Uint32 colour = tint_colour(set->tints, tx, ty);
+    float uv[8];
+    tile_quad_uvs(tile, 1.0f / tileset->cols, 1.0f / tileset->rows, uv);
+    float x = (float)tx * tileset->tile_width, x2 = x + (float)set->lod * tileset->tile_width;
+    float y = (float)ty * tileset->tile_height, y2 = y + (float)set->lod * tileset->tile_height;
+
+    q[0] = (TileVertex){ x,  y,  uv[0], uv[1], colour };
+    q[1] = (TileVertex){ x2, y,  uv[2], uv[3], colour };
+    q[2] = (TileVertex){ x2, y2, uv[4], uv[5], colour };
+    q[3] = (TileVertex){ x,  y2, uv[6], uv[7], colour };
+}
+
+// --- Regenerate cells [x0, x1) x [y0, y1) ---
+static int build_cells(VisibleSet* set, int x0, int x1, int y0, int y1, const TileMap* map, const Tileset* tileset) {
+    if (x0 >= x1 || y0 >= y1) return 0;
+
+    #pragma omp parallel for schedule(static) if ((x1 - x0) * (y1 - y0) > 1024)
+    for (int cy = y0; cy < y1; cy++) {
+        for (int cx = x0; cx < x1; cx++) {
+            build_cell(set, cx, cy, map, tileset);
+        }
+    }
+    return (x1 - x0) * (y1 - y0);
+}
+
+// --- Regenerate the window's cells that sample a chunk changed after revision `since`; `versions`
+// holds a revision per map chunk, from the map or from tints the size of the map ---
+static int build_edited_cells(VisibleSet* set, const TileMap* map, const Tileset* tileset, const Uint32* versions,
+                              Uint32 since) {
+    int lod = set->lod;
+    int x0 = set->origin_x * lod, y0 = set->origin_y * lod;
+    int x1 = (set->origin_x + set->cols) * lod, y1 = (set->origin_y + set->rows) * lod;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > map->width) x1 = map->width;
+    if (y1 > map->height) y1 = map->height;
+    if (x0 >= x1 || y0 >= y1) return 0;
+
+    int built = 0;
+    for (int chunk_y = y0 / MAP_CHUNK_TILES; chunk_y <= (y1 - 1) / MAP_CHUNK_TILES; chunk_y++) {
+        for (int chunk_x = x0 / MAP_CHUNK_TILES; chunk_x <= (x1 - 1) / MAP_CHUNK_TILES; chunk_x++) {
+            // Revisions wrap, so compare by signed distance
+            if ((Sint32)(versions[(size_t)chunk_y * map->chunks_x + chunk_x] - since) <= 0) continue;
+
+            // Cell c samples tile c * lod, so the chunk's cells are those whose first tile falls inside it
+            int cx0 = (chunk_x * MAP_CHUNK_TILES + lod - 1) / lod;
+            int cy0 = (chunk_y * MAP_CHUNK_TILES + lod - 1) / lod;
+            int cx1 = ((chunk_x + 1) * MAP_CHUNK_TILES + lod - 1) / lod;
+            int cy1 = ((chunk_y + 1) * MAP_CHUNK_TILES + lod - 1) / lod;
+            if (cx0 < set->origin_x) cx0 = set->origin_x;
+            if (cy0 < set->origin_y) cy0 = set->origin_y;
+            if (cx1 > set->origin_x + set->cols) cx1 = set->origin_x + set->cols;
+            if (cy1 > set->origin_y + set->rows) cy1 = set->origin_y + set->rows;
+            built += build_cells(set, cx0, cx1, cy0, cy1, map, tileset);
+        }
+    }
+    return built;
+}
+
+int visset_update(VisibleSet* set, const View* view, const TileMap* map, const Tileset* tileset) {
+    const Camera* cam = &view->camera;
+    int lod = view->lod;
+    float cell_w = (float)tileset->tile_width * lod;
+    float cell_h = (float)tileset->tile_height * lod;
+
+    // The window size only depends on zoom and screen size, so panning never resizes it
+    int cols = (int)ceilf(cam->screen_w / (cell_w * cam->zoom)) + 1;
+    int rows = (int)ceilf(cam->screen_h / (cell_h * cam->zoom)) + 1;
+    int origin_x = (int)floorf(-cam->offset_x / cell_w);
+    int origin_y = (int)floorf(-cam->offset_y / cell_h);
+
+    int dx = origin_x - set->origin_x;
+    int dy = origin_y - set->origin_y;
+
+    // Edits are applied after scrolling, per chunk, against the revision the cells were built from
+    int edited = set->valid && set->revision != map->revision;
+    Uint32 since = set->revision;
+    set->revision = map->revision;
+
+    // Tints are versioned the same way; switching them on or off rebuilds everything
+    const struct TintMap* tints = view->tints;
+    if (tints != set->tints) set->valid = 0;
+    int retinted = set->valid && tints && set->tint_revision != tints->revision;
+    Uint32 tint_since = set->tint_revision;
+    set->tints = tints;
+    set->tint_revision = tints ? tints->revision : 0;
+
+    if (!set->valid || lod != set->lod || cols != set->cols || rows != set->rows ||
+        abs(dx) >= cols || abs(dy) >= rows) {
+        if (cols * rows > set->capacity) {
+            TileVertex* vertices = realloc(set->vertices, sizeof(TileVertex) * 4 * (size_t)cols * rows);
+            if (!vertices) {
+                set->valid = 0;
+                set->cols = set->rows = 0;
+                return 0;
+            }
+            set->vertices = vertices;
+            set->capacity = cols * rows;
+        }
+        set->lod = lod;
+        set->cols = cols;
+        set->rows = rows;
+        set->origin_x = origin_x;
+        set->origin_y = origin_y;
+        set->valid = 1;
+        return build_cells(set, origin_x, origin_x + cols, origin_y, origin_y + rows, map, tileset);
+    }
+
+    set->origin_x = origin_x;
+    set->origin_y = origin_y;
+
+    // Newly exposed rows span the full width; columns then skip the rows already built
+    int built = 0;
+    int row_y0 = origin_y, row_y1 = origin_y;
+    if (dy > 0) {
+        row_y0 = origin_y + rows - dy;
+        row_y1 = origin_y + rows;
+    } else if (dy < 0) {
+        row_y0 = origin_y;
+        row_y1 = origin_y - dy;
+    }
+    built += build_cells(set, origin_x, origin_x + cols, row_y0, row_y1, map, tileset);
+
+    int col_x0 = origin_x, col_x1 = origin_x;
+    if (dx > 0) {
+        col_x0 = origin_x + cols - dx;
+        col_x1 = origin_x + cols;
+    } else if (dx < 0) {
+        col_x0 = origin_x;
+        col_x1 = origin_x - dx;
+    }
+    int rest_y0 = dy > 0 ? origin_y : row_y1;
+    int rest_y1 = dy > 0 ? row_y0 : origin_y + rows;
+    built += build_cells(set, col_x0, col_x1, rest_y0, rest_y1, map, tileset);
+
+    // Cells that just scrolled in are current already; rebuilding them again is harmless
+    if (edited) built += build_edited_cells(set, map, tileset, map->chunk_versions, since);
+    if (retinted) built += build_edited_cells(set, map, tileset, tints->chunk_versions, tint_since);
+    return built;
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the Tilemap SDL/OpenGL tech demo.
+ *
+ * Copyright (C) 2025 Cannister of Sparrows <cannister_of_sparrows@proton.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Persistent visible set. Holds world-space quads for a fixed-size window of
+// LOD cells around the camera, addressed as a ring (cell x maps to slot
+// x mod cols) so that panning by a few cells only regenerates the rows and
+// columns that scrolled into view. The camera transform is applied at draw
+// time, so sub-tile movement costs nothing at all. A view with tints (tint.h)
+// bakes each tile's colour into its vertices.
+
+#ifndef VISSET_H
+#define VISSET_H
+
+#include "tilemap.h"
+
+// --- Vertex layout shared by the batched paths ---
+typedef struct {
+    float x, y;      // World position in pixels
+    float u, v;      // Tileset texture coordinates
+    Uint32 colour;   // RGBA bytes multiplied with the texel; TINT_WHITE when untinted
+} TileVertex;
+
+typedef struct {
+    int valid;
+    int lod;
+    int cols, rows;              // Ring size in LOD cells
+    int origin_x, origin_y;      // First LOD cell held, in LOD cell units
+    Uint32 revision;             // Map revision the cells were built from
+    const struct TintMap* tints; // Tints the cells were built with, the size of the map, or NULL
+    Uint32 tint_revision;
+    int capacity;                // Allocated cells
+    TileVertex* vertices;        // 4 vertices per cell, cells stored row-major by slot
+} VisibleSet;
+
+void visset_init(VisibleSet* set);
+void visset_free(VisibleSet* set);
+void visset_invalidate(VisibleSet* set);
+
+// Bring the set in line with the view and its tints; returns the number of cells regenerated
+int visset_update(VisibleSet* set, const View* view, const TileMap* map, const Tileset* tileset);
+
+static inline int visset_vertex_count(const VisibleSet* set) {
+    return set->cols * set->rows * 4;
+}
+
+#endif